@@ -37,6 +37,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 	void rankdf_noscale(CPX *_A, CPX *_B, MIX *_W, int32 _nblocks, int32 _bsize)  __attribute__ ((noinline));
 #endif
 
+void rankr(CPX *_x, MIX *_W, int32 _r, int32 _nblocks, int32 _bsize, bool _scale);
+
 FFT::FFT()
 {
 
@@ -53,17 +55,12 @@ FFT::FFT(int32 _N)
 		R[lcv] = 1;
 
 	N = _N;
-	M = 0;
 
-	/* Get the number of ranks */
-	while(_N > 1)
-	{
-		M++;
-		_N >>= 1;
-	}
+	/* Get the ranks */
+	initP();
 
-	W = (MIX *)malloc(N/2*sizeof(MIX));  	// Forward twiddle lookup
-	iW = (MIX *)malloc(N/2*sizeof(MIX)); 	// Inverse twiddle lookup
+	W = (MIX *)malloc(N*sizeof(MIX));  		// Forward twiddle lookup
+	iW = (MIX *)malloc(N*sizeof(MIX)); 		// Inverse twiddle lookup
 	BR  = (int32 *)malloc(N*sizeof(int32)); 	// Bit reverse lookup
 	BRX  = (int32 *)malloc(N*sizeof(CPX)); 	// Shuffle temp array
 
@@ -82,17 +79,12 @@ FFT::FFT(int32 _N, int32 _R[MAX_RANKS])
 		R[lcv] = _R[lcv];
 
 	N = _N;
-	M = 0;
 
-	/* Get the number of ranks */
-	while(_N > 1)
-	{
-		M++;
-		_N >>= 1;
-	}
+	/* Get the ranks */
+	initP();
 
-	W = (MIX *)malloc(N/2*sizeof(MIX));  	// Forward twiddle lookup
-	iW = (MIX *)malloc(N/2*sizeof(MIX)); 	// Inverse twiddle lookup
+	W = (MIX *)malloc(N*sizeof(MIX));  		// Forward twiddle lookup
+	iW = (MIX *)malloc(N*sizeof(MIX)); 		// Inverse twiddle lookup
 	BR  = (int32 *)malloc(N*sizeof(int32)); 	// Bit reverse lookup
 	BRX  = (int32 *)malloc(N*sizeof(CPX)); 	// Shuffle temp array
 
@@ -102,6 +94,74 @@ FFT::FFT(int32 _N, int32 _R[MAX_RANKS])
 }
 
 
+/*!
+ * Scale the ranks from the last one back until the ones left unscaled multiply to at most _gain,
+ * the others are unscaled. For lengths whose ranks differ from a power of 2's, where a fixed R[]
+ * would not say the same thing.
+ */
+void FFT::setGain(int32 _gain)
+{
+
+	int32 lcv, gain;
+
+	gain = N;
+	for(lcv = M-1; lcv >= 0; lcv--)
+	{
+		R[lcv] = (gain > _gain) ? 1 : 0;
+		if(R[lcv])
+			gain /= P[lcv];
+	}
+
+}
+
+
+/*!
+ * The lengths initP() can factor into ranks: even, no prime factor other than 2, 3 & 5, and no
+ * more than MAX_RANKS of them.
+ */
+bool FFT::Length(int32 _N)
+{
+
+	int32 n, ranks, lcv;
+	int32 radix[3] = {2, 3, 5};
+
+	if((_N < 2) || (_N % 2))
+		return(false);
+
+	n = _N;
+	ranks = 0;
+	for(lcv = 0; lcv < 3; lcv++)
+		while((n % radix[lcv]) == 0)
+		{
+			ranks++;
+			n /= radix[lcv];
+		}
+
+	return((n == 1) && (ranks <= MAX_RANKS));
+
+}
+
+
+/*!
+ * The rank layout, for anything that caches the output of the FFT (Acquisition::WriteCodes())
+ * and has to know whether it still matches. Ranks past M are zero.
+ */
+int32 FFT::getRanks(int32 _P[MAX_RANKS], int32 _R[MAX_RANKS])
+{
+
+	int32 lcv;
+
+	for(lcv = 0; lcv < MAX_RANKS; lcv++)
+	{
+		_P[lcv] = (lcv < M) ? P[lcv] : 0;
+		_R[lcv] = (lcv < M) ? R[lcv] : 0;
+	}
+
+	return(M);
+
+}
+
+
 FFT::~FFT()
 {
 	free(BRX);
@@ -110,6 +170,54 @@ FFT::~FFT()
 	free(iW);
 }
 
+/*!
+ * One 2 first, doMulRank() wants the first rank radix 2, then the 3s & 5s, then the rest of the
+ * 2s, so for N with at least two 2s doPowRank() gets a radix 2 last rank too. A power of 2 comes
+ * out all 2s, as it always did.
+ */
+void FFT::initP()
+{
+
+	int32 n, twos, lcv;
+
+	/* Any other factor would leave ranks out, an odd N has no radix 2 rank for doMulRank() */
+	if(!Length(N))
+	{
+		fprintf(stderr, "FFT: %d points is not an even 2^a 3^b 5^c of at most %d ranks\n", N, MAX_RANKS);
+		exit(1);
+	}
+
+	n = N;
+	twos = 0;
+	while((n % 2) == 0)
+	{
+		twos++;
+		n /= 2;
+	}
+
+	M = 0;
+
+	if(twos)
+		P[M++] = 2;
+
+	while((n % 3) == 0)
+	{
+		P[M++] = 3;
+		n /= 3;
+	}
+
+	while((n % 5) == 0)
+	{
+		P[M++] = 5;
+		n /= 5;
+	}
+
+	for(lcv = 1; lcv < twos; lcv++)
+		P[M++] = 2;
+
+}
+
+
 void FFT::initW()
 {
 
@@ -117,7 +225,8 @@ void FFT::initW()
 	double s, c, phase;
     const double pi = 3.14159265358979323846264338327;
 
-	for(lcv = 0; lcv < N/2; lcv++)
+	/* The whole circle, radix 3 & 5 ranks reach past N/2 */
+	for(lcv = 0; lcv < N; lcv++)
 	{
 		//Forward twiddles
 		phase = (-2*pi*lcv)/N;
@@ -141,23 +250,30 @@ void FFT::initW()
 
 
 
+/*!
+ * Digit reversal, bit reversal for a power of 2. Input n = d[M-1] + P[M-1]*(d[M-2] + P[M-2]*(...)),
+ * the digit of the last rank the lowest, goes to the position where the digit of the first rank
+ * is the lowest. BR[position] = n.
+ */
 void FFT::initBR()
 {
-	int lcv, lcv2, index;
+	int32 lcv, lcv2, n, pos, stride;
 
 	for(lcv = 0; lcv < N; lcv++)
 	{
-		index = 0;
-		for(lcv2 = 0; lcv2 < M; lcv2++)
+		n = lcv;
+		pos = 0;
+		stride = N;
+		for(lcv2 = M-1; lcv2 >= 0; lcv2--)
 		{
-			index += ((lcv >> lcv2) & 0x1);
-			index <<= 1;
+			stride /= P[lcv2];
+			pos += (n % P[lcv2])*stride;
+			n /= P[lcv2];
 		}
-		index >>= 1;
 
-		BR[lcv] = index;
+		BR[pos] = lcv;
 
-//		printf("BR:%d\n",BR[lcv]);
+//		printf("BR:%d\n",BR[pos]);
 	}
 
 }
@@ -165,60 +281,51 @@ void FFT::initBR()
 void FFT::doFFT(CPX *_x, bool _shuf)
 {
 
-	int32 lcv, nblocks, bsize;
-	CPX *a, *b;
-	MIX *w;
-
 	if(_shuf)
-		doShuffle(_x);	//bit reverse the array
+		doShuffle(_x);	//digit reverse the array
 
-	bsize = 1;
-	nblocks = N >> 1;
+	doRanks(_x, W, 0, M);
 
-	for(lcv = 0; lcv < M; lcv++)					//Loop over M ranks
-	{
-		a = _x;
-		b = _x + bsize;
-		w = W;
+}
 
-		if(R[lcv])
-			rank(a, b, w, nblocks, bsize);
-		else
-			rank_noscale(a, b, w, nblocks, bsize);
 
-		bsize <<= 1;
-		nblocks >>= 1;
-	}
+void FFT::doiFFT(CPX *_x, bool _shuf)
+{
+
+	if(_shuf)
+		doShuffle(_x);	//digit reverse the array
+
+	doRanks(_x, iW, 0, M);
+
 }
 
 
-void FFT::doiFFT(CPX *_x, bool _shuf)
+/*!
+ * Ranks _first.._last-1 with twiddles _w. Going into rank lcv the array is blocks of bsize, the
+ * product of the radices before it, each already transformed, and the rank merges every P[lcv]
+ * of them. Radix 2 ranks are the original rank() & rank_noscale().
+ */
+void FFT::doRanks(CPX *_x, MIX *_w, int32 _first, int32 _last)
 {
 
 	int32 lcv, nblocks, bsize;
-	CPX *a, *b;
-	MIX *w;
-
-	if(_shuf)
-		doShuffle(_x);	//bit reverse the array
 
 	bsize = 1;
-	nblocks = N >> 1;
+	for(lcv = 0; lcv < _first; lcv++)
+		bsize *= P[lcv];
 
-	for(lcv = 0; lcv < M; lcv++)					//Loop over M ranks
+	for(lcv = _first; lcv < _last; lcv++)			//Loop over the ranks
 	{
-		a = _x;
-		b = _x + bsize;
-		w = iW;
+		nblocks = N/(bsize*P[lcv]);
 
-		if(R[lcv])
-			rank(a, b, w, nblocks, bsize);
+		if(P[lcv] != 2)
+			rankr(_x, _w, P[lcv], nblocks, bsize, R[lcv] != 0);
+		else if(R[lcv])
+			rank(_x, _x + bsize, _w, nblocks, bsize);
 		else
-			rank_noscale(a, b, w, nblocks, bsize);
-
+			rank_noscale(_x, _x + bsize, _w, nblocks, bsize);
 
-		bsize <<= 1;
-		nblocks >>= 1;
+		bsize *= P[lcv];
 	}
 
 }
@@ -301,6 +408,211 @@ void FFT::doShuffle(CPX *_x)
 }
 
 
+/*!
+ * doiFFTmul: _x = iFFT of the N bins times _code, each product rounded down _shift bits as
+ * x86_cmulsc() does, the same as x86_cmulsc() into _x then doiFFT(_x, true). Bins 0..N/2-1 are
+ * read from _lo and bins N/2..N-1 from _hi, so the middle of a longer spectrum can be left out
+ * (see Acquisition::doCorr()), neither may overlap _x. N must be even. The multiply and the
+ * shuffle are done in the first rank, the data is then read once, not three times.
+ */
+void FFT::doiFFTmul(CPX *_lo, CPX *_hi, CPX *_code, int32 _shift, CPX *_x)
+{
+
+	doMulRank(_lo, _hi, _code, _shift, _x);
+	doRanks(_x, iW, 1, M);
+
+}
+
+
+/*!
+ * doiFFTpow: doiFFTmul() with the last rank also taking the power of each output, as x86_cmag()
+ * does, so _x comes back as N int32 powers. _max gets the largest and _sum their total, what
+ * a search needs to know whether any of them could be a peak before it looks for one.
+ */
+void FFT::doiFFTpow(CPX *_lo, CPX *_hi, CPX *_code, int32 _shift, CPX *_x, int32 *_max, int64 *_sum)
+{
+
+	int32 lcv, max;
+	int32 *p = (int32 *)_x;
+	int64 sum;
+
+	doMulRank(_lo, _hi, _code, _shift, _x);
+
+	if(P[M-1] == 2)
+	{
+		doRanks(_x, iW, 1, M-1);
+		doPowRank(_x, _max, _sum);
+		return;
+	}
+
+	/* Only one 2 in N, the powers take a pass of their own */
+	doRanks(_x, iW, 1, M);
+
+	max = 0;
+	sum = 0;
+	for(lcv = 0; lcv < N; lcv++)
+	{
+		p[lcv] = _x[lcv].i*_x[lcv].i + _x[lcv].q*_x[lcv].q;
+		max = (p[lcv] > max) ? p[lcv] : max;
+		sum += p[lcv];
+	}
+
+	*_max = max;
+	*_sum = sum;
+
+}
+
+
+/*!
+ * The first rank of doiFFTmul(). After the shuffle its butterflies pair bins BR[2k] and
+ * BR[2k]+N/2, one from _lo and one from _hi, and their twiddle is 1, so each output pair is the
+ * sum and the difference of two products. bfly()'s arithmetic, the branch on R[0] is a shift.
+ */
+void FFT::doMulRank(CPX *_lo, CPX *_hi, CPX *_code, int32 _shift, CPX *_x)
+{
+
+	int32 lcv, j, s, round;
+	int32 ai, aq, bi, bq;
+	CPX *hcode = _code + (N >> 1);
+
+	s = R[0] ? 1 : 0;
+	round = 1 << (_shift-1);
+
+	for(lcv = 0; lcv < (N >> 1); lcv++)
+	{
+		j = BR[2*lcv];
+
+		ai = (int16)((_lo[j].i*_code[j].i - _lo[j].q*_code[j].q + round) >> _shift);
+		aq = (int16)((_lo[j].i*_code[j].q + _lo[j].q*_code[j].i + round) >> _shift);
+		bi = (int16)((_hi[j].i*hcode[j].i - _hi[j].q*hcode[j].q + round) >> _shift);
+		bq = (int16)((_hi[j].i*hcode[j].q + _hi[j].q*hcode[j].i + round) >> _shift);
+
+		ai >>= s; aq >>= s;
+		bi >>= s; bq >>= s;
+
+		_x[2*lcv].i = (int16)(ai + bi);
+		_x[2*lcv].q = (int16)(aq + bq);
+		_x[2*lcv+1].i = (int16)(ai - bi);
+		_x[2*lcv+1].q = (int16)(aq - bq);
+	}
+
+}
+
+
+/*!
+ * The last rank of doiFFTpow(), one block of N/2 butterflies of bfly()'s arithmetic. Each output
+ * is squared where it is made and written back over its own slot, with no branch in the loop.
+ */
+void FFT::doPowRank(CPX *_x, int32 *_max, int64 *_sum)
+{
+
+	int32 lcv, s, h, max;
+	int32 ai, aq, bi, bq, ti, tq, oi, oq, pa, pb;
+	int32 *p = (int32 *)_x;
+	int64 sum;
+
+	s = R[M-1] ? 1 : 0;
+	h = N >> 1;
+	max = 0;
+	sum = 0;
+
+	for(lcv = 0; lcv < h; lcv++)
+	{
+		ai = _x[lcv].i >> s;
+		aq = _x[lcv].q >> s;
+		bi = _x[lcv+h].i >> s;
+		bq = _x[lcv+h].q >> s;
+
+		ti = (bi*iW[lcv].i - bq*iW[lcv].q + 8192) >> 14;
+		tq = (bi*iW[lcv].q + bq*iW[lcv].i + 8192) >> 14;
+
+		oi = (int16)(ai + (int16)ti);
+		oq = (int16)(aq + (int16)tq);
+		pa = oi*oi + oq*oq;
+
+		oi = (int16)(ai - (int16)ti);
+		oq = (int16)(aq - (int16)tq);
+		pb = oi*oi + oq*oq;
+
+		p[lcv] = pa;
+		p[lcv+h] = pb;
+
+		max = (pa > max) ? pa : max;
+		max = (pb > max) ? pb : max;
+		sum += pa;
+		sum += pb;
+	}
+
+	*_max = max;
+	*_sum = sum;
+
+}
+
+
+/*!
+ * One radix _r (3 or 5) rank of _nblocks blocks, each merging _r transforms of _bsize points. In
+ * every butterfly the inputs _bsize apart are twiddled by W^(j*q*_nblocks), then go through an
+ * _r point DFT whose twiddles are W^(q*k*N/_r), N = _nblocks*_bsize*_r. Same Q14 rounding as
+ * bfly(), with _scale each twiddled input is also multiplied by 1/_r before the DFT, so like a
+ * scaled radix 2 rank the outputs cannot grow. The DFT sums are 64 bit, up to five Q14 products.
+ */
+void rankr(CPX *_x, MIX *_W, int32 _r, int32 _nblocks, int32 _bsize, bool _scale)
+{
+
+	int32 lcv, lcv2, q, k, recip;
+	int32 bi[5], bq[5];
+	int64 si, sq;
+	MIX d[5][5];
+	CPX *x;
+	MIX *w;
+
+	recip = (16384 + _r/2)/_r;
+
+	/* The _r point DFT's twiddles, W^(q*k*N/_r) */
+	for(q = 0; q < _r; q++)
+		for(k = 0; k < _r; k++)
+			d[k][q] = _W[((q*k) % _r)*_nblocks*_bsize];
+
+	for(lcv = 0; lcv < _nblocks; lcv++)
+	{
+		x = _x + lcv*_bsize*_r;
+
+		for(lcv2 = 0; lcv2 < _bsize; lcv2++)
+		{
+			/* Twiddle the inputs, j*q*_nblocks < N */
+			for(q = 0; q < _r; q++)
+			{
+				w = &_W[lcv2*q*_nblocks];
+				bi[q] = (x[lcv2 + q*_bsize].i*w->i - x[lcv2 + q*_bsize].q*w->q + 8192) >> 14;
+				bq[q] = (x[lcv2 + q*_bsize].i*w->q + x[lcv2 + q*_bsize].q*w->i + 8192) >> 14;
+
+				if(_scale)
+				{
+					bi[q] = (bi[q]*recip + 8192) >> 14;
+					bq[q] = (bq[q]*recip + 8192) >> 14;
+				}
+			}
+
+			/* And the _r point DFT of them */
+			for(k = 0; k < _r; k++)
+			{
+				si = 0;
+				sq = 0;
+				for(q = 0; q < _r; q++)
+				{
+					si += (int64)bi[q]*d[k][q].i - (int64)bq[q]*d[k][q].q;
+					sq += (int64)bi[q]*d[k][q].q + (int64)bq[q]*d[k][q].i;
+				}
+
+				x[lcv2 + k*_bsize].i = (int16)((si + 8192) >> 14);
+				x[lcv2 + k*_bsize].q = (int16)((sq + 8192) >> 14);
+			}
+		}
+	}
+
+}
+
+
 #ifdef NO_SIMD  /* Include the cPP FFT Functions */
 
 void rank(CPX *_A, CPX *_B, MIX *_W, int32 _nblocks, int32 _bsize)
@@ -23,7 +23,9 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #define MAX_RANKS (16)
 
 /*! \ingroup CLASSES
- * 
+ * Fixed point FFT of any N = 2^a 3^b 5^c. Each rank is a radix 2, 3 or 5 decimation in time
+ * pass, R[] says which of them scale their outputs down by their radix. A power of 2 runs the
+ * radix 2 ranks only, the decimate in frequency versions are for powers of 2 only.
  */
 typedef class FFT
 {
@@ -36,24 +38,34 @@ typedef class FFT
 		int32 *BRX;					//!< Re-order temp array
 		int32 *BR;					//!< Re-order index array
 		
-		int32 N;					//!< Length (should be 2^N!!!)
-		int32 M;					//!< Log2(N) (number of ranks)
+		int32 N;					//!< Length, 2^a 3^b 5^c
+		int32 M;					//!< Number of ranks, Log2(N) for a power of 2
 		int32 R[16];				//!< Programmable rank scaling
+		int32 P[MAX_RANKS];			//!< Radix of each rank
 
+		void initP();				//!< Factor N into the ranks
 		void initW();				//!< Initialize twiddles
 		void initBR();				//!< Initialize re-order array
+		void doRanks(CPX *_x, MIX *_w, int32 _first, int32 _last);				//!< Decimate in time ranks _first.._last-1
 		void doShuffle(CPX *_x);	//!< Do bit-reverse shuffling
+		void doMulRank(CPX *_lo, CPX *_hi, CPX *_code, int32 _shift, CPX *_x);	//!< Multiply, shuffle & first rank of doiFFTmul()
+		void doPowRank(CPX *_x, int32 *_max, int64 *_sum);						//!< Last rank of doiFFTpow()
 
 	public:
 
 		FFT();								//!< Initialize FFT
-		FFT(int32 _N);						//!< Initialize FFT for 2^N
-		FFT(int32 _N, int32 _R[MAX_RANKS]);			//!< Initialize FFT for 2^N, with ranks
+		FFT(int32 _N);						//!< Initialize FFT for N = 2^a 3^b 5^c
+		FFT(int32 _N, int32 _R[MAX_RANKS]);			//!< Initialize FFT for N = 2^a 3^b 5^c, with ranks
 		~FFT();								//!< Destructor
 		void doFFT(CPX *_x, bool _shuf);	//!< Forward FFT, decimate in time
 		void doiFFT(CPX *_x, bool _shuf);	//!< Inverse FFT, decimate in time
 		void doFFTdf(CPX *_x, bool _shuf);	//!< Forward FFT, decimate in frequency
 		void doiFFTdf(CPX *_x, bool _shuf);	//!< Inverse FFT, decimate in frequency
+		static bool Length(int32 _N);		//!< Whether _N is a length the FFT takes
+		void setGain(int32 _gain);			//!< Scale the last ranks so the rest grow the data by at most _gain
+		int32 getRanks(int32 _P[MAX_RANKS], int32 _R[MAX_RANKS]);	//!< Copy out the radix & scaling of each rank, returns the number of ranks
+		void doiFFTmul(CPX *_lo, CPX *_hi, CPX *_code, int32 _shift, CPX *_x);					//!< iFFT of the bins times _code, into _x
+		void doiFFTpow(CPX *_lo, CPX *_hi, CPX *_code, int32 _shift, CPX *_x, int32 *_max, int64 *_sum);	//!< Same, ending in the powers, their max & total
 
 } FFT;
 
@@ -0,0 +1,138 @@
+/*! \file histogram.cpp
+	Implements member functions of Histogram class.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#include "includes.h"
+
+/*----------------------------------------------------------------------------------------------*/
+void Histogram::Clear()
+{
+	memset(bins, 0x0, sizeof(bins));
+	count = 0;
+	sum = 0;
+	max = 0;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Bucket: values below HIST_SUB get their own bucket, above that each power of two
+ * is split into HIST_SUB linear buckets using the bits just below the MSB
+ * */
+int32 Histogram::Bucket(uint64 _ns)
+{
+	int32 msb;
+	int32 shift;
+	int32 bucket;
+
+	if(_ns < HIST_SUB)
+		return((int32)_ns);
+
+	msb = 63 - __builtin_clzll(_ns);
+	shift = msb - HIST_SUB_BITS;
+	bucket = ((shift + 1) << HIST_SUB_BITS) + (int32)((_ns >> shift) & (HIST_SUB - 1));
+
+	if(bucket >= HIST_BUCKETS)
+		bucket = HIST_BUCKETS - 1;
+
+	return(bucket);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+uint64 Histogram::Value(int32 _bucket)
+{
+	int32 shift;
+	uint64 sub;
+
+	if(_bucket < HIST_SUB)
+		return((uint64)_bucket);
+
+	shift = (_bucket >> HIST_SUB_BITS) - 1;
+	sub = (uint64)(_bucket & (HIST_SUB - 1));
+
+	return(((HIST_SUB + sub) << shift) + (1ULL << shift) - 1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Histogram::Add(uint64 _ns)
+{
+	bins[Bucket(_ns)]++;
+	count++;
+	sum += _ns;
+
+	if(_ns > max)
+		max = _ns;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+uint64 Histogram::Percentile(double _p)
+{
+	int32 lcv;
+	uint64 target;
+	uint64 total;
+	uint64 value;
+
+	if(count == 0)
+		return(0);
+
+	target = (uint64)ceil((double)count * _p / 100.0);
+	if(target < 1)
+		target = 1;
+
+	total = 0;
+	for(lcv = 0; lcv < HIST_BUCKETS; lcv++)
+	{
+		total += bins[lcv];
+		if(total >= target)
+			break;
+	}
+
+	/* Never report beyond the largest sample actually seen */
+	value = Value(lcv);
+	if(value > max)
+		value = max;
+
+	return(value);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Histogram::Print(FILE *_fp, const char *_name)
+{
+	fprintf(_fp, "%-12s %10llu %10llu %10llu %10llu %10llu %10llu %10llu\n",
+		_name,
+		count,
+		GetMean(),
+		Percentile(50.0),
+		Percentile(90.0),
+		Percentile(99.0),
+		Percentile(99.9),
+		max);
+}
+/*----------------------------------------------------------------------------------------------*/
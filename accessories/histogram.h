@@ -0,0 +1,62 @@
+/*! \file histogram.h
+	Defines the class Histogram
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#define HIST_SUB_BITS	(3)								//!< 2^3 sub-buckets per power of two, ~12% resolution
+#define HIST_SUB		(1 << HIST_SUB_BITS)			//!< Sub-buckets per power of two
+#define HIST_OCTAVES	(40)							//!< Covers up to 2^40 ns (~18 minutes)
+#define HIST_BUCKETS	(HIST_OCTAVES*HIST_SUB)			//!< Total number of buckets
+
+/*! \ingroup CLASSES
+ * Log-linear (HDR style) histogram of nanosecond durations. Add() is O(1) and the
+ * memory is fixed, so it can be fed from a realtime thread. There is no constructor,
+ * call Clear() before use.
+ */
+typedef class Histogram
+{
+
+	private:
+
+		uint32 bins[HIST_BUCKETS];	//!< Bucket counts
+		uint64 count;				//!< Number of samples
+		uint64 sum;					//!< Sum of all samples (ns)
+		uint64 max;					//!< Largest sample (ns)
+
+		int32 Bucket(uint64 _ns);	//!< Value to bucket index
+		uint64 Value(int32 _bucket);//!< Bucket index to the highest value it holds
+
+	public:
+
+		void Clear();								//!< Reset all counts
+		void Add(uint64 _ns);						//!< Add a sample
+		uint64 Percentile(double _p);				//!< Get the given percentile (0-100)
+		uint64 GetCount(){return(count);};			//!< Number of samples
+		uint64 GetMax(){return(max);};				//!< Largest sample
+		uint64 GetSum(){return(sum);};				//!< Sum of the samples
+		uint64 GetMean(){return(count ? sum/count : 0);};	//!< Mean of the samples
+		void Print(FILE *_fp, const char *_name);	//!< Dump count/mean/p50/p90/p99/p99.9/max as text
+
+} Histogram;
+
+#endif /*HISTOGRAM_H_*/
@@ -0,0 +1,314 @@
+/*! \file IF-Gen.cpp
+	Simulate the L1 C/A IF, either to a file or straight into the receiver's pipe
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#define GLOBALS_HERE
+
+#include "includes.h"
+
+#define IF_GEN_BLOCK_MS		(100)		//!< ms generated per call to Signal_Gen::Generate()
+
+/*! \ingroup STRUCTS
+ * Options for the IF generator
+ */
+typedef struct _IF_Gen_Options
+{
+	double seconds;			//!< Seconds of IF to generate, 0 runs until the reader goes away
+	double tow;				//!< GPS second of week of the first sample, < 0 picks one from the ephemeris
+	double lat;				//!< Receiver latitude (deg)
+	double lon;				//!< Receiver longitude (deg)
+	double alt;				//!< Receiver altitude (m)
+	double cn0;				//!< C/N0 of every SV (dB-Hz)
+	double mask;			//!< Elevation mask (deg)
+	double sigma;			//!< Noise sigma, 0 turns it off
+	int32 svs;				//!< Number of fixed Doppler SVs when there is no ephemeris
+	int32 week;				//!< GPS week, < 0 takes it from the ephemeris
+	int32 threads;			//!< Worker threads
+	int32 nav;				//!< Modulate the navigation message
+	uint32 seed;			//!< Noise seed
+	char ephem[1024];		//!< Ephemeris file, as written by Ephemeris::WriteEphemeris()
+	char filename[1024];	//!< Output file, empty writes to /tmp/GPSPIPE
+} IF_Gen_Options;
+
+/*----------------------------------------------------------------------------------------------*/
+void gen_usage(char *_str)
+{
+
+    fprintf(stderr, "usage: [-o] [-t] [-e] [-p] [-w] [-s] [-c] [-n] [-m] [-j] [-q] [-b] [-r]\n");
+    fprintf(stderr, "[-o] <filename> write to a file (default is the /tmp/GPSPIPE named pipe)\n");
+    fprintf(stderr, "[-t] <seconds> length of the IF (default 60 s to a file, forever to the pipe)\n");
+    fprintf(stderr, "[-e] <filename> ephemeris file (current.eph), delay & Doppler come from the orbits\n");
+    fprintf(stderr, "[-p] <lat> <lon> <alt> receiver position (deg, deg, m)\n");
+    fprintf(stderr, "[-w] <week> GPS week (default from the ephemeris)\n");
+    fprintf(stderr, "[-s] <seconds> GPS second of week of the first sample (default from the ephemeris)\n");
+    fprintf(stderr, "[-c] <dB-Hz> C/N0 of every SV (default 45)\n");
+    fprintf(stderr, "[-n] <N> number of fixed Doppler SVs when there is no ephemeris (default 8)\n");
+    fprintf(stderr, "[-m] <deg> elevation mask (default 5)\n");
+    fprintf(stderr, "[-j] <N> worker threads (default number of CPUs)\n");
+    fprintf(stderr, "[-q] <sigma> noise sigma, 0 turns the noise off (default %.0f)\n", SGEN_NOISE_SIGMA);
+    fprintf(stderr, "[-b] no navigation message\n");
+    fprintf(stderr, "[-r] <seed> noise seed\n");
+    fflush(stderr);
+
+    exit(1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Add every healthy SV above the mask */
+int32 gen_ephemeris(IF_Gen_Options *_opt, Signal_Gen *_gen)
+{
+	Ephemeris_M ephem[NUM_CODES];
+	FILE *fp;
+	int32 lcv, nread;
+	double elev;
+
+	fp = fopen(_opt->ephem, "rb");
+	if(fp == NULL)
+	{
+		printf("Could not open %s for reading\n", _opt->ephem);
+		return(false);
+	}
+
+	memset(ephem, 0x0, sizeof(ephem));
+	nread = fread(&ephem[0], sizeof(Ephemeris_M), NUM_CODES, fp);
+	fclose(fp);
+
+	/* Default to the first toe in the file */
+	for(lcv = 0; lcv < nread; lcv++)
+	{
+		if(ephem[lcv].valid)
+		{
+			if(_opt->tow < 0)
+				_opt->tow = ephem[lcv].toe;
+			if(_opt->week < 0)
+				_opt->week = ephem[lcv].week_number;
+			break;
+		}
+	}
+
+	if(lcv == nread)
+	{
+		printf("No valid ephemerides in %s\n", _opt->ephem);
+		return(false);
+	}
+
+	_gen->SetTime(_opt->week, _opt->tow);
+
+	for(lcv = 0; lcv < nread; lcv++)
+	{
+		if(ephem[lcv].valid)
+		{
+			elev = _gen->Elevation(&ephem[lcv]);
+			if(elev > _opt->mask)
+			{
+				_gen->AddSV(lcv, _opt->cn0, &ephem[lcv]);
+				fprintf(stderr, "SV %02d elevation %5.1f deg\n", lcv+1, elev);
+			}
+		}
+	}
+
+	return(true);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Write all of it, returns false once the reader has gone away */
+int32 gen_write(int32 _fd, char *_buff, int32 _bytes)
+{
+	int32 nbytes, bwrite;
+
+	nbytes = 0;
+	while(nbytes < _bytes)
+	{
+		bwrite = write(_fd, &_buff[nbytes], _bytes - nbytes);
+		if(bwrite < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			return(false);
+		}
+		nbytes += bwrite;
+	}
+
+	return(true);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int main(int32 argc, char* argv[])
+{
+
+	IF_Gen_Options opt;
+	Signal_Gen *gen;
+	CPX *buff;
+	int32 lcv, fd, fifo, ms;
+	int64 total, done;
+	uint64 start, elapsed;
+
+	opt.seconds = -1;
+	opt.tow = -1;
+	opt.lat = 40.0;
+	opt.lon = -105.25;
+	opt.alt = 1650.0;
+	opt.cn0 = 45.0;
+	opt.mask = 5.0;
+	opt.sigma = SGEN_NOISE_SIGMA;
+	opt.svs = 8;
+	opt.week = -1;
+	opt.threads = sysconf(_SC_NPROCESSORS_ONLN);
+	opt.nav = true;
+	opt.seed = 1;
+	opt.ephem[0] = '\0';
+	opt.filename[0] = '\0';
+
+	for(lcv = 1; lcv < argc; lcv++)
+	{
+		if(!strcmp(argv[lcv], "-o") && (lcv+1 < argc))
+			strncpy(opt.filename, argv[++lcv], 1023);
+		else if(!strcmp(argv[lcv], "-t") && (lcv+1 < argc))
+			opt.seconds = atof(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-e") && (lcv+1 < argc))
+			strncpy(opt.ephem, argv[++lcv], 1023);
+		else if(!strcmp(argv[lcv], "-p") && (lcv+3 < argc))
+		{
+			opt.lat = atof(argv[++lcv]);
+			opt.lon = atof(argv[++lcv]);
+			opt.alt = atof(argv[++lcv]);
+		}
+		else if(!strcmp(argv[lcv], "-w") && (lcv+1 < argc))
+			opt.week = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-s") && (lcv+1 < argc))
+			opt.tow = atof(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-c") && (lcv+1 < argc))
+			opt.cn0 = atof(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-n") && (lcv+1 < argc))
+			opt.svs = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-m") && (lcv+1 < argc))
+			opt.mask = atof(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-j") && (lcv+1 < argc))
+			opt.threads = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-q") && (lcv+1 < argc))
+			opt.sigma = atof(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-b"))
+			opt.nav = false;
+		else if(!strcmp(argv[lcv], "-r") && (lcv+1 < argc))
+			opt.seed = (uint32)strtoul(argv[++lcv], NULL, 0);
+		else
+			gen_usage(argv[0]);
+	}
+
+	if(opt.seconds < 0)
+		opt.seconds = opt.filename[0] ? 60.0 : 0.0;
+
+	gen = new Signal_Gen(opt.threads, opt.seed);
+	gen->SetPosition(opt.lat, opt.lon, opt.alt);
+	gen->SetNoise(opt.sigma);
+	gen->SetNav(opt.nav);
+
+	if(opt.ephem[0])
+	{
+		if(!gen_ephemeris(&opt, gen))
+			return(-1);
+	}
+	else
+	{
+		/* Spread the SVs over Doppler & code phase */
+		gen->SetTime(opt.week < 0 ? 0 : opt.week, opt.tow < 0 ? 345600.0 : opt.tow);
+		for(lcv = 0; lcv < opt.svs && lcv < NUM_CODES; lcv++)
+			gen->AddSV(lcv, opt.cn0, (double)((100 + 83*lcv) % CODE_CHIPS), (double)(((lcv % 9) - 4)*1000 + 37*lcv));
+	}
+
+	if(gen->GetSVs() == 0)
+	{
+		printf("No SVs to simulate\n");
+		return(-1);
+	}
+
+	/* Truth, in the same units as Acq_Command_M */
+	for(lcv = 0; lcv < gen->GetSVs(); lcv++)
+		fprintf(stderr, "Chan %02d\tdelay %10.3f chips\tdoppler %10.1f Hz\n", lcv, gen->GetDelay(lcv), gen->GetDoppler(lcv));
+
+	/* Open the output */
+	if(opt.filename[0])
+	{
+		fd = open(opt.filename, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+		if(fd == -1)
+		{
+			printf("Could not open %s for writing\n", opt.filename);
+			return(-1);
+		}
+	}
+	else
+	{
+		fifo = mkfifo("/tmp/GPSPIPE", S_IRWXG | S_IRWXU | S_IRWXO);
+		if((fifo == -1) && (errno != EEXIST))
+			printf("Error creating the named pipe\n");
+
+		signal(SIGPIPE, SIG_IGN);
+
+		fprintf(stderr, "Waiting for client\n");
+		fd = open("/tmp/GPSPIPE", O_WRONLY);
+		if(fd == -1)
+		{
+			printf("Could not open /tmp/GPSPIPE\n");
+			return(-1);
+		}
+		fprintf(stderr, "Client connected\n");
+	}
+
+	buff = new CPX[IF_GEN_BLOCK_MS*IF_SAMPS_MS];
+
+	total = (int64)floor(opt.seconds*1000.0 + 0.5);
+	done = 0;
+	start = monotonic_ns();
+
+	while((total == 0) || (done < total))
+	{
+		ms = IF_GEN_BLOCK_MS;
+		if(total && (total - done < ms))
+			ms = (int32)(total - done);
+
+		gen->Generate(buff, ms);
+
+		if(!gen_write(fd, (char *)buff, ms*IF_SAMPS_MS*sizeof(CPX)))
+			break;
+
+		done += ms;
+	}
+
+	elapsed = monotonic_ns() - start;
+
+	fprintf(stderr, "Generated %.3f s of IF in %.3f s, %.1fx realtime with %d threads\n", (double)done*1e-3,
+			(double)elapsed*1e-9, (double)done*1e6/(double)(elapsed ? elapsed : 1), opt.threads);
+
+	close(fd);
+
+	delete [] buff;
+	delete gen;
+
+	return(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
@@ -0,0 +1,189 @@
+/*! \file loop_bank.cpp
+	Implements member functions of Loop_Bank class.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#include "includes.h"
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * atan() without a branch or a call so the loops below vectorize. Range reduced to [0, 1], then
+ * Abramowitz & Stegun 4.4.49, |error| < 2e-8 rad, well under the float rounding of the input.
+ */
+static inline float bank_atan(float _x)
+{
+	float ax, inv, r, s, p;
+
+	/* Both sides are worked out and one picked, a branch would stop the vectorizer */
+	ax = fabsf(_x);
+	inv = 1.0f/ax;
+	r = (ax > 1.0f) ? inv : ax;
+	s = r*r;
+
+	p = 0.0028662257f;
+	p = p*s - 0.0161657367f;
+	p = p*s + 0.0429096138f;
+	p = p*s - 0.0752896400f;
+	p = p*s + 0.1065626393f;
+	p = p*s - 0.1420889944f;
+	p = p*s + 0.1999355085f;
+	p = p*s - 0.3333314528f;
+	p = (p*s + 1.0f)*r;
+
+	p = (ax > 1.0f) ? (float)(PI/2.0) - p : p;
+
+	return((_x < 0.0f) ? -p : p);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * log10() of a positive float, same idea. The exponent comes straight from the bits, the
+ * mantissa m in [1, 2) goes through the atanh series of log2(m), 5 terms is < 1e-6 dB.
+ */
+static inline float bank_log10(float _x)
+{
+	int32 i;
+	float m, e, t, t2, p;
+
+	/* memcpy() rather than a union, the vectorizer gives up on the union */
+	memcpy(&i, &_x, sizeof(i));
+	e = (float)(((i >> 23) & 0xff) - 127);
+	i = (i & 0x007fffff) | 0x3f800000;
+	memcpy(&m, &i, sizeof(m));
+
+	t = (m - 1.0f)/(m + 1.0f);
+	t2 = t*t;
+
+	p = 1.0f/9.0f;
+	p = p*t2 + 1.0f/7.0f;
+	p = p*t2 + 1.0f/5.0f;
+	p = p*t2 + 1.0f/3.0f;
+	p = (p*t2 + 1.0f)*t*2.8853900818f;		/* 2/ln(2) */
+
+	return((e + p)*0.3010299957f);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Loop_Bank::Run()
+{
+	Loops();
+	Filters();
+	Estimate();
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Channel::PLL() and DLL(). PLL() computes the FLL discriminator and then zeroes it, so only
+ * its lock indicator is kept here, and the filter terms it would have fed drop out.
+ */
+void Loop_Bank::Loops()
+{
+	int32 k;
+	float cross, ratio, dp, ep, lp;
+
+	for(k = 0; k < n; k++)
+	{
+		/* FLL lock indicator */
+		cross = Q[1][k]*I_prev[k] - I[1][k]*Q_prev[k];
+		fll_lock[k] += (cross/P_avg[k] - fll_lock[k])*0.1f;
+
+		/* PLL discriminator */
+		ratio = Q[1][k]/I[1][k];
+		dp = bank_atan(ratio)*(float)(1.0/TWO_PI);
+		dp = (I[1][k] != 0.0f) ? dp : 0.0f;
+		pll_lock[k] = dp;
+
+		/* 3rd order PLL */
+		w[k] += t[k]*w0p3[k]*dp;
+		x[k] += t[k]*(0.5f*w[k] + a3w0p2[k]*dp);
+		z[k]  = 0.5f*x[k] + b3w0p[k]*dp;
+
+		/* Early minus late envelope */
+		ep = sqrtf(I[0][k]*I[0][k] + Q[0][k]*Q[0][k]);
+		lp = sqrtf(I[2][k]*I[2][k] + Q[2][k]*Q[2][k]);
+		code_err[k] = (ep - lp)/(ep + lp);
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! The lowpass filters of Channel::DumpAccum() */
+void Loop_Bank::Filters()
+{
+	int32 k;
+
+	for(k = 0; k < n; k++)
+	{
+		I_avg[k] += (fabsf(I[1][k]) - I_avg[k])*0.02f;
+		Q_var[k] += (Q[1][k]*Q[1][k] - Q_var[k])*0.02f;
+		P_avg[k] += ((I[1][k]*I[1][k] + Q[1][k]*Q[1][k])/len[k] - P_avg[k])*0.1f;
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Both CN0 estimates of Channel::DumpAccum(), narrow to wide band power over the last 20 ms
+ * and the old school one from the lock filters.
+ */
+void Loop_Bank::Estimate()
+{
+	int32 k, lcv;
+	float WBP[LOOP_BANK_SIZE];
+	float NBP, np, np_old, ratio, cn0, cn0_old, db;
+
+	for(k = 0; k < n; k++)
+		WBP[k] = 0.0f;
+
+	for(lcv = 0; lcv < 20; lcv++)
+		for(k = 0; k < n; k++)
+			WBP[k] += I_buff[lcv][k]*I_buff[lcv][k] + Q_buff[lcv][k]*Q_buff[lcv][k];
+
+	for(k = 0; k < n; k++)
+	{
+		NBP = I_sum20[k]*I_sum20[k] + Q_sum20[k]*Q_sum20[k];
+		np_old = NP[k];
+		cn0_old = CN0[k];
+
+		np = np_old + (NBP/WBP[k] - np_old)*0.02f;
+		np = (WBP[k] > 0.0f) ? np : np_old;
+
+		ratio = (np - 1.0f)/(20.0f - np);
+		db = 10.0f*bank_log10(ratio) + 30.25f;
+		cn0 = (ratio > 0.0f) ? db : cn0_old;
+		cn0 = (cn0 < 15.0f) ? 15.0f : cn0;
+
+		/* Always stored, Channel::StoreBank() keeps them only at a bit edge. Selecting the old
+		value back in here gets turned into a conditional store, which does not vectorize */
+		NP[k] = np;
+		CN0[k] = cn0;
+
+		CN0_old[k] = 10.0f*bank_log10(I_avg[k]*I_avg[k]/(2.0f*Q_var[k]*t[k]));
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
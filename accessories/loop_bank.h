@@ -0,0 +1,86 @@
+/*! \file loop_bank.h
+	Defines the class Loop_Bank
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef LOOP_BANK_H_
+#define LOOP_BANK_H_
+
+#define LOOP_BANK_SIZE	(((MAX_CHANNELS) + 3) & ~3)		//!< Slots, a whole number of SSE vectors
+
+/*! \ingroup CLASSES
+ * The dump stage of the tracking loops (Channel::PLL(), DLL() and the lock & CN0 filters of
+ * DumpAccum()) for a batch of channels at once, with -batch. The channels that dump at the
+ * same time are gathered into slots 0..n-1 of these arrays, every stage is then one loop over
+ * the slots with no branches and no calls, so -ftree-vectorize runs it four channels per SSE
+ * instruction, and the results are scattered back. The bit & frame sync, coasting and the FFT
+ * pull-in stay per channel.
+ */
+class Loop_Bank
+{
+
+	public:
+
+		int32 n;							//!< Slots in use
+
+		/* Inputs, gathered by Channel::LoadBank() */
+		float I[3][LOOP_BANK_SIZE];			//!< Early, prompt & late
+		float Q[3][LOOP_BANK_SIZE];
+		float I_prev[LOOP_BANK_SIZE];		//!< Prompt of the previous dump
+		float Q_prev[LOOP_BANK_SIZE];
+		float len[LOOP_BANK_SIZE];			//!< Integration length (ms)
+		float I_sum20[LOOP_BANK_SIZE];		//!< 20 ms prompt sums
+		float Q_sum20[LOOP_BANK_SIZE];
+		float I_buff[20][LOOP_BANK_SIZE];	//!< Last 20 1 ms prompts
+		float Q_buff[20][LOOP_BANK_SIZE];
+
+		/* PLL coefficients, see Channel::PLL_W() */
+		float t[LOOP_BANK_SIZE];
+		float w0p3[LOOP_BANK_SIZE];
+		float a3w0p2[LOOP_BANK_SIZE];		//!< a3*w0p2
+		float b3w0p[LOOP_BANK_SIZE];		//!< b3*w0p
+
+		/* State, in and out */
+		float w[LOOP_BANK_SIZE];			//!< PLL acceleration accumulator
+		float x[LOOP_BANK_SIZE];			//!< PLL velocity accumulator
+		float z[LOOP_BANK_SIZE];			//!< PLL output
+		float pll_lock[LOOP_BANK_SIZE];		//!< PLL lock indicator
+		float fll_lock[LOOP_BANK_SIZE];		//!< FLL lock indicator
+		float I_avg[LOOP_BANK_SIZE];		//!< Lock filters
+		float Q_var[LOOP_BANK_SIZE];
+		float P_avg[LOOP_BANK_SIZE];
+		float NP[LOOP_BANK_SIZE];			//!< CN0 estimator, only kept at a bit edge
+		float CN0[LOOP_BANK_SIZE];
+
+		/* Outputs */
+		float code_err[LOOP_BANK_SIZE];		//!< DLL discriminator
+		float CN0_old[LOOP_BANK_SIZE];		//!< Old school CN0
+
+		Loop_Bank(){n = 0;};
+		void Clear(){n = 0;};				//!< Start a new batch
+		int32 Add(){return(n++);};			//!< Next free slot
+		void Run();							//!< All the stages below, over slots 0..n-1
+		void Loops();						//!< PLL & DLL discriminators and the PLL filter
+		void Filters();						//!< I_avg, Q_var & P_avg
+		void Estimate();					//!< CN0 estimators
+
+};
+
+#endif /*LOOP_BANK_H_*/
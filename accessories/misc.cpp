@@ -19,6 +19,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 
 #include "includes.h"
+#include <dirent.h>
+#include <sys/syscall.h>
 
 
 /*----------------------------------------------------------------------------------------------*/
@@ -619,3 +621,92 @@ uint32 adler(uint8 *data, int32 len)
 }
 /*----------------------------------------------------------------------------------------------*/
 
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * monotonic_ns, nanoseconds from CLOCK_MONOTONIC, for timing (not affected by clock steps)
+ * */
+uint64 monotonic_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return((uint64)ts.tv_sec*1000000000ULL + (uint64)ts.tv_nsec);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * cpu_node, get the NUMA node a CPU belongs to from sysfs, -1 if it cannot be determined
+ * */
+int32 cpu_node(int32 _cpu)
+{
+
+	char path[256];
+	DIR *dir;
+	struct dirent *entry;
+	int32 node;
+
+	sprintf(path, "/sys/devices/system/cpu/cpu%d", _cpu);
+
+	dir = opendir(path);
+	if(dir == NULL)
+		return(-1);
+
+	/* The node appears as a "nodeN" link in the CPU's directory */
+	node = -1;
+	while((entry = readdir(dir)) != NULL)
+	{
+		if((strncmp(entry->d_name, "node", 4) == 0) && isdigit(entry->d_name[4]))
+		{
+			node = atoi(&entry->d_name[4]);
+			break;
+		}
+	}
+
+	closedir(dir);
+
+	return(node);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * numa_place, move a buffer to the given NUMA node (and keep it there), returns 0 on success.
+ * Done with the raw mbind syscall so we do not depend on libnuma. Only the pages that lie
+ * entirely inside the buffer are moved.
+ * */
+int32 numa_place(void *_buff, uint32 _bytes, int32 _node)
+{
+
+#ifdef __NR_mbind
+	unsigned long mask;
+	unsigned long page;
+	unsigned long start;
+	unsigned long stop;
+
+	if((_node < 0) || (_node >= (int32)(8*sizeof(unsigned long))))
+		return(-1);
+
+	page = sysconf(_SC_PAGESIZE);
+	start = ((unsigned long)_buff + page - 1) & ~(page - 1);
+	stop = ((unsigned long)_buff + _bytes) & ~(page - 1);
+
+	if(stop <= start)
+		return(-1);
+
+	mask = 1UL << _node;
+
+	/* MPOL_PREFERRED = 1, MPOL_MF_MOVE = 2 (from linux/mempolicy.h) */
+	return(syscall(__NR_mbind, start, stop - start, 1, &mask, 8*sizeof(unsigned long), 2));
+#else
+	return(-1);
+#endif
+
+}
+/*----------------------------------------------------------------------------------------------*/
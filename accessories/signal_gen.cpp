@@ -0,0 +1,750 @@
+/*! \file Signal_Gen.cpp
+	Implements member functions of Signal_Gen class.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#include "includes.h"
+
+/*! \ingroup STRUCTS
+ * Arguments for a worker thread
+ */
+typedef struct _Signal_Gen_Work_S
+{
+	Signal_Gen *gen;		//!< The generator
+	CPX *dest;				//!< Start of the block
+	int32 first;			//!< First ms of the block this thread fills
+	int32 ms;				//!< Number of ms this thread fills
+} Signal_Gen_Work_S;
+
+/*----------------------------------------------------------------------------------------------*/
+void *Signal_Gen_Thread(void *_arg)
+{
+	Signal_Gen_Work_S *work = (Signal_Gen_Work_S *)_arg;
+
+	work->gen->Work(work->dest, work->first, work->ms);
+
+	pthread_exit(0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Floor division, rounds toward -infinity */
+static int64 sgen_div(int64 _a, int64 _b)
+{
+	int64 q = _a / _b;
+
+	if((_a % _b) && ((_a < 0) != (_b < 0)))
+		q--;
+
+	return(q);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Quantize _x to an _bits wide two's complement field with LSB _scale */
+static uint32 sgen_field(double _x, double _scale, int32 _bits)
+{
+	int64 val;
+
+	val = (int64)floor(_x/_scale + 0.5);
+
+	return((uint32)(val & ((1LL << _bits) - 1)));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Even parity of a 32 bit word */
+static uint32 sgen_parity(uint32 _x)
+{
+	_x ^= _x >> 16;
+	_x ^= _x >> 8;
+	_x ^= _x >> 4;
+	_x ^= _x >> 2;
+	_x ^= _x >> 1;
+
+	return(_x & 0x1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Build a 30 bit GPS word from 24 data bits, _prev is the previous word as transmitted (for D29* & D30*).
+ * Parity as described in ICD-GPS-200, this is the inverse of Channel::ParityCheck()
+ * */
+static uint32 sgen_word(uint32 _data, uint32 _prev)
+{
+	uint32 d29, d30, parity;
+
+	d29 = (_prev >> 1) & 0x1;
+	d30 = _prev & 0x1;
+
+	_data &= 0x00FFFFFF;
+
+	parity =  (d29 ^ sgen_parity(_data & 0x00EC7CD2)) << 5;
+	parity |= (d30 ^ sgen_parity(_data & 0x00763E69)) << 4;
+	parity |= (d29 ^ sgen_parity(_data & 0x00BB1F34)) << 3;
+	parity |= (d30 ^ sgen_parity(_data & 0x005D8F9A)) << 2;
+	parity |= (d30 ^ sgen_parity(_data & 0x00AEC7CD)) << 1;
+	parity |= (d29 ^ sgen_parity(_data & 0x002DEA27));
+
+	if(d30)
+		_data ^= 0x00FFFFFF;
+
+	return((_data << 6) | parity);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Same as sgen_word(), but solve the 2 LSBs of the data (the "t" bits) so D29 = D30 = 0 */
+static uint32 sgen_word_t(uint32 _data, uint32 _prev)
+{
+	uint32 t, word;
+
+	word = 0;
+	for(t = 0; t < 4; t++)
+	{
+		word = sgen_word((_data & 0x00FFFFFC) | t, _prev);
+		if((word & 0x3) == 0)
+			break;
+	}
+
+	return(word);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Signal_Gen::Signal_Gen(int32 _threads, uint32 _seed)
+{
+	int32 lcv;
+	double u1, u2;
+	uint32 x;
+
+	nsvs = 0;
+	states = NULL;
+	block_ms = 0;
+	sigma = SGEN_NOISE_SIGMA;
+	nav_on = true;
+	seed = _seed;
+	week = 0;
+	tow = 0;
+	ms = 0;
+	rx[0] = rx[1] = rx[2] = 0;
+	lat = lon = 0;
+
+	threads = _threads;
+	if(threads < 1)
+		threads = 1;
+	if(threads > SGEN_MAX_THREADS)
+		threads = SGEN_MAX_THREADS;
+
+	/* Gaussian lookup, unit variance, scaled to sigma in Work() */
+	noise = new int16[1 << SGEN_NOISE_BITS];
+	x = 0x12345678;
+	for(lcv = 0; lcv < (1 << SGEN_NOISE_BITS); lcv += 2)
+	{
+		x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+		u1 = ((double)x + 1.0)/4294967297.0;
+		x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+		u2 = (double)x/4294967296.0;
+
+		/* Q12, Box-Muller on 32 bit uniforms never exceeds 6.7 sigma so this fits */
+		noise[lcv] 	 = (int16)floor(4096.0*sqrt(-2.0*log(u1))*cos(TWO_PI*u2) + 0.5);
+		noise[lcv+1] = (int16)floor(4096.0*sqrt(-2.0*log(u1))*sin(TWO_PI*u2) + 0.5);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Signal_Gen::~Signal_Gen()
+{
+
+	if(states != NULL)
+		delete [] states;
+
+	delete [] noise;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! The time is rounded to a whole ms, which keeps all the per ms epoch math in integers. Call before AddSV() */
+void Signal_Gen::SetTime(int32 _week, double _tow)
+{
+	week = _week;
+	tow = floor(_tow*1000.0 + 0.5)/1000.0;
+	ms = 0;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Signal_Gen::SetPosition(double _lat, double _lon, double _alt)
+{
+	double a = 6378137;
+	double e2 = 0.00669438006676;
+	double N;
+
+	lat = _lat*PI/180.0;
+	lon = _lon*PI/180.0;
+
+	N = a/sqrt(1.0 - e2*sin(lat)*sin(lat));
+
+	rx[0] = (N + _alt)*cos(lat)*cos(lon);
+	rx[1] = (N + _alt)*cos(lat)*sin(lon);
+	rx[2] = (N*(1.0 - e2) + _alt)*sin(lat);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Fixed Doppler SV, the code Doppler is consistent with the carrier. The navigation message carries
+ * the right TOW but an empty ephemeris marked unhealthy, so the receiver will track it and get
+ * frame sync, but not navigate on it.
+ * */
+int32 Signal_Gen::AddSV(int32 _sv, float _cn0, double _delay, double _doppler)
+{
+	SV_Gen_S *p;
+	CPX code[CODE_CHIPS];
+	int32 lcv;
+
+	if((nsvs >= SGEN_MAX_SV) || (_sv < 0) || (_sv >= NUM_CODES))
+		return(false);
+
+	p = &svs[nsvs];
+	memset(p, 0x0, sizeof(SV_Gen_S));
+
+	p->sv = _sv;
+	p->cn0 = _cn0;
+	p->use_ephem = false;
+	p->doppler = _doppler;
+
+	/* Roughly 75 ms of transit time, and code phase _delay at t = 0 */
+	_delay = fmod(fmod(_delay, (double)CODE_CHIPS) + (double)CODE_CHIPS, (double)CODE_CHIPS);
+	p->delta = (-75.0 + _delay/(double)CODE_CHIPS)*1e-3;
+
+	p->ephem.sv = _sv;
+	p->ephem.week_number = week;
+	p->ephem.subframe_1_health = 0x3F;
+
+	code_gen(&code[0], _sv);
+	for(lcv = 0; lcv < CODE_CHIPS; lcv++)
+		p->code[lcv] = code[lcv].i & 0x1;
+
+	p->nav_base = -10;
+	Scale(p);
+
+	nsvs++;
+
+	return(true);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int32 Signal_Gen::AddSV(int32 _sv, float _cn0, Ephemeris_M *_ephem)
+{
+	SV_Gen_S *p;
+	CPX code[CODE_CHIPS];
+	int32 lcv;
+
+	if((nsvs >= SGEN_MAX_SV) || (_sv < 0) || (_sv >= NUM_CODES))
+		return(false);
+
+	p = &svs[nsvs];
+	memset(p, 0x0, sizeof(SV_Gen_S));
+
+	p->sv = _sv;
+	p->cn0 = _cn0;
+	p->use_ephem = true;
+	p->ephem = *_ephem;
+	p->ephem.sv = _sv;
+
+	/* Make sure the derived quantities are there */
+	p->ephem.a = p->ephem.sqrta*p->ephem.sqrta;
+	p->ephem.n0 = sqrt(GRAVITY_CONSTANT/(p->ephem.a*p->ephem.a*p->ephem.a));
+
+	code_gen(&code[0], _sv);
+	for(lcv = 0; lcv < CODE_CHIPS; lcv++)
+		p->code[lcv] = code[lcv].i & 0x1;
+
+	p->nav_base = -10;
+	Scale(p);
+
+	nsvs++;
+
+	return(true);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! C/N0 = A^2*fs/(2*sigma^2), the table is scaled so the noise can stay at sigma */
+void Signal_Gen::Scale(SV_Gen_S *_sv)
+{
+	int32 lcv;
+	double amp, phase;
+
+	amp = SGEN_NOISE_SIGMA*sqrt(2.0*pow(10.0, _sv->cn0/10.0)/(double)IF_SAMPLE_FREQUENCY);
+
+	for(lcv = 0; lcv < (1 << SGEN_SINE_BITS); lcv++)
+	{
+		phase = TWO_PI*((double)lcv + 0.5)/(double)(1 << SGEN_SINE_BITS);
+		_sv->sine[lcv].i = (int16)floor(amp*cos(phase) + 0.5);
+		_sv->sine[lcv].q = (int16)floor(amp*sin(phase) + 0.5);
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! ECEF position & clock correction per ICD-GPS-200, same math as PVT::SV_Positions() */
+void Signal_Gen::SV_Position(Ephemeris_M *_ephem, double _t, double *_pos, double *_clock)
+{
+	double tk, M, E, dE, sE, cE, P, s2P, c2P, U, R, I, L, Xp, Yp, dt;
+	int32 iter;
+
+	tk = _t - _ephem->toe;
+	if(tk > HALF_OF_SECONDS_IN_WEEK)
+		tk -= SECONDS_IN_WEEK;
+	else if(tk < -HALF_OF_SECONDS_IN_WEEK)
+		tk += SECONDS_IN_WEEK;
+
+	M = _ephem->m0 + (_ephem->n0 + _ephem->deltan)*tk;
+
+	E = M;
+	for(iter = 0; iter < 20; iter++)
+	{
+		dE = (M - E + _ephem->ecc*sin(E))/(1.0 - _ephem->ecc*cos(E));
+		E += dE;
+		if(fabs(dE) < 1.0e-14)
+			break;
+	}
+	sE = sin(E);
+	cE = cos(E);
+
+	P = atan2(sqrt(1.0 - _ephem->ecc*_ephem->ecc)*sE, cE - _ephem->ecc) + _ephem->argp;
+	s2P = sin(2.0*P);
+	c2P = cos(2.0*P);
+
+	U = P + _ephem->cus*s2P + _ephem->cuc*c2P;
+	R = _ephem->a*(1.0 - _ephem->ecc*cE) + _ephem->crs*s2P + _ephem->crc*c2P;
+	I = _ephem->in0 + _ephem->idot*tk + _ephem->cis*s2P + _ephem->cic*c2P;
+	L = _ephem->om0 + tk*(_ephem->omd - WGS84OE) - WGS84OE*_ephem->toe;
+
+	Xp = R*cos(U);
+	Yp = R*sin(U);
+
+	_pos[0] = Xp*cos(L) - Yp*cos(I)*sin(L);
+	_pos[1] = Xp*sin(L) + Yp*cos(I)*cos(L);
+	_pos[2] = Yp*sin(I);
+
+	dt = _t - _ephem->toc;
+	if(dt > HALF_OF_SECONDS_IN_WEEK)
+		dt -= SECONDS_IN_WEEK;
+	else if(dt < -HALF_OF_SECONDS_IN_WEEK)
+		dt += SECONDS_IN_WEEK;
+
+	*_clock = _ephem->af0 + _ephem->af1*dt + _ephem->af2*dt*dt
+			- 4.442807633e-10*_ephem->ecc*_ephem->sqrta*sE - _ephem->tgd;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * SV time minus receiver time, at receiver time _t. This is the only place the geometry comes in,
+ * the code phase is CODE_RATE*(_t + Delta) and the carrier phase L1*Delta + IF*_t
+ * */
+double Signal_Gen::Delta(SV_Gen_S *_sv, double _t)
+{
+	double pos[3], rot[3], clock, range, transit, wt;
+	int32 iter;
+
+	if(!_sv->use_ephem)
+		return(_sv->delta + _sv->doppler/L1*(_t - tow));
+
+	/* Light time iteration, with the Earth rotation during the transit */
+	transit = 0.075;
+	range = 0;
+	clock = 0;
+	for(iter = 0; iter < 3; iter++)
+	{
+		SV_Position(&_sv->ephem, _t - transit, pos, &clock);
+
+		wt = WGS84OE*transit;
+		rot[0] = pos[0]*cos(wt) + pos[1]*sin(wt) - rx[0];
+		rot[1] = pos[1]*cos(wt) - pos[0]*sin(wt) - rx[1];
+		rot[2] = pos[2] - rx[2];
+
+		range = sqrt(rot[0]*rot[0] + rot[1]*rot[1] + rot[2]*rot[2]);
+		transit = range/SPEED_OF_LIGHT;
+	}
+
+	return(clock - transit);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+double Signal_Gen::Elevation(Ephemeris_M *_ephem)
+{
+	Ephemeris_M ephem;
+	double pos[3], los[3], clock, range, up;
+
+	ephem = *_ephem;
+	ephem.a = ephem.sqrta*ephem.sqrta;
+	ephem.n0 = sqrt(GRAVITY_CONSTANT/(ephem.a*ephem.a*ephem.a));
+
+	SV_Position(&ephem, tow, pos, &clock);
+
+	los[0] = pos[0] - rx[0];
+	los[1] = pos[1] - rx[1];
+	los[2] = pos[2] - rx[2];
+	range = sqrt(los[0]*los[0] + los[1]*los[1] + los[2]*los[2]);
+
+	up = (los[0]*cos(lat)*cos(lon) + los[1]*cos(lat)*sin(lon) + los[2]*sin(lat))/range;
+
+	return(asin(up)*180.0/PI);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+double Signal_Gen::GetDoppler(int32 _sv)
+{
+	double t;
+
+	if((_sv < 0) || (_sv >= nsvs))
+		return(0);
+
+	t = tow + (double)ms*1e-3;
+
+	return(L1*(Delta(&svs[_sv], t + 0.5e-3) - Delta(&svs[_sv], t - 0.5e-3))*1000.0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+double Signal_Gen::GetDelay(int32 _sv)
+{
+	double x;
+
+	if((_sv < 0) || (_sv >= nsvs))
+		return(0);
+
+	x = 1000.0*Delta(&svs[_sv], tow + (double)ms*1e-3);
+
+	return((x - floor(x))*(double)CODE_CHIPS);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Encode subframe _subframe (counted in 6 s units from the start of the week) into 300 bits */
+void Signal_Gen::Subframe(SV_Gen_S *_sv, int64 _subframe, uint8 *_bits)
+{
+	Ephemeris_M *e = &_sv->ephem;
+	uint32 data[10], word, prev;
+	uint32 m0, ecc, sqrta, om0, in0, argp, tow_count;
+	int32 sid, lcv, lcv2;
+
+	sid = (int32)(((_subframe % 5) + 5) % 5) + 1;
+	tow_count = (uint32)((((_subframe + 1) % 100800) + 100800) % 100800);
+
+	memset(data, 0x0, sizeof(data));
+
+	/* TLM & HOW */
+	data[0] = PREAMBLE << 16;
+	data[1] = (tow_count << 7) | (sid << 2);
+
+	m0 = 	sgen_field(e->m0, 	PI_TWO_N31, 32);
+	ecc = 	sgen_field(e->ecc, 	TWO_N33, 	32);
+	sqrta = sgen_field(e->sqrta,TWO_N19, 	32);
+	om0 = 	sgen_field(e->om0, 	PI_TWO_N31, 32);
+	in0 = 	sgen_field(e->in0, 	PI_TWO_N31, 32);
+	argp = 	sgen_field(e->argp, PI_TWO_N31, 32);
+
+	switch(sid)
+	{
+		case 1:
+			data[2] = ((e->week_number & 0x3FF) << 14) | ((e->code_on_L2 & 0x3) << 12) | ((e->ura & 0xF) << 8) |
+					  ((e->subframe_1_health & 0x3F) << 2) | ((e->iodc >> 8) & 0x3);
+			data[6] = sgen_field(e->tgd, TWO_N31, 8);
+			data[7] = ((e->iodc & 0xFF) << 16) | sgen_field(e->toc, TWO_P4, 16);
+			data[8] = (sgen_field(e->af2, TWO_N55, 8) << 16) | sgen_field(e->af1, TWO_N43, 16);
+			data[9] = sgen_field(e->af0, TWO_N31, 22) << 2;
+			break;
+		case 2:
+			data[2] = ((e->iode & 0xFF) << 16) | sgen_field(e->crs, TWO_N5, 16);
+			data[3] = (sgen_field(e->deltan, PI_TWO_N43, 16) << 8) | (m0 >> 24);
+			data[4] = m0 & 0x00FFFFFF;
+			data[5] = (sgen_field(e->cuc, TWO_N29, 16) << 8) | (ecc >> 24);
+			data[6] = ecc & 0x00FFFFFF;
+			data[7] = (sgen_field(e->cus, TWO_N29, 16) << 8) | (sqrta >> 24);
+			data[8] = sqrta & 0x00FFFFFF;
+			data[9] = sgen_field(e->toe, TWO_P4, 16) << 8;
+			break;
+		case 3:
+			data[2] = (sgen_field(e->cic, TWO_N29, 16) << 8) | (om0 >> 24);
+			data[3] = om0 & 0x00FFFFFF;
+			data[4] = (sgen_field(e->cis, TWO_N29, 16) << 8) | (in0 >> 24);
+			data[5] = in0 & 0x00FFFFFF;
+			data[6] = (sgen_field(e->crc, TWO_N5, 16) << 8) | (argp >> 24);
+			data[7] = argp & 0x00FFFFFF;
+			data[8] = sgen_field(e->omd, PI_TWO_N43, 24);
+			data[9] = ((e->iode & 0xFF) << 16) | (sgen_field(e->idot, PI_TWO_N43, 14) << 2);
+			break;
+		default:
+			/* Data ID 01, SV ID 0 (dummy page) */
+			data[2] = 0x1 << 22;
+			break;
+	}
+
+	/* Word 10 of the last subframe always ends in 00, so D29* = D30* = 0 */
+	prev = 0;
+	for(lcv = 0; lcv < 10; lcv++)
+	{
+		if((lcv == 1) || (lcv == 9))
+			word = sgen_word_t(data[lcv], prev);
+		else
+			word = sgen_word(data[lcv], prev);
+
+		for(lcv2 = 0; lcv2 < 30; lcv2++)
+			_bits[lcv*30 + lcv2] = (word >> (29 - lcv2)) & 0x1;
+
+		prev = word;
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int32 Signal_Gen::NavBit(SV_Gen_S *_sv, int64 _bit)
+{
+	int64 subframe;
+
+	if(!nav_on)
+		return(0);
+
+	subframe = sgen_div(_bit, SGEN_SUBFRAME_BITS);
+
+	if(subframe == _sv->nav_base + 2)
+	{
+		memcpy(&_sv->nav[0], &_sv->nav[SGEN_SUBFRAME_BITS], SGEN_SUBFRAME_BITS);
+		Subframe(_sv, subframe, &_sv->nav[SGEN_SUBFRAME_BITS]);
+		_sv->nav_base++;
+	}
+	else if((subframe < _sv->nav_base) || (subframe > _sv->nav_base + 1))
+	{
+		Subframe(_sv, subframe, &_sv->nav[0]);
+		Subframe(_sv, subframe + 1, &_sv->nav[SGEN_SUBFRAME_BITS]);
+		_sv->nav_base = subframe;
+	}
+
+	return(_sv->nav[_bit - _sv->nav_base*SGEN_SUBFRAME_BITS]);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Compute the state of every SV at every ms boundary of the block. Receiver time is kept as an
+ * integer ms count, so the code epoch (and hence data bit) count is exact and only the fraction
+ * of a code period comes from the floating point Delta()
+ * */
+void Signal_Gen::Propagate(int32 _ms)
+{
+	SV_Gen_S *p;
+	SV_Gen_State *s;
+	double d0[SGEN_MAX_SV], d1, x, chips, cycles, t;
+	int64 ms_abs, epochs, bit;
+	int32 lcv, lcv2;
+
+	ms_abs = (int64)floor(tow*1000.0 + 0.5) + ms;
+
+	for(lcv2 = 0; lcv2 < nsvs; lcv2++)
+		d0[lcv2] = Delta(&svs[lcv2], tow + (double)ms*1e-3);
+
+	for(lcv = 0; lcv < _ms; lcv++)
+	{
+		t = tow + (double)(ms + lcv + 1)*1e-3;
+
+		for(lcv2 = 0; lcv2 < nsvs; lcv2++)
+		{
+			p = &svs[lcv2];
+			s = &states[lcv*nsvs + lcv2];
+
+			d1 = Delta(p, t);
+
+			/* Code */
+			x = 1000.0*d0[lcv2];
+			epochs = ms_abs + lcv + (int64)floor(x);
+			chips = (x - floor(x))*(double)CODE_CHIPS;
+
+			s->code_phase = (uint64)(chips*TWO_P32);
+			s->code_step = (uint64)((double)CODE_CHIPS*(1.0 + 1000.0*(d1 - d0[lcv2]))/(double)IF_SAMPS_MS*TWO_P32 + 0.5);
+
+			/* Carrier */
+			cycles = L1*d0[lcv2] + fmod((double)IF_FREQUENCY*(double)((ms_abs + lcv) % 1000)*1e-3, 1.0);
+			cycles -= floor(cycles);
+			s->carr_phase = (uint32)(int64)(cycles*TWO_P32);
+			s->carr_step = (uint32)(int64)floor(((L1*(d1 - d0[lcv2]) + (double)IF_FREQUENCY*1e-3)/(double)IF_SAMPS_MS)*TWO_P32 + 0.5);
+
+			/* Data bits */
+			bit = sgen_div(epochs, 20);
+			s->epoch = (int32)(epochs - 20*bit);
+			s->bit = NavBit(p, bit);
+			s->next_bit = NavBit(p, bit + 1);
+
+			d0[lcv2] = d1;
+		}
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Fill ms [_first, _first + _ms) of the current block. The noise is seeded by the absolute ms, so
+ * the output does not depend on the number of threads.
+ * */
+void Signal_Gen::Work(CPX *_dest, int32 _first, int32 _ms)
+{
+	int32 acc[2*IF_SAMPS_MS];
+	SV_Gen_State st;
+	SV_Gen_S *p;
+	CPX *out, v;
+	int32 lcv, lcv2, lcv3, mask, chip, scale, val;
+	uint32 x;
+
+	scale = (int32)floor(sigma*16.0 + 0.5);
+
+	for(lcv = _first; lcv < _first + _ms; lcv++)
+	{
+		memset(acc, 0x0, sizeof(acc));
+
+		for(lcv2 = 0; lcv2 < nsvs; lcv2++)
+		{
+			p = &svs[lcv2];
+			st = states[lcv*nsvs + lcv2];
+
+			for(lcv3 = 0; lcv3 < IF_SAMPS_MS; lcv3++)
+			{
+				chip = (int32)(st.code_phase >> 32);
+				if(chip >= CODE_CHIPS)
+				{
+					chip -= CODE_CHIPS;
+					st.code_phase -= (uint64)CODE_CHIPS << 32;
+					if(++st.epoch == 20)
+					{
+						st.epoch = 0;
+						st.bit = st.next_bit;
+					}
+				}
+
+				mask = -(int32)(p->code[chip] ^ st.bit);
+				v = p->sine[st.carr_phase >> (32 - SGEN_SINE_BITS)];
+
+				acc[2*lcv3] 	+= ((int32)v.i ^ mask) - mask;
+				acc[2*lcv3 + 1] += ((int32)v.q ^ mask) - mask;
+
+				st.code_phase += st.code_step;
+				st.carr_phase += st.carr_step;
+			}
+		}
+
+		/* Noise is Q12 in the table, scale is Q4 */
+		out = &_dest[lcv*IF_SAMPS_MS];
+		x = (seed ^ (uint32)((ms + lcv)*0x9E3779B9ULL)) | 0x1;
+		for(lcv3 = 0; lcv3 < IF_SAMPS_MS; lcv3++)
+		{
+			if(scale)
+			{
+				x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+				acc[2*lcv3] 	+= (noise[x & 0xFFFF]*scale) >> 16;
+				acc[2*lcv3 + 1] += (noise[x >> 16]*scale) >> 16;
+			}
+
+			val = acc[2*lcv3];
+			out[lcv3].i = (int16)(val > 32767 ? 32767 : (val < -32768 ? -32768 : val));
+			val = acc[2*lcv3 + 1];
+			out[lcv3].q = (int16)(val > 32767 ? 32767 : (val < -32768 ? -32768 : val));
+		}
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Signal_Gen::Generate(CPX *_dest, int32 _ms)
+{
+	pthread_t thread[SGEN_MAX_THREADS];
+	Signal_Gen_Work_S work[SGEN_MAX_THREADS];
+	int32 lcv, nthreads, per, first;
+
+	if(_ms < 1)
+		return;
+
+	if(_ms > block_ms)
+	{
+		if(states != NULL)
+			delete [] states;
+
+		block_ms = _ms;
+		states = new SV_Gen_State[block_ms*SGEN_MAX_SV];
+	}
+
+	Propagate(_ms);
+
+	nthreads = (threads < _ms) ? threads : _ms;
+	per = (_ms + nthreads - 1)/nthreads;
+
+	/* This thread does the last piece */
+	first = 0;
+	for(lcv = 0; lcv < nthreads; lcv++)
+	{
+		work[lcv].gen = this;
+		work[lcv].dest = _dest;
+		work[lcv].first = first;
+		work[lcv].ms = (first + per > _ms) ? _ms - first : per;
+		first += work[lcv].ms;
+	}
+
+	for(lcv = 0; lcv < nthreads - 1; lcv++)
+		pthread_create(&thread[lcv], NULL, Signal_Gen_Thread, (void *)&work[lcv]);
+
+	Work(_dest, work[nthreads-1].first, work[nthreads-1].ms);
+
+	for(lcv = 0; lcv < nthreads - 1; lcv++)
+		pthread_join(thread[lcv], NULL);
+
+	ms += _ms;
+}
+/*----------------------------------------------------------------------------------------------*/
@@ -0,0 +1,116 @@
+/*! \file Signal_Gen.h
+	Defines the class Signal_Gen
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef SIGNAL_GEN_H_
+#define SIGNAL_GEN_H_
+
+#define SGEN_MAX_SV			(NUM_CODES)		//!< Most SVs that can be simulated at once
+#define SGEN_MAX_THREADS	(16)			//!< Most worker threads
+#define SGEN_SINE_BITS		(10)			//!< Carrier lookup table is 2^10 entries
+#define SGEN_NOISE_BITS		(16)			//!< Gaussian lookup table is 2^16 entries
+#define SGEN_NOISE_SIGMA	(256.0)			//!< Default noise sigma (per I/Q component)
+#define SGEN_SUBFRAME_BITS	(300)			//!< Bits in a navigation subframe
+
+/*! \ingroup STRUCTS
+ * State of one SV at the start of a ms, the samples within the ms are linear in code & carrier phase
+ */
+typedef struct _SV_Gen_State
+{
+	uint64 code_phase;		//!< Code phase, chips in 32.32 fixed point
+	uint64 code_step;		//!< Code phase increment per sample
+	uint32 carr_phase;		//!< Carrier phase, cycles in 0.32 fixed point
+	uint32 carr_step;		//!< Carrier phase increment per sample
+	int32 epoch;			//!< Code periods into the current data bit (0-19)
+	int32 bit;				//!< Current data bit (0 or 1)
+	int32 next_bit;			//!< Following data bit (0 or 1)
+} SV_Gen_State;
+
+/*! \ingroup STRUCTS
+ * Describes one simulated SV
+ */
+typedef struct _SV_Gen_S
+{
+	int32 sv;						//!< PRN - 1
+	float cn0;						//!< C/N0 (dB-Hz)
+	int32 use_ephem;				//!< Delay & Doppler come from ephem, otherwise from delay/doppler below
+	double delta;					//!< Static: SV time minus receiver time at t = 0 (s)
+	double doppler;					//!< Static: Doppler (Hz)
+	Ephemeris_M ephem;				//!< Ephemeris, also encoded in the navigation message
+	uint8 code[CODE_CHIPS];			//!< PRN, 0 or 1
+	CPX sine[1 << SGEN_SINE_BITS];	//!< Carrier lookup, scaled to this SV's amplitude
+	int64 nav_base;					//!< First subframe held in nav[]
+	uint8 nav[2*SGEN_SUBFRAME_BITS];//!< Two subframes worth of data bits
+} SV_Gen_S;
+
+/*! \ingroup CLASSES
+ * Multi-SV L1 C/A IF simulator. Output is CPX at IF_SAMPLE_FREQUENCY, exactly what the FIFO reads
+ * from the pipe. Code & carrier phase are propagated serially once per ms, the samples are then
+ * filled in by worker threads, each taking a contiguous range of ms.
+ */
+typedef class Signal_Gen
+{
+
+	private:
+
+		SV_Gen_S svs[SGEN_MAX_SV];		//!< The SVs
+		int32 nsvs;						//!< Number of SVs
+		SV_Gen_State *states;			//!< Per ms/SV state of the current block
+		int32 block_ms;					//!< Size of states (ms)
+		int16 *noise;					//!< Gaussian lookup table, scaled by sigma
+		float sigma;					//!< Noise sigma, 0 turns it off
+		int32 nav_on;					//!< Modulate the navigation message
+		int32 threads;					//!< Number of worker threads
+		uint32 seed;					//!< Noise seed
+		int32 week;						//!< GPS week of the first sample
+		double tow;						//!< GPS second of week of the first sample
+		double rx[3];					//!< Receiver ECEF position (m)
+		double lat;						//!< Receiver latitude (rad)
+		double lon;						//!< Receiver longitude (rad)
+		int64 ms;						//!< ms generated so far
+
+		double Delta(SV_Gen_S *_sv, double _t);				//!< SV time minus receiver time at receiver time _t
+		void SV_Position(Ephemeris_M *_ephem, double _t, double *_pos, double *_clock); //!< ECEF position & clock correction at GPS time _t
+		int32 NavBit(SV_Gen_S *_sv, int64 _bit);			//!< Get an absolute data bit, encoding subframes as needed
+		void Subframe(SV_Gen_S *_sv, int64 _subframe, uint8 *_bits);	//!< Encode a subframe into 300 bits
+		void Propagate(int32 _ms);							//!< Fill states[] for the next _ms
+		void Scale(SV_Gen_S *_sv);							//!< Build the scaled carrier table
+
+	public:
+
+		Signal_Gen(int32 _threads, uint32 _seed);			//!< Use this many worker threads, seed the noise
+		~Signal_Gen();
+		void SetTime(int32 _week, double _tow);				//!< GPS time of the first sample
+		void SetPosition(double _lat, double _lon, double _alt);	//!< Receiver position (deg, deg, m)
+		void SetNoise(float _sigma){sigma = _sigma;};		//!< Noise sigma, 0 turns the noise off
+		void SetNav(int32 _nav){nav_on = _nav;};			//!< Turn the navigation message on/off
+		int32 AddSV(int32 _sv, float _cn0, double _delay, double _doppler);	//!< Fixed Doppler SV, code phase _delay (chips) at t = 0
+		int32 AddSV(int32 _sv, float _cn0, Ephemeris_M *_ephem);			//!< Ephemeris driven SV
+		double Elevation(Ephemeris_M *_ephem);				//!< Elevation (deg) of the SV at the first sample
+		double GetDoppler(int32 _sv);						//!< Current Doppler (Hz) of the SV
+		double GetDelay(int32 _sv);							//!< Current code phase (chips) of the SV
+		int32 GetSVs(){return(nsvs);};						//!< Number of SVs
+		void Generate(CPX *_dest, int32 _ms);				//!< Generate the next _ms of IF
+		void Work(CPX *_dest, int32 _first, int32 _ms);		//!< Worker, generate ms [_first, _first + _ms) of the current block
+
+} Signal_Gen;
+
+#endif /*SIGNAL_GEN_H_*/
@@ -0,0 +1,89 @@
+/*! \file spsc.h
+	Defines the class SPSC_Queue
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef SPSC_H_
+#define SPSC_H_
+
+#define SPSC_PAD	(64)	//!< Keep the producer's and consumer's indices on separate cache lines
+
+/*! \ingroup CLASSES
+ * Fixed size ring between exactly one producer thread and one consumer thread. The producer only
+ * moves head and the consumer only moves tail, so neither side ever locks or blocks: Push() fails
+ * when the ring is full and Pop() fails when it is empty. N must be a power of two.
+ */
+template <class T, int32 N>
+class SPSC_Queue
+{
+
+	private:
+
+		T items[N];							//!< The ring
+		char pad0[SPSC_PAD];
+		volatile uint32 head;				//!< Next slot to fill, producer only
+		char pad1[SPSC_PAD];
+		volatile uint32 tail;				//!< Next slot to empty, consumer only
+
+	public:
+
+		SPSC_Queue(){head = tail = 0;};
+
+		/*! Producer side, copies the item in */
+		bool Push(T *_item)
+		{
+			uint32 h = head;
+
+			if((h - tail) >= (uint32)N)
+				return(false);
+
+			items[h & (N-1)] = *_item;
+
+			/* The item has to be visible before the new head is */
+			__sync_synchronize();
+			head = h + 1;
+
+			return(true);
+		};
+
+		/*! Consumer side, copies the item out */
+		bool Pop(T *_item)
+		{
+			uint32 t = tail;
+
+			if(head == t)
+				return(false);
+
+			/* Read the item only after seeing the head that covers it */
+			__sync_synchronize();
+			*_item = items[t & (N-1)];
+
+			/* And give the slot back only once it is read */
+			__sync_synchronize();
+			tail = t + 1;
+
+			return(true);
+		};
+
+		int32 Count(){return((int32)(head - tail));};	//!< Items waiting, either side may call it
+
+};
+
+#endif /*SPSC_H_*/
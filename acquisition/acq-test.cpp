@@ -40,7 +40,7 @@ void print_results(Acq_Command_M *_results);
 void usage(char *_str)
 {
 
-    fprintf(stderr, "usage: [-sv] [-s] [-m] [-w] [-min] [-max] [-f] [-r]\n");
+    fprintf(stderr, "usage: [-sv] [-s] [-m] [-w] [-l] [-dwell] [-min] [-max] [-f] [-r]\n");
     fprintf(stderr, "[-r] repeat forever \n");
     fprintf(stderr, "[-min] <Doppler> minimum Doppler (Hz) \n");
     fprintf(stderr, "[-max] <Doppler> maximum Doppler (Hz) \n");
@@ -49,6 +49,8 @@ void usage(char *_str)
     fprintf(stderr, "[-s] Strong signal, 1 ms  coherent integration \n");
     fprintf(stderr, "[-m] Medium signal, 10 ms coherent integration \n");
     fprintf(stderr, "[-w] Weak signal, 10 ms  coherent integration + 15 non-coherent integrations \n");
+    fprintf(stderr, "[-l] Ladder, strong then medium then weak until the SV is found \n");
+    fprintf(stderr, "[-dwell] <N> first weak stage sums only N ms, faster but less sensitive (1-15, default %d) \n", ACQ_WEAK_DWELL);
     fflush(stderr);
 
     exit(1);
@@ -73,6 +75,9 @@ void echo_options(Acquisition_test_options *_opt)
     	case 2:
     		fprintf(stderr, "Type:\t\t\tWeak signal\n");
 			break;
+    	case 3:
+    		fprintf(stderr, "Type:\t\t\tLadder\n");
+			break;
     }
 
     fflush(stderr);
@@ -125,6 +130,17 @@ int main(int32 argc, char* argv[])
 		{
 			acq_options.type = 2;
 		}
+		else if(!strcmp(argv[lcv], "-l"))
+		{
+			acq_options.type = 3;
+		}
+		else if(!strcmp(argv[lcv], "-dwell"))
+		{
+			lcv++;
+			if((lcv >= argc) || (atoi(argv[lcv]) < 1) || (atoi(argv[lcv]) > 15))
+				usage(argv[0]);
+			gopt.acq_dwell = atoi(argv[lcv]);
+		}
 		else if(!strcmp(argv[lcv], "-min"))
 		{
 			lcv++;
@@ -187,7 +203,6 @@ void run_acq(Acquisition_test_options *_opt)
 {
 	pthread_t pkey_thread;
 	FILE *fp = NULL;
-	CPX *buff_in;
 	CPX *buff;
 	char *p;
 	int *ip;
@@ -203,8 +218,7 @@ void run_acq(Acquisition_test_options *_opt)
     double dif;
 
 	memset(results, 0x0, sizeof(Acq_Command_M)*NUM_CODES);
-	buff = new CPX[310*SAMPS_MS];
-	buff_in = new CPX[310*IF_SAMPS_MS];
+	buff = new CPX[310*IF_SAMPS_MS];
 
 	/* Take care of file stuff */
 	if(!_opt->realtime)
@@ -218,26 +232,25 @@ void run_acq(Acquisition_test_options *_opt)
 		else
 		{
 
-			fread(buff_in, sizeof(CPX), 310*IF_SAMPS_MS, fp);
+			fread(buff, sizeof(CPX), 310*IF_SAMPS_MS, fp);
 			fclose(fp);
 
-			/* Downsample to 2048 samps/ms */
-			downsample(buff, buff_in, SAMPLE_FREQUENCY, IF_SAMPLE_FREQUENCY, IF_SAMPS_MS*310);
+			/* No resampling, Acquisition searches IF_SAMPS_MS samples per ms as they are */
 
 			printf("AGC Scale: %d\n",agc_scale);
 
 			agc_scale = 300;
 
 			/* Init AGC scale value */
-			init_agc(&buff[0], 10*SAMPS_MS, AGC_BITS, &agc_scale);
+			init_agc(&buff[0], 10*IF_SAMPS_MS, AGC_BITS, &agc_scale);
 
 			/* Now run it */
 			for(lcv = 0; lcv < 310; lcv++)
-				run_agc(&buff[lcv*SAMPS_MS], SAMPS_MS, AGC_BITS, &agc_scale);
+				run_agc(&buff[lcv*IF_SAMPS_MS], IF_SAMPS_MS, AGC_BITS, &agc_scale);
 		}
 
 		/* Now do the hard work? */
-		pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY);
+		pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY, 0);
 
 		pAcquisition->doPrepIF(_opt->type, buff);
 
@@ -257,12 +270,16 @@ void run_acq(Acquisition_test_options *_opt)
 				case 2:
 					results[sv] = pAcquisition->doAcqWeak(sv, _opt->doppler_min, _opt->doppler_max);
 					break;
+				case 3:
+					results[sv] = pAcquisition->doAcqLadder(sv, (1 << ACQ_STRONG) | (1 << ACQ_MEDIUM) | (1 << ACQ_WEAK), _opt->doppler_min, _opt->doppler_max);
+					break;
 				default:
 					fprintf(stderr, "Bad GPS acquisition type!\n");
 					exit(-1);
 			}
 
-			printf("SV: %02d\t%02d\t%10.2f\t%10.0f\t%15.0f\n",lcv+1, results[sv].type,results[sv].delay,results[sv].doppler,results[sv].magnitude);
+			printf("SV: %02d\t%02d\t%10.2f\t%10.0f\t%15.0f\t%8.1f\t%6.2f\t%d\n",sv+1, results[sv].type,results[sv].delay,results[sv].doppler,results[sv].magnitude,
+				results[sv].magnitude/results[sv].noise,results[sv].ratio,results[sv].success);
 
 		}
 		else	/* Loop over all SVs */
@@ -281,12 +298,16 @@ void run_acq(Acquisition_test_options *_opt)
 					case 2:
 						results[sv] = pAcquisition->doAcqWeak(sv, _opt->doppler_min, _opt->doppler_max);
 						break;
+					case 3:
+						results[sv] = pAcquisition->doAcqLadder(sv, (1 << ACQ_STRONG) | (1 << ACQ_MEDIUM) | (1 << ACQ_WEAK), _opt->doppler_min, _opt->doppler_max);
+						break;
 					default:
 						fprintf(stderr, "Bad GPS acquisition type!\n");
 						exit(-1);
 				}
 
-				printf("SV: %02d\t%02d\t%10.2f\t%10.0f\t%15.0f\n",lcv+1, results[sv].type,results[sv].delay,results[sv].doppler,results[sv].magnitude);
+				printf("SV: %02d\t%02d\t%10.2f\t%10.0f\t%15.0f\t%8.1f\t%6.2f\t%d\n",sv+1, results[sv].type,results[sv].delay,results[sv].doppler,results[sv].magnitude,
+					results[sv].magnitude/results[sv].noise,results[sv].ratio,results[sv].success);
 
 			}
 		}
@@ -317,7 +338,7 @@ void run_acq(Acquisition_test_options *_opt)
 		bytes_per_read = sizeof(CPX)*ms_per_read*IF_SAMPS_MS;
 
 		/* Now do the hard work? */
-		pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY);
+		pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY, 0);
 
 		while(grun)
 		{
@@ -337,7 +358,7 @@ void run_acq(Acquisition_test_options *_opt)
 			close(npipe);
 
 			for(lcv = 0; lcv < ms_per_read; lcv++)
-				run_agc(&buff[lcv*SAMPS_MS], SAMPS_MS, AGC_BITS, &agc_scale);
+				run_agc(&buff[lcv*IF_SAMPS_MS], IF_SAMPS_MS, AGC_BITS, &agc_scale);
 
 			/* Prep the IF Data */
 			pAcquisition->doPrepIF(_opt->type, buff);
@@ -357,6 +378,9 @@ void run_acq(Acquisition_test_options *_opt)
 					case 2:
 						results[sv] = pAcquisition->doAcqWeak(sv, _opt->doppler_min, _opt->doppler_max);
 						break;
+					case 3:
+						results[sv] = pAcquisition->doAcqLadder(sv, (1 << ACQ_STRONG) | (1 << ACQ_MEDIUM) | (1 << ACQ_WEAK), _opt->doppler_min, _opt->doppler_max);
+						break;
 					default:
 						fprintf(stderr, "Bad GPS acquisition type!\n");
 						exit(-1);
@@ -379,6 +403,9 @@ void run_acq(Acquisition_test_options *_opt)
 						case 2:
 							results[lcv] = pAcquisition->doAcqWeak(lcv, _opt->doppler_min, _opt->doppler_max);
 							break;
+						case 3:
+							results[lcv] = pAcquisition->doAcqLadder(lcv, (1 << ACQ_STRONG) | (1 << ACQ_MEDIUM) | (1 << ACQ_WEAK), _opt->doppler_min, _opt->doppler_max);
+							break;
 						default:
 							fprintf(stderr, "Bad GPS acquisition type!\n");
 							exit(-1);
@@ -397,7 +424,6 @@ void run_acq(Acquisition_test_options *_opt)
 	}
 
 	delete [] buff;
-	delete [] buff_in;
 	delete pAcquisition;
 
 }
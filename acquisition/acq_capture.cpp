@@ -0,0 +1,262 @@
+/*! \file acq_capture.cpp
+	Implements member functions of Acq_Capture class.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#include "acq_capture.h"
+
+/*----------------------------------------------------------------------------------------------*/
+void *Acq_Capture_Thread(void *_arg)
+{
+
+	Acq_Capture *aAcq_Capture = pAcq_Capture;
+
+	aAcq_Capture->SetPid();
+
+	while(grun)
+	{
+		aAcq_Capture->Import();
+		aAcq_Capture->IncExecTic();
+	}
+
+	pthread_exit(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Acq_Capture::Start()
+{
+	/* With priority/affinity given by Set_Scheduling() */
+	Start_Thread(Acq_Capture_Thread, NULL);
+
+	if(gopt.verbose)
+		printf("Acq_Capture thread started\n");
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Acq_Capture::Acq_Capture()
+{
+	int32 lcv;
+
+	for(lcv = 0; lcv < ACQ_WINDOWS; lcv++)
+	{
+		window[lcv] = new CPX[ACQ_WINDOW_MS*SAMPS_MS];
+		state[lcv] = ACQ_WINDOW_FREE;
+		searchers[lcv] = 0;
+		count[lcv] = 0;
+		stamp[lcv] = 0;
+	}
+
+	/* Our copy of the FIFO's packets, the bit-planes are not needed */
+	memset(&packet, 0x0, sizeof(ms_packet));
+	packet.data = new CPX[gopt.block_ms*SAMPS_MS];
+
+	fill = -1;
+	filled = 0;
+	last = 0;
+	fresh = false;
+	gating = false;
+
+	if(gopt.verbose)
+		printf("Creating Acq_Capture\n");
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Acq_Capture::~Acq_Capture()
+{
+	int32 lcv;
+
+	for(lcv = 0; lcv < ACQ_WINDOWS; lcv++)
+		delete [] window[lcv];
+
+	delete [] packet.data;
+
+	if(gopt.verbose)
+		printf("Destructing Acq_Capture\n");
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Start a free window if there is none being filled, then move one packet into it. With no free
+ * window (one searched, the other complete and waiting) the FIFO is let go until the search is
+ * done. Completing a window frees the older complete one, it is only kept until a fresher exists,
+ * or until the last worker searching it lets go.
+ *
+ * The FIFO only holds its tail for the capture (gAcq_high) while a window is needed, that is while
+ * no complete window is waiting that a request has not started on yet. Otherwise the capture runs
+ * behind the correlators and a packet it misses just starts the window again.
+ */
+void Acq_Capture::Import()
+{
+	int32 lcv, nms, need;
+
+	if(fill == -1)
+	{
+		Lock();
+		for(lcv = 0; lcv < ACQ_WINDOWS; lcv++)
+			if(state[lcv] == ACQ_WINDOW_FREE)
+			{
+				fill = lcv;
+				state[lcv] = ACQ_WINDOW_FILL;
+				break;
+			}
+		Unlock();
+
+		if(fill == -1)
+		{
+			Gate(false);
+			usleep(ACQ_CAPTURE_SLEEP);
+			return;
+		}
+
+		filled = 0;
+	}
+
+	/* A request waiting in Take(), or about to search a window it has already had */
+	Lock();
+	need = !fresh;
+	Unlock();
+
+	Gate(need);
+
+	/* Get the tail */
+	pFIFO->Dequeue(MAX_CHANNELS, &packet);
+	while((packet.count == last) && grun)
+	{
+		usleep(250);
+		pFIFO->Dequeue(MAX_CHANNELS, &packet);
+	}
+
+	IncStartTic();
+
+	IncLag(packet.stamp);
+
+	/* Detect broken packets, recollect the window */
+	if((filled > 0) && ((packet.count - last) != packet.ms))
+		filled = 0;
+
+	if(filled == 0)
+	{
+		count[fill] = packet.count;
+		stamp[fill] = packet.stamp;
+	}
+
+	/* Take as much of the block as is still needed */
+	nms = ACQ_WINDOW_MS - filled;
+	if(nms > packet.ms)
+		nms = packet.ms;
+
+	memcpy(&window[fill][SAMPS_MS*filled], &packet.data[0], nms*SAMPS_MS*sizeof(CPX));
+
+	filled += nms;
+	last = packet.count;
+
+	if(filled == ACQ_WINDOW_MS)
+	{
+		Lock();
+		for(lcv = 0; lcv < ACQ_WINDOWS; lcv++)
+			if(state[lcv] == ACQ_WINDOW_READY)
+				state[lcv] = searchers[lcv] ? ACQ_WINDOW_SEARCH : ACQ_WINDOW_FREE;
+		state[fill] = ACQ_WINDOW_READY;
+		fresh = true;
+		Unlock();
+
+		fill = -1;
+	}
+
+	IncStopTic();
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Make the FIFO wait on the capture or not, only touching gAcq_high when that changes.
+ */
+void Acq_Capture::Gate(int32 _on)
+{
+	if(_on == gating)
+		return;
+
+	pthread_mutex_lock(&mAcq);
+	gAcq_high = _on;
+	pthread_mutex_unlock(&mAcq);
+
+	gating = _on;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Only ever one window is complete and waiting, returns it or -1 if the receiver is shutting
+ * down first.
+ */
+int32 Acq_Capture::Take()
+{
+	int32 lcv, ready;
+
+	ready = -1;
+	while(grun)
+	{
+		Lock();
+		for(lcv = 0; lcv < ACQ_WINDOWS; lcv++)
+			if(state[lcv] == ACQ_WINDOW_READY)
+			{
+				ready = lcv;
+				searchers[lcv]++;
+				fresh = false;
+				break;
+			}
+		Unlock();
+
+		if(ready != -1)
+			break;
+
+		usleep(ACQ_CAPTURE_SLEEP);
+	}
+
+	return(ready);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * The window stays the one handed out next unless a fresher one completed during the search, the
+ * same IF serves any SV and Acquisition::Export() tells the correlator how old it is.
+ */
+void Acq_Capture::Release(int32 _window)
+{
+	Lock();
+	searchers[_window]--;
+	if((searchers[_window] == 0) && (state[_window] == ACQ_WINDOW_SEARCH))
+		state[_window] = ACQ_WINDOW_FREE;
+	Unlock();
+}
+/*----------------------------------------------------------------------------------------------*/
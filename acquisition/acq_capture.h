@@ -0,0 +1,69 @@
+/*! \file acq_capture.h
+	Defines the class Acq_Capture
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef ACQ_CAPTURE_H_
+#define ACQ_CAPTURE_H_
+
+#include "includes.h"
+
+/*! \ingroup CLASSES
+ * With -capture the acquisition no longer collects its own IF after each request. This thread
+ * keeps ACQ_WINDOWS windows of ACQ_WINDOW_MS ms, filling whichever window is neither being
+ * searched nor the newest complete one. A request starts straight away on the newest complete
+ * window while the next one is captured behind the search, and a window is searched again by
+ * the following requests until a fresher one is complete. Several workers (-acq_workers) may
+ * search the same window at once. The FIFO only waits on the capture while no request has a
+ * fresh window to start on, otherwise the capture takes what packets it gets.
+ */
+class Acq_Capture : public Threaded_Object
+{
+
+	private:
+
+		ms_packet packet;						//!< Our copy of the FIFO's packets
+		CPX *window[ACQ_WINDOWS];				//!< The IF windows
+		int32 state[ACQ_WINDOWS];				//!< ACQ_WINDOW_FREE, _FILL, _READY or _SEARCH
+		int32 searchers[ACQ_WINDOWS];			//!< Acquisition workers searching each window
+		int32 count[ACQ_WINDOWS];				//!< Packet count of the first ms of each window
+		uint64 stamp[ACQ_WINDOWS];				//!< When the first ms of each window was enqueued
+		int32 fill;								//!< Window being filled, -1 for none
+		int32 filled;							//!< ms of it filled so far
+		int32 last;								//!< Count of the last packet taken
+		int32 fresh;							//!< The complete window has not been handed out yet
+		int32 gating;							//!< What gAcq_high was last set to
+
+	public:
+
+		Acq_Capture();
+		~Acq_Capture();
+		void Start();							//!< Start the thread
+		void Import();							//!< Move the next FIFO packet into the window being filled
+		void Gate(int32 _on);					//!< Set gAcq_high, whether the FIFO waits on the capture
+		int32 Take();							//!< Pend on the newest complete window and hand it to the search
+		void Release(int32 _window);			//!< The search is done with this window
+		CPX *getWindow(int32 _window){return(window[_window]);};		//!< The window's IF
+		int32 getCount(int32 _window){return(count[_window]);};		//!< Packet count of its first ms
+		uint64 getStamp(int32 _window){return(stamp[_window]);};		//!< Enqueue time of its first ms
+
+};
+
+#endif /* ACQ_CAPTURE_H_ */
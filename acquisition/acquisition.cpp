@@ -18,7 +18,6 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 ************************************************************************************************/
 
 #include "includes.h"
-#include "prn_codes.h"	//!< Include the pre-fftd PRN codes (done with MATLAB)
 
 //#define ACQ_DEBUG
 
@@ -26,7 +25,7 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 void *Acquisition_Thread(void *_arg)
 {
 
-	Acquisition *aAcquisition = pAcquisition;
+	Acquisition *aAcquisition = pAcquisition[*(int32 *)_arg];
 
 	aAcquisition->SetPid();
 
@@ -47,8 +46,8 @@ void *Acquisition_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Acquisition::Start()
 {
-	/* With new priority specified */
-	Start_Thread(Acquisition_Thread, NULL);
+	/* With priority/affinity given by Set_Scheduling() */
+	Start_Thread(Acquisition_Thread, &worker);
 
 	if(gopt.verbose)
 		printf("Acquisition thread started\n");
@@ -60,7 +59,7 @@ void Acquisition::Start()
 /*!
  * Acquisition(): Constructor
  * */
-Acquisition::Acquisition(float _fsample, float _fif)
+Acquisition::Acquisition(float _fsample, float _fif, int32 _worker)
 {
 
 	int32 lcv, lcv2;
@@ -69,40 +68,75 @@ Acquisition::Acquisition(float _fsample, float _fif)
 	int32 R2[16] = {0,0,0,0,0,0,0,1,0,1,0,1,1,1,1,1};
 
 	/* Acq state */
+	worker = _worker;
 	sv = 0;
 	state = ACQ_STRONG;
+	ncross = 0;
+	PeakClear();
 
 	/* Grab some constants */
 	fif = _fif;
-	fbase = SAMPLE_FREQUENCY;
 	fsample = _fsample;
 	samps_ms = (int32)ceil(fsample/1000.0);
 
-	/* Resample to the nearest 2^N */
-	resamps_ms = SAMPS_MS; //Always decimate to 2048 samples/ms for C/A code
+	/* Searched at the rate it comes in, the FFT takes any even 2^a 3^b 5^c samples per ms, 2048 from the FIFO */
+	resamps_ms = samps_ms;
+	fbase = (float)resamps_ms*1000.0;
+	exclude = ACQ_PEAK_EXCLUDE*resamps_ms/SAMPS_MS;
+	weak_dwell = gopt.acq_dwell ? gopt.acq_dwell : ACQ_WEAK_DWELL;
+
+	/* Both the full rate and the coarse stage's FFT have to take it */
+	if(!FFT::Length(resamps_ms) || (resamps_ms % ACQ_COARSE) || !FFT::Length(resamps_ms/ACQ_COARSE))
+	{
+		fprintf(stderr, "Acquisition: cannot search %d samples/ms, it and 1/%d of it must be even 2^a 3^b 5^c\n", resamps_ms, ACQ_COARSE);
+		exit(1);
+	}
+
+	/* Step one, FFT the codes, or read them back from the last run */
+	codes = new CPX[NUM_CODES_WAAS * resamps_ms];
+	for(lcv = 0; lcv < NUM_CODES_WAAS; lcv++)
+		fft_codes[lcv] = &codes[lcv*resamps_ms];
+
+	if(!ReadCodes())
+	{
+		GenCodes();
+		WriteCodes();
+	}
 
-	/* Step one, grab pre-fftd codes from header file */
+	/* And the middle coarse_ms bins of each for the coarse stage, see doCorr() */
+	coarse_ms = resamps_ms/ACQ_COARSE;
+	coarse_codes = new CPX[NUM_CODES_WAAS * coarse_ms];
 	for(lcv = 0; lcv < NUM_CODES_WAAS; lcv++)
-		fft_codes[lcv] = (CPX *)&PRN_Codes[2*lcv*resamps_ms];
+	{
+		memcpy(&coarse_codes[lcv*coarse_ms], fft_codes[lcv], coarse_ms/2*sizeof(CPX));
+		memcpy(&coarse_codes[lcv*coarse_ms + coarse_ms/2], fft_codes[lcv] + resamps_ms - coarse_ms/2, coarse_ms/2*sizeof(CPX));
+	}
 
-	/* Allocate some buffers that will be used later on */
-	buff	 = new CPX[310 * resamps_ms];
+	/* Allocate some buffers that will be used later on, with -capture the IF comes in Acq_Capture's windows */
+	collect  = gopt.acq_capture ? NULL : new CPX[310 * resamps_ms];
+	buff	 = collect;
+	window   = -1;
 	rotate   = new CPX[resamps_ms];
 	msbuff   = new CPX[resamps_ms];
 	power    = new CPX[10 * resamps_ms];
 	coherent = new CPX[10 * resamps_ms];
-	baseband = new CPX[4 * 310 * resamps_ms];
-	_000Hzwipeoff = new CPX[310 * resamps_ms];
-	_250Hzwipeoff = new CPX[310 * resamps_ms];
-	_500Hzwipeoff = new CPX[310 * resamps_ms];
-	_750Hzwipeoff = new CPX[310 * resamps_ms];
+	wipeoff  = new CPX[4 * ACQ_WIPE_MS * resamps_ms];
+	peak_blocks = new int32[(10 * resamps_ms + PEAK_BLOCK - 1) / PEAK_BLOCK];
 
-	/* Allocate baseband shift vector and map of the row pointers */
-	baseband_shift = new CPX[4 * 310 * (resamps_ms+201)];
-	baseband_rows = new CPX *[1240];
-	for(lcv = 0; lcv < 1240; lcv++)
+	/* Our copy of the FIFO's packets, the bit-planes are not needed */
+	memset(&packet, 0x0, sizeof(ms_packet));
+	packet.data = new CPX[gopt.block_ms*SAMPS_MS];
+
+	/* Allocate baseband shift vector and map of the row pointers, only one 250 Hz offset is held at a time */
+	baseband_shift = new CPX[310 * (resamps_ms+201)];
+	baseband_rows = new CPX *[310];
+	for(lcv = 0; lcv < 310; lcv++)
 		baseband_rows[lcv] = &baseband_shift[lcv*(resamps_ms+201)];
 
+	prep_buff = buff;
+	prep_ms = 1;
+	prep_offset = -1;
+
 	/* Allocate baseband shift vector and map of the row pointers */
 	dft = new MIX[10*10];
 	dft_rows = new MIX *[10];
@@ -113,28 +147,23 @@ Acquisition::Acquisition(float _fsample, float _fif)
 	for(lcv = 0; lcv < 10; lcv++)
 		wipeoff_gen(dft_rows[lcv], (float)lcv*25.0 - 112.5, 1000.0, 10);
 
-	/* Generate mix to baseband */
-	sine_gen(_000Hzwipeoff, -fif, SAMPLE_FREQUENCY, 10*resamps_ms);
-
-	/* Generate 250 Hz offset wipeoff */
-	sine_gen(_250Hzwipeoff, -fif-250.0, SAMPLE_FREQUENCY, 10*resamps_ms);
-	sine_gen(_500Hzwipeoff, -fif-500.0, SAMPLE_FREQUENCY, 10*resamps_ms);
-	sine_gen(_750Hzwipeoff, -fif-750.0, SAMPLE_FREQUENCY, 10*resamps_ms);
-
-	/* Copy to all 310 ms */
-	for(lcv = 1; lcv < 31; lcv++)
-	{
-		memcpy(&_000Hzwipeoff[lcv*10*resamps_ms],_000Hzwipeoff,10*resamps_ms*sizeof(CPX));
-		memcpy(&_250Hzwipeoff[lcv*10*resamps_ms],_250Hzwipeoff,10*resamps_ms*sizeof(CPX));
-		memcpy(&_500Hzwipeoff[lcv*10*resamps_ms],_500Hzwipeoff,10*resamps_ms*sizeof(CPX));
-		memcpy(&_750Hzwipeoff[lcv*10*resamps_ms],_750Hzwipeoff,10*resamps_ms*sizeof(CPX));
-	}
+	/* Generate the mix to baseband and the 250, 500 & 750 Hz offsets, one period each, doPrepRows() indexes them modulo ACQ_WIPE_MS */
+	for(lcv = 0; lcv < 4; lcv++)
+		sine_gen(&wipeoff[lcv*ACQ_WIPE_MS*resamps_ms], -fif-250.0*lcv, fbase, ACQ_WIPE_MS*resamps_ms);
 
 	/* Allocate the FFTs */
 	pFFT = new FFT(resamps_ms, R1);
 	piFFT = new FFT(resamps_ms, R2);
+	pdFFT = new FFT(coarse_ms, R2);
 	pcFFT = new FFT(32);
 
+	/* R2 is for radix 2 ranks, other lengths keep the gain it leaves 1024 points, see ACQ_IFFT_GAIN */
+	if(resamps_ms & (resamps_ms - 1))
+	{
+		piFFT->setGain(ACQ_IFFT_GAIN);
+		pdFFT->setGain(ACQ_IFFT_GAIN);
+	}
+
 	if(gopt.verbose)
 		printf("Creating Acquisition\n");
 
@@ -153,22 +182,23 @@ Acquisition::~Acquisition()
 
 	delete pFFT;
 	delete piFFT;
+	delete pdFFT;
 	delete pcFFT;
 
-	delete [] buff;
+	delete [] codes;
+	delete [] coarse_codes;
+	delete [] collect;
 	delete [] rotate;
 	delete [] msbuff;
-	delete [] baseband;
 	delete [] baseband_shift;
 	delete [] baseband_rows;
 	delete [] coherent;
 	delete [] power;
+	delete [] peak_blocks;
 	delete [] dft;
 	delete [] dft_rows;
-	delete [] _000Hzwipeoff;
-	delete [] _250Hzwipeoff;
-	delete [] _500Hzwipeoff;
-	delete [] _750Hzwipeoff;
+	delete [] wipeoff;
+	delete [] packet.data;
 
 	#ifdef ACQ_DEBUG
 		close(acq_pipe);
@@ -183,14 +213,156 @@ Acquisition::~Acquisition()
 
 /*----------------------------------------------------------------------------------------------*/
 /*!
- * doPrepIF: Complete all of the upfront IF processing, iAGC_BITSncludes: reampling the buffer, mixiing to baseband, 25-Hz, 500 Hz, and 750 Hz, computing the forward FFT, then
- * copying the FFTd data into a 2-D matrix. The matrix is created in such a way to allow the circular-rotation trick to be carried out without repeatedly calling "doRotate"
+ * GenCodes: Sample each code at resamps_ms per ms, FFT it with the receiver's own FFT and conjugate it, then scale all of
+ * them together so the largest bin of any code is 2^ACQ_CODE_BITS. The shifts of the sse_cmulsc() calls below count on that.
  * */
-void Acquisition::doPrepIF(int32 _type, CPX *_buff)
+void Acquisition::GenCodes()
 {
 
-	int32 lcv, ms;
+	int32 lcv, lcv2, chip;
+	float mag, max, scale;
+	CPX chips[CODE_CHIPS];
 	CPX *p;
+	FFT *pCodeFFT;
+
+	/* Every rank scaled, the codes go in at nearly full scale so little is lost to the shifts */
+	pCodeFFT = new FFT(resamps_ms);
+
+	max = 0;
+	for(lcv = 0; lcv < NUM_CODES_WAAS; lcv++)
+	{
+		code_gen(&chips[0], lcv);
+
+		p = fft_codes[lcv];
+		for(lcv2 = 0; lcv2 < resamps_ms; lcv2++)
+		{
+			chip = (int32)(((int64)lcv2*CODE_CHIPS)/resamps_ms);
+			p[lcv2].i = chips[chip].i ? 16383 : -16383;
+			p[lcv2].q = 0;
+		}
+
+		pCodeFFT->doFFT(p, true);
+
+		for(lcv2 = 0; lcv2 < resamps_ms; lcv2++)
+		{
+			mag = sqrt((float)p[lcv2].i*(float)p[lcv2].i + (float)p[lcv2].q*(float)p[lcv2].q);
+			if(mag > max)
+				max = mag;
+		}
+	}
+
+	scale = (float)(1 << ACQ_CODE_BITS)/max;
+
+	for(lcv = 0; lcv < NUM_CODES_WAAS*resamps_ms; lcv++)
+	{
+		codes[lcv].i = (int16)round( scale*(float)codes[lcv].i);
+		codes[lcv].q = (int16)round(-scale*(float)codes[lcv].q);
+	}
+
+	delete pCodeFFT;
+
+	if(gopt.verbose)
+		printf("Generated FFT'd PRN codes for %d samples/ms\n", resamps_ms);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * CodesHeader: Everything GenCodes() output depends on, ACQ_CODE_VERSION, resamps_ms, NUM_CODES_WAAS, ACQ_CODE_BITS,
+ * then the number of ranks of its FFT and their radix & scaling.
+ * */
+void Acquisition::CodesHeader(int32 *_hdr)
+{
+
+	FFT *pCodeFFT;
+
+	/* The same FFT as GenCodes() */
+	pCodeFFT = new FFT(resamps_ms);
+
+	_hdr[0] = ACQ_CODE_VERSION;
+	_hdr[1] = resamps_ms;
+	_hdr[2] = NUM_CODES_WAAS;
+	_hdr[3] = ACQ_CODE_BITS;
+	_hdr[4] = pCodeFFT->getRanks(&_hdr[5], &_hdr[5+MAX_RANKS]);
+
+	delete pCodeFFT;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * ReadCodes: Read the FFT'd codes back from ACQ_CODE_FILE, false if it is missing or its header is not CodesHeader()
+ * */
+bool Acquisition::ReadCodes()
+{
+
+	FILE *fp;
+	char fname[64];
+	int32 hdr[ACQ_CODE_HDR];
+	int32 want[ACQ_CODE_HDR];
+	bool ok;
+
+	sprintf(fname, ACQ_CODE_FILE, resamps_ms);
+
+	fp = fopen(fname, "rb");
+	if(fp == NULL)
+		return(false);
+
+	CodesHeader(&want[0]);
+
+	ok = (fread(&hdr[0], sizeof(int32), ACQ_CODE_HDR, fp) == ACQ_CODE_HDR);
+	ok = ok && (memcmp(&hdr[0], &want[0], ACQ_CODE_HDR*sizeof(int32)) == 0);
+	ok = ok && (fread(codes, sizeof(CPX), NUM_CODES_WAAS*resamps_ms, fp) == (size_t)(NUM_CODES_WAAS*resamps_ms));
+
+	fclose(fp);
+
+	return(ok);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * WriteCodes: Cache the FFT'd codes in ACQ_CODE_FILE, the next start skips GenCodes(). Not being able to write it is not an error.
+ * */
+void Acquisition::WriteCodes()
+{
+
+	FILE *fp;
+	char fname[64];
+	int32 hdr[ACQ_CODE_HDR];
+
+	sprintf(fname, ACQ_CODE_FILE, resamps_ms);
+
+	fp = fopen(fname, "wb");
+	if(fp == NULL)
+		return;
+
+	CodesHeader(&hdr[0]);
+
+	fwrite(&hdr[0], sizeof(int32), ACQ_CODE_HDR, fp);
+	fwrite(codes, sizeof(CPX), NUM_CODES_WAAS*resamps_ms, fp);
+
+	fclose(fp);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doPrepIF: Point the search at the IF. The mixing & FFTs are left to doPrepRows(), one 250 Hz offset at a time, so _buff
+ * must stay put until the searches on it are done.
+ * */
+void Acquisition::doPrepIF(int32 _type, CPX *_buff)
+{
+
+	int32 ms;
 
 	switch(_type)
 	{
@@ -207,93 +379,206 @@ void Acquisition::doPrepIF(int32 _type, CPX *_buff)
 			ms = 1;
 	}
 
-	/* 1) Import data */
-	memcpy(baseband, _buff, ms*resamps_ms*sizeof(CPX));
+	prep_buff = _buff;
+	prep_ms = ms;
+	prep_offset = -1;
 
-	/* Do the 250 Hz offsets */
-	sse_cmulsc(&baseband[0], _250Hzwipeoff, &baseband[ms*resamps_ms],   ms*resamps_ms, 14);
-	sse_cmulsc(&baseband[0], _500Hzwipeoff, &baseband[2*ms*resamps_ms], ms*resamps_ms, 14);
-	sse_cmulsc(&baseband[0], _750Hzwipeoff, &baseband[3*ms*resamps_ms], ms*resamps_ms, 14);
+}
+/*----------------------------------------------------------------------------------------------*/
 
-	/* Mix down to baseband */
-	sse_cmuls(baseband, _000Hzwipeoff, ms*resamps_ms, 14);
 
-	/* Compute forward FFT of IF data */
-	for(lcv = 0; lcv < 4*ms; lcv++)
-		pFFT->doFFT(&baseband[lcv*resamps_ms], true);
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doPrepRows: Mix each ms of the IF down by Fif + 250*_offset Hz, compute the forward FFT, then copy the FFTd data into a 2-D
+ * matrix, one ms at a time through msbuff. The matrix is created in such a way to allow the circular-rotation trick to be carried out
+ * without repeatedly calling "doRotate". Only one offset is held, the searches below go through the offsets in their outer loop.
+ * */
+void Acquisition::doPrepRows(int32 _offset)
+{
 
-	/* Now copy into the rows */
-	for(lcv = 0; lcv < 4*ms; lcv++)
+	int32 lcv;
+	CPX *p;
+
+	if(_offset == prep_offset)
+		return;
+
+	for(lcv = 0; lcv < prep_ms; lcv++)
 	{
+		/* Mix down, the wipeoff repeats every ACQ_WIPE_MS */
+		sse_cmulsc(&prep_buff[lcv*resamps_ms], &wipeoff[(_offset*ACQ_WIPE_MS + lcv%ACQ_WIPE_MS)*resamps_ms], msbuff, resamps_ms, 14);
+
+		/* Compute forward FFT of IF data */
+		pFFT->doFFT(msbuff, true);
+
+		/* Now copy into the row */
 		p = baseband_rows[lcv];
-		memcpy(p, 				 &baseband[(lcv+1)*resamps_ms-100], 100*sizeof(CPX));
-		memcpy(p+100,	 		 &baseband[lcv*resamps_ms],			resamps_ms*sizeof(CPX));
-		memcpy(p+100+resamps_ms, &baseband[lcv*resamps_ms],			100*sizeof(CPX));
+		memcpy(p, 				 &msbuff[resamps_ms-100], 	100*sizeof(CPX));
+		memcpy(p+100,	 		 msbuff,					resamps_ms*sizeof(CPX));
+		memcpy(p+100+resamps_ms, msbuff,					100*sizeof(CPX));
 	}
 
+	prep_offset = _offset;
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
 /*!
- * doAcqStrong: Acquire using a 1 ms coherent integration
+ * PeakClear: Start a search with no peaks and no power
  * */
-Acq_Command_M Acquisition::doAcqStrong(int32 _sv, int32 _doppmin, int32 _doppmax)
+void Acquisition::PeakClear()
 {
 
-	FILE *fp;
-	int32 lcv, lcv2, mag, magt, index, indext;
-	Acq_Command_M *result = &results[_sv];
-	CPX *p;
+	int32 lcv;
 
-	index = indext = mag = magt = 0;
+	for(lcv = 0; lcv < ACQ_PEAKS; lcv++)
+	{
+		peaks[lcv].mag = 0;
+		peaks[lcv].index = 0;
+		peaks[lcv].doppler = 0;
+	}
 
-	/* Covers the 250 Hz spacing */
-	for(lcv = (_doppmin/1000); lcv <  (_doppmax/1000); lcv++)
+	noise_sum = 0;
+	noise_cnt = 0;
+	cells = 0;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * PeakAdd: Take the largest peaks of one Doppler cell's powers (rows of _row samples, the first row at
+ * _doppler and each next one _spacing Hz up) and merge them into the search's. Code phases are kept
+ * in samples of resamps_ms whatever _row the cell was correlated at. A peak within
+ * exclude samples of code phase of a kept one is the same signal leaking into a
+ * neighbouring Doppler, only the larger of the two is kept. With _cross a peak within 100 Hz of a
+ * strong SV already being tracked is taken for a cross correlation and dropped.
+ * */
+void Acquisition::PeakAdd(int32 *_power, int32 _cnt, int32 _row, float _doppler, float _spacing, bool _cross)
+{
+
+	int32 index[ACQ_PEAKS], mag[ACQ_PEAKS];
+	int32 lcv, lcv2, j, d, code;
+	float dopp;
+	bool skip;
+	int64 sum;
+
+	x86_peaks(_power, _cnt, _row, exclude*_row/resamps_ms, ACQ_PEAKS, index, mag, &sum, peak_blocks);
+
+	PeakCount(sum, _cnt);
+
+	for(lcv = 0; lcv < ACQ_PEAKS; lcv++)
 	{
-		/* Sweep through the doppler range */
-		for(lcv2 = 0; lcv2 < 4; lcv2+=1)
-		{
+		/* Largest first, once one is too small so are the rest */
+		if(mag[lcv] <= peaks[ACQ_PEAKS-1].mag)
+			break;
 
-			if(gopt.realtime)
-				usleep(1000);
+		code = (index[lcv] % _row)*(resamps_ms/_row);
+		dopp = _doppler + (float)(index[lcv] / _row)*_spacing;
 
-			/* Multiply in frequency domain, shifting appropiately */
-			sse_cmulsc(&baseband_rows[lcv2][100+lcv], fft_codes[_sv], msbuff, resamps_ms, 10);
+		skip = false;
 
-			/* Compute iFFT */
-			piFFT->doiFFT(msbuff, true);
+		if(_cross)
+			for(j = 0; j < ncross; j++)
+				if(fabs(dopp - (float)cross_doppler[j]) < 100.0)
+					skip = true;
 
-			/* Convert to a power */
-			x86_cmag(msbuff, resamps_ms);
+		/* Already have it, at least as large */
+		for(j = 0; j < ACQ_PEAKS; j++)
+		{
+			d = abs(code - peaks[j].index);
+			if((peaks[j].mag > 0) && ((d <= exclude) || ((resamps_ms - d) <= exclude)) && (peaks[j].mag >= mag[lcv]))
+				skip = true;
+		}
 
-			/* Find the maximum */
-			x86_max((int32 *)msbuff, &indext, &magt, resamps_ms);
+		if(skip)
+			continue;
 
-			/* Found a new maximum */
-			if(magt > mag)
+		/* Drop the smaller ones it replaces */
+		for(j = 0; j < ACQ_PEAKS; j++)
+		{
+			d = abs(code - peaks[j].index);
+			if((peaks[j].mag > 0) && ((d <= exclude) || ((resamps_ms - d) <= exclude)))
 			{
-				mag = magt;
-				index = indext;
-				result->delay = CODE_CHIPS - (float)index*CODE_RATE/fbase;
-				result->doppler = (float)(lcv*1000) + (float)lcv2*250;
-				result->magnitude = (float)mag;
+				for(lcv2 = j; lcv2 < ACQ_PEAKS-1; lcv2++)
+					peaks[lcv2] = peaks[lcv2+1];
+				peaks[ACQ_PEAKS-1].mag = 0;
+				j--;
 			}
-
 		}
+
+		/* Insert in order, ties stay behind the earlier peak */
+		for(j = ACQ_PEAKS-1; (j > 0) && (peaks[j-1].mag < mag[lcv]); j--)
+			peaks[j] = peaks[j-1];
+
+		peaks[j].mag = mag[lcv];
+		peaks[j].index = code;
+		peaks[j].doppler = dopp;
 	}
 
-	result->sv = _sv;
+}
+/*----------------------------------------------------------------------------------------------*/
 
-	result->type = ACQ_STRONG;
 
-	if(result->magnitude > THRESH_STRONG)
-		result->success = 1;
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * PeakCount: Add _cnt powers totalling _sum to the noise of the search, PeakAdd() does it for every cell, and a cell whose
+ * largest power is too small to make the peaks only needs this
+ * */
+void Acquisition::PeakCount(int64 _sum, int32 _cnt)
+{
+
+	noise_sum += _sum;
+	noise_cnt += _cnt;
+	cells++;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * PeakResult: The largest peak is the answer. It is a detection when it stands _cfar times above
+ * the mean power of the whole search (a constant false alarm rate, whatever the AGC does to the
+ * scale) and ACQ_PEAK_RATIO times above the next peak, which is what a false peak in the noise or
+ * a cross correlation does not do.
+ * */
+void Acquisition::PeakResult(Acq_Command_M *_result, float _cfar)
+{
+
+	_result->delay = CODE_CHIPS - (float)peaks[0].index*CODE_RATE/fbase;
+	_result->doppler = peaks[0].doppler;
+	_result->magnitude = (float)peaks[0].mag;
+	_result->noise = noise_cnt ? (float)((double)noise_sum/(double)noise_cnt) : 0.0;
+	_result->ratio = (float)peaks[0].mag/(float)((peaks[1].mag > 0) ? peaks[1].mag : 1);
+
+	if((_result->magnitude > _cfar*_result->noise) && (_result->ratio > ACQ_PEAK_RATIO))
+		_result->success = 1;
 	else
-		result->success = 0;
+		_result->success = 0;
+
+}
+/*----------------------------------------------------------------------------------------------*/
 
-	return(results[_sv]);
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * PeakSure: True once the search so far passes both tests of PeakResult() by ACQ_SURE, the rest of it could only add
+ * a larger peak elsewhere, which is not what a signal this far above the noise leaves room for
+ * */
+bool Acquisition::PeakSure(float _cfar)
+{
+
+	double noise;
+
+	if(cells < ACQ_SURE_CELLS)
+		return(false);
+
+	noise = (double)noise_sum/(double)noise_cnt;
+
+	return(((double)peaks[0].mag > ACQ_SURE*_cfar*noise) && ((double)peaks[0].mag > ACQ_SURE*ACQ_PEAK_RATIO*(double)peaks[1].mag));
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -301,12 +586,109 @@ Acq_Command_M Acquisition::doAcqStrong(int32 _sv, int32 _doppmin, int32 _doppmax
 
 /*----------------------------------------------------------------------------------------------*/
 /*!
- * doAcqMedium: Acquire using a 10 ms coherent integrationACQ_WEAK
+ * Cfar: The detection threshold of a _type search over _doppmin to _doppmax. The largest power of noise alone grows with
+ * the log of the cells searched (Doppler kHz times code phases), so the thresholds set for a cold search of ACQ_CFAR_CELLS
+ * move by ACQ_CFAR_*_LOG per e-fold of cells. That holds their false alarm rate for a hot search and at any resamps_ms.
  * */
-Acq_Command_M Acquisition::doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax)
+float Acquisition::Cfar(int32 _type, int32 _doppmin, int32 _doppmax)
 {
-	Acq_Command_M *result;
-	int32 lcv, lcv2, lcv3, mag, magt, index, indext, j, k, dopp, skip;
+
+	double cells, cfar, slope;
+
+	cells = (double)(((_doppmax - _doppmin) >= 1000) ? (_doppmax - _doppmin)/1000 : 1)*(double)resamps_ms;
+
+	switch(_type)
+	{
+		case ACQ_STRONG:
+			cfar = ACQ_CFAR_STRONG;
+			slope = ACQ_CFAR_STRONG_LOG;
+			break;
+		case ACQ_MEDIUM:
+			cfar = ACQ_CFAR_MEDIUM;
+			slope = ACQ_CFAR_MEDIUM_LOG;
+			break;
+		default:
+			cfar = ACQ_CFAR_WEAK;
+			slope = ACQ_CFAR_WEAK_LOG;
+			break;
+	}
+
+	return((float)(cfar + slope*log(cells/(double)ACQ_CFAR_CELLS)));
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doCorr: Correlate one ms row of FFTd IF (_row points at its bin 0) against _sv's code into _out. With _n < resamps_ms
+ * only the middle _n bins are kept, the lowest _n/2 and the highest _n/2 (the negative frequencies). That is an ideal
+ * lowpass to _n/2 kHz each side, so the _n point iFFT comes out decimated by resamps_ms/_n for the coarse stage. It keeps
+ * the scaling of the full rate iFFT, most of the code's power is in the bins kept, so the sums of weak cannot overflow.
+ * With _max the powers come back in _out instead, with their max and total, see FFT::doiFFTpow().
+ * */
+void Acquisition::doCorr(CPX *_row, int32 _sv, CPX *_out, int32 _n, int32 _shift, int32 *_max, int64 *_sum)
+{
+
+	FFT *pfft;
+	CPX *code;
+
+	if(_n == resamps_ms)
+	{
+		pfft = piFFT;
+		code = fft_codes[_sv];
+	}
+	else
+	{
+		pfft = pdFFT;
+		code = &coarse_codes[_sv*_n];
+	}
+
+	/* The multiply is folded into the iFFT, the high bins are the last _n/2 of the row */
+	if(_max)
+		pfft->doiFFTpow(_row, _row + resamps_ms - _n/2, code, _shift, _out, _max, _sum);
+	else
+		pfft->doiFFTmul(_row, _row + resamps_ms - _n/2, code, _shift, _out);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doCellStrong: One 1 ms Doppler cell, _bin kHz + _offset*250 Hz, correlated at _n samples per ms
+ * */
+void Acquisition::doCellStrong(int32 _sv, int32 _bin, int32 _offset, int32 _n)
+{
+
+	int32 max;
+	int64 sum;
+
+	if(gopt.realtime)
+		usleep(1000);
+
+	/* Multiply in frequency domain, shifting appropiately, iFFT and convert to a power */
+	doCorr(&baseband_rows[0][100+_bin], _sv, msbuff, _n, 10, &max, &sum);
+
+	/* Keep its largest peaks, when its largest power is one */
+	if(max > peaks[ACQ_PEAKS-1].mag)
+		PeakAdd((int32 *)msbuff, _n, _n, (float)(_bin*1000) + (float)_offset*250, 0.0, false);
+	else
+		PeakCount(sum, _n);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doCellMedium: One 10 ms Doppler cell, _bin kHz + _offset*250 Hz and the 10 25 Hz rows of the post-correlation DFT above it,
+ * correlated at _n samples per ms
+ * */
+void Acquisition::doCellMedium(int32 _sv, int32 _bin, int32 _offset, int32 _n)
+{
+
+	int32 lcv3, k;
 	int32 iaccum, qaccum;
 	CPX temp[10];
 	int32 data[32];
@@ -314,120 +696,71 @@ Acq_Command_M Acquisition::doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax
 	int32 *dt = (int32 *)&temp[0];
 	int32 *p;
 
-	result = &results[_sv];
-	index = indext = mag = magt = 0;
-
-	/* Sweeps through the doppler range */
-	for(lcv = (_doppmin/1000); lcv <=  (_doppmax/1000); lcv++)
+	/* Do both even and odd */
+	//for(k = 0; k < 2; k++)
+	k = 0;
 	{
-		/* Covers the 250 Hz spacing */
-		for(lcv2 = 0; lcv2 < 4; lcv2++)
-		{
-			/* Do both even and odd */
-			//for(k = 0; k < 2; k++)
-			k = 0;
-			{
 
-				if(gopt.realtime)
-					usleep(1000);
-
-				/* Do the 10 ms of coherent integration */
-				for(lcv3 = 0; lcv3 < 10; lcv3++)
-				{
-					/* Multiply in frequency domain, shifting appropiately */
-					sse_cmulsc(&baseband_rows[lcv2*20 + lcv3 + k*10][100+lcv], fft_codes[_sv], &coherent[lcv3*resamps_ms], resamps_ms, 10);
-
-					/* Compute iFFT */
-					piFFT->doiFFT(&coherent[lcv3*resamps_ms], true);
-				}
-
-				/* For each delay do the post-corr FFT, this REALLY needs sped up */
-				for(lcv3 = 0; lcv3 < resamps_ms; lcv3++)
-				{
-					/* Copy over the relevant data pts */
-					p = (int32 *)&coherent[lcv3];
-					data[0] = *p; p += resamps_ms;
-					data[1] = *p; p += resamps_ms;
-					data[2] = *p; p += resamps_ms;
-					data[3] = *p; p += resamps_ms;
-					data[4] = *p; p += resamps_ms;
-					data[5] = *p; p += resamps_ms;
-					data[6] = *p; p += resamps_ms;
-					data[7] = *p; p += resamps_ms;
-					data[8] = *p; p += resamps_ms;
-					data[9] = *p;
-
-					/* Do the post-correlation dft */
-					sse_cacc(dp, dft_rows[0], 10, &iaccum, &qaccum); temp[0].i = iaccum >> 16; temp[0].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[1], 10, &iaccum, &qaccum); temp[1].i = iaccum >> 16; temp[1].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[2], 10, &iaccum, &qaccum); temp[2].i = iaccum >> 16; temp[2].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[3], 10, &iaccum, &qaccum); temp[3].i = iaccum >> 16; temp[3].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[4], 10, &iaccum, &qaccum); temp[4].i = iaccum >> 16; temp[4].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[5], 10, &iaccum, &qaccum); temp[5].i = iaccum >> 16; temp[5].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[6], 10, &iaccum, &qaccum); temp[6].i = iaccum >> 16; temp[6].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[7], 10, &iaccum, &qaccum); temp[7].i = iaccum >> 16; temp[7].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[8], 10, &iaccum, &qaccum); temp[8].i = iaccum >> 16; temp[8].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[9], 10, &iaccum, &qaccum); temp[9].i = iaccum >> 16; temp[9].q = qaccum >> 16;
-
-					/* Put into the power matrix */
-					p = (int32 *)&power[lcv3];
-					*p = dt[0]; p += resamps_ms;
-					*p = dt[1]; p += resamps_ms;
-					*p = dt[2]; p += resamps_ms;
-					*p = dt[3]; p += resamps_ms;
-					*p = dt[4]; p += resamps_ms;
-					*p = dt[5]; p += resamps_ms;
-					*p = dt[6]; p += resamps_ms;
-					*p = dt[7]; p += resamps_ms;
-					*p = dt[8]; p += resamps_ms;
-					*p = dt[9];
-
-				}
-
-				/* Convert to a power */
-				x86_cmag(&power[0], 10*resamps_ms);
-
-				/* Find the maximum */
-				x86_max((int32 *)power, &indext, &magt, 10*resamps_ms);
-
-				/* Found a new maximum */
-				if(magt > mag)
-				{
-
-					skip = false;
-					dopp = lcv*1000 + lcv2*250 + (indext/resamps_ms)*25;
-					for(j = 0; j < ncross; j++)
-						if(abs(dopp - cross_doppler[j]) < 100)
-							skip = true;
-
-					if(!skip)
-					{
-						mag = magt;
-						index = indext % resamps_ms;
-						result->delay = CODE_CHIPS - (float)index*CODE_RATE/fbase;
-						result->doppler = (float)(lcv*1000) + (float)(lcv2*250) + (indext/resamps_ms)*25.0;
-						result->magnitude = (float)mag;
-					}
-
-				}
-
-			}//end k
-
-		}//end lcv2
-
-	}//end lcv
+		if(gopt.realtime)
+			usleep(1000);
 
+		/* Do the 10 ms of coherent integration */
+		for(lcv3 = 0; lcv3 < 10; lcv3++)
+		{
+			/* Multiply in frequency domain, shifting appropiately, and iFFT */
+			doCorr(&baseband_rows[lcv3 + k*10][100+_bin], _sv, &coherent[lcv3*_n], _n, 10, NULL, NULL);
+		}
 
-	result->sv = _sv;
+		/* For each delay do the post-corr FFT, this REALLY needs sped up */
+		for(lcv3 = 0; lcv3 < _n; lcv3++)
+		{
+			/* Copy over the relevant data pts */
+			p = (int32 *)&coherent[lcv3];
+			data[0] = *p; p += _n;
+			data[1] = *p; p += _n;
+			data[2] = *p; p += _n;
+			data[3] = *p; p += _n;
+			data[4] = *p; p += _n;
+			data[5] = *p; p += _n;
+			data[6] = *p; p += _n;
+			data[7] = *p; p += _n;
+			data[8] = *p; p += _n;
+			data[9] = *p;
+
+			/* Do the post-correlation dft */
+			sse_cacc(dp, dft_rows[0], 10, &iaccum, &qaccum); temp[0].i = iaccum >> 16; temp[0].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[1], 10, &iaccum, &qaccum); temp[1].i = iaccum >> 16; temp[1].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[2], 10, &iaccum, &qaccum); temp[2].i = iaccum >> 16; temp[2].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[3], 10, &iaccum, &qaccum); temp[3].i = iaccum >> 16; temp[3].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[4], 10, &iaccum, &qaccum); temp[4].i = iaccum >> 16; temp[4].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[5], 10, &iaccum, &qaccum); temp[5].i = iaccum >> 16; temp[5].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[6], 10, &iaccum, &qaccum); temp[6].i = iaccum >> 16; temp[6].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[7], 10, &iaccum, &qaccum); temp[7].i = iaccum >> 16; temp[7].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[8], 10, &iaccum, &qaccum); temp[8].i = iaccum >> 16; temp[8].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[9], 10, &iaccum, &qaccum); temp[9].i = iaccum >> 16; temp[9].q = qaccum >> 16;
+
+			/* Put into the power matrix */
+			p = (int32 *)&power[lcv3];
+			*p = dt[0]; p += _n;
+			*p = dt[1]; p += _n;
+			*p = dt[2]; p += _n;
+			*p = dt[3]; p += _n;
+			*p = dt[4]; p += _n;
+			*p = dt[5]; p += _n;
+			*p = dt[6]; p += _n;
+			*p = dt[7]; p += _n;
+			*p = dt[8]; p += _n;
+			*p = dt[9];
 
-	result->type = ACQ_MEDIUM;
+		}
 
-	if(result->magnitude > THRESH_MEDIUM)
-		result->success = 1;
-	else
-		result->success = 0;
+		/* Convert to a power */
+		x86_cmag(&power[0], 10*_n);
 
-	return(results[_sv]);
+		/* Keep its largest peaks, one row per 25 Hz */
+		PeakAdd((int32 *)power, 10*_n, _n, (float)(_bin*1000) + (float)(_offset*250), 25.0, true);
+
+	}//end k
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -435,13 +768,13 @@ Acq_Command_M Acquisition::doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax
 
 /*----------------------------------------------------------------------------------------------*/
 /*!
- * doAcqWeak: Acquire using a 10 ms coherent integration and 15 incoherent integrations
+ * doCellWeak: One 10 ms Doppler cell as doCellMedium(), dwell of them (up to 15) summed incoherently starting with ms _k*10
+ * of each 20 ms
  * */
-Acq_Command_M Acquisition::doAcqWeak(int32 _sv, int32 _doppmin, int32 _doppmax)
+void Acquisition::doCellWeak(int32 _sv, int32 _bin, int32 _offset, int32 _k, int32 _n)
 {
 
-	Acq_Command_M *result;
-	int32 lcv, lcv2, lcv3, mag, magt, index, indext, k, i, j, skip, dopp;
+	int32 lcv3, i;
 	int32 iaccum, qaccum;
 	int32 data[32];
 	CPX *dp = (CPX *)&data[0];
@@ -452,135 +785,387 @@ Acq_Command_M Acquisition::doAcqWeak(int32 _sv, int32 _doppmin, int32 _doppmax)
 	double doppler;
 	int32 shift;
 
-	result = &results[_sv];
-	index = indext = mag = magt = 0;
+	/* Clear out incoherent int */
+	memset(power, 0x0, 10*_n*sizeof(CPX));
+
+	/* Loop over the incoherent integrations */
+	for(i = 0; i < dwell; i++)
+	{
+
+		if(gopt.realtime)
+			usleep(1000);
+
+		/* Do the 10 ms of coherent integration */
+		for(lcv3 = 0; lcv3 < 10; lcv3++)
+		{
+			/* Multiply in frequency domain, shifting appropiately, and iFFT */
+			doCorr(&baseband_rows[lcv3 + i*20 + _k*10][100+_bin], _sv, &coherent[lcv3*_n], _n, 9, NULL, NULL);
+		}
+
+		/* Calculate the frquency doppler */
+		doppler = (double)(_bin*1000) + (float)(_offset*250);
+
+		/* Calculate shift in samples, of _n per ms */
+		code_doppler = (double)i*.02*fbase*doppler/L1*(double)_n/(double)resamps_ms;
+
+		/* Make an integer */
+		shift = (int32)floor(code_doppler);
+
+		/* For each delay do the post-corr FFT, this REALLY needs sped up */
+		for(lcv3 = 0; lcv3 < _n; lcv3++)
+		{
+			/* Copy over the relevant data pts */
+			p = (int32 *)&coherent[lcv3];
+			data[0] = *p; p += _n;
+			data[1] = *p; p += _n;
+			data[2] = *p; p += _n;
+			data[3] = *p; p += _n;
+			data[4] = *p; p += _n;
+			data[5] = *p; p += _n;
+			data[6] = *p; p += _n;
+			data[7] = *p; p += _n;
+			data[8] = *p; p += _n;
+			data[9] = *p;
+
+			/* Do the post-correlation dft */
+			sse_cacc(dp, dft_rows[0], 10, &iaccum, &qaccum); temp[0].i = iaccum >> 16; temp[0].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[1], 10, &iaccum, &qaccum); temp[1].i = iaccum >> 16; temp[1].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[2], 10, &iaccum, &qaccum); temp[2].i = iaccum >> 16; temp[2].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[3], 10, &iaccum, &qaccum); temp[3].i = iaccum >> 16; temp[3].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[4], 10, &iaccum, &qaccum); temp[4].i = iaccum >> 16; temp[4].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[5], 10, &iaccum, &qaccum); temp[5].i = iaccum >> 16; temp[5].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[6], 10, &iaccum, &qaccum); temp[6].i = iaccum >> 16; temp[6].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[7], 10, &iaccum, &qaccum); temp[7].i = iaccum >> 16; temp[7].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[8], 10, &iaccum, &qaccum); temp[8].i = iaccum >> 16; temp[8].q = qaccum >> 16;
+			sse_cacc(dp, dft_rows[9], 10, &iaccum, &qaccum); temp[9].i = iaccum >> 16; temp[9].q = qaccum >> 16;
+
+			//sse_dft(dp, dft_rows[0], &temp[0]);
+
+			x86_cmag(&temp[0], 10);
+
+			/* Accumulate into the power matrix */
+			p = (int32 *)&power[(lcv3 + shift + _n) % _n];
+			*p += dt[0]; p += _n;
+			*p += dt[1]; p += _n;
+			*p += dt[2]; p += _n;
+			*p += dt[3]; p += _n;
+			*p += dt[4]; p += _n;
+			*p += dt[5]; p += _n;
+			*p += dt[6]; p += _n;
+			*p += dt[7]; p += _n;
+			*p += dt[8]; p += _n;
+			*p += dt[9];
+		}
+
+	}//end i
+
+	/* Keep its largest peaks, one row per 25 Hz */
+	PeakAdd((int32 *)power, 10*_n, _n, (float)(_bin*1000) + (float)(_offset*250), 25.0, true);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doCell: One Doppler cell of a _type search, weak does both the even and odd 10 ms
+ * */
+void Acquisition::doCell(int32 _type, int32 _sv, int32 _bin, int32 _offset, int32 _n)
+{
+
+	switch(_type)
+	{
+		case ACQ_STRONG:
+			doCellStrong(_sv, _bin, _offset, _n);
+			break;
+		case ACQ_MEDIUM:
+			doCellMedium(_sv, _bin, _offset, _n);
+			break;
+		case ACQ_WEAK:
+			doCellWeak(_sv, _bin, _offset, 0, _n);
+			doCellWeak(_sv, _bin, _offset, 1, _n);
+			break;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doSweep: Search the whole Doppler range at _n samples per ms. At full rate that is every 250 Hz offset of every 1 kHz bin,
+ * the coarse stage of a strong search only does every other offset, a 1 ms integration loses < 1 dB 250 Hz off. The sweep
+ * stops at the first cell after which PeakSure() says the SV is there.
+ * */
+void Acquisition::doSweep(int32 _type, int32 _sv, int32 _doppmin, int32 _doppmax, int32 _n, float _cfar)
+{
 
-	/* Sweeps through the doppler range */
-	for(lcv = (_doppmin/1000); lcv <  (_doppmax/1000); lcv++)
+	int32 lcv, lcv2, step, last;
+
+	step = ((_type == ACQ_STRONG) && (_n < resamps_ms)) ? 2 : 1;
+
+	/* Medium has always searched its top bin as well */
+	last = (_type == ACQ_MEDIUM) ? (_doppmax/1000) : (_doppmax/1000) - 1;
+
+	/* Covers the 250 Hz spacing */
+	for(lcv2 = 0; lcv2 < 4; lcv2 += step)
 	{
+		doPrepRows(lcv2);
 
-		/* Covers the 250 Hz spacing */
-		for(lcv2 = 0; lcv2 < 4; lcv2++)
+		/* Sweep through the doppler range */
+		for(lcv = (_doppmin/1000); lcv <= last; lcv++)
 		{
-			/* Do both even and odd */
-			for(k = 0; k < 2; k++)
+			doCell(_type, _sv, lcv, lcv2, _n);
+
+			if(PeakSure(_cfar))
+				return;
+		}
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doRefine: The fine stage, search again at full rate only the cells of the coarse stage's peaks. A strong search also takes
+ * the offsets either side, its coarse stage skipped them. The peak is then that of the full rate cells, but a handful of
+ * cells cannot say how large the noise gets, nor what it averages (the cells on whole kHz carry any DC of the IF). So the
+ * noise and the next peak are the coarse stage's, in full rate units: each cell is done at both rates for the conversion.
+ * A weak search's fine stage does all 15 incoherent sums, its coarse stage only dwell.
+ * */
+void Acquisition::doRefine(int32 _type, int32 _sv)
+{
+
+	Acq_Peak_S coarse[ACQ_PEAKS], fine[ACQ_PEAKS];
+	int32 bins[3*ACQ_PEAKS], offsets[3*ACQ_PEAKS];
+	int32 ncells, lcv, lcv2, j, d, off, bin, first, cnt, coarse_cnt, coarse_dwell;
+	int64 sum, coarse_sum;
+	double f, coarse_noise, scale;
+
+	memcpy(coarse, peaks, sizeof(peaks));
+	coarse_noise = noise_cnt ? (double)noise_sum/(double)noise_cnt : 0.0;
+	coarse_sum = 0;
+	coarse_cnt = 0;
+	coarse_dwell = dwell;
+	PeakClear();
+
+	/* The cells to do, each once */
+	ncells = 0;
+	for(lcv = 0; lcv < ACQ_PEAKS; lcv++)
+	{
+		if(coarse[lcv].mag == 0)
+			break;
+
+		for(lcv2 = -1; lcv2 <= 1; lcv2++)
+		{
+			if((_type != ACQ_STRONG) && (lcv2 != 0))
+				continue;
+
+			/* The 250 Hz cell the peak is in, the DFT rows of medium & weak sit above its base */
+			f = floor(coarse[lcv].doppler/250.0)*250.0 + (double)(lcv2*250);
+			bin = (int32)floor(f/1000.0);
+			off = (int32)(f - (double)bin*1000.0)/250;
+
+			for(j = 0; j < ncells; j++)
+				if((bins[j] == bin) && (offsets[j] == off))
+					break;
+
+			if(j == ncells)
 			{
+				bins[ncells] = bin;
+				offsets[ncells] = off;
+				ncells++;
+			}
+		}
+	}
+
+	/* Start with the offset still held from the coarse stage */
+	first = (prep_offset < 0) ? 0 : prep_offset;
+	for(lcv = 0; lcv < 4; lcv++)
+	{
+		off = (first + lcv) % 4;
+
+		for(j = 0; j < ncells; j++)
+		{
+			if(offsets[j] != off)
+				continue;
+
+			doPrepRows(off);
+
+			/* The cell at the coarse rate again, only for its power */
+			memcpy(fine, peaks, sizeof(peaks));
+			sum = noise_sum;
+			cnt = noise_cnt;
+			dwell = coarse_dwell;
+			doCell(_type, _sv, bins[j], off, coarse_ms);
+			coarse_sum += noise_sum - sum;
+			coarse_cnt += noise_cnt - cnt;
+			memcpy(peaks, fine, sizeof(peaks));
+			noise_sum = sum;
+			noise_cnt = cnt;
+
+			dwell = 15;
+			doCell(_type, _sv, bins[j], off, resamps_ms);
+		}
+	}
+
+	if((noise_cnt == 0) || (coarse_sum == 0))
+		return;
+
+	/* Full rate power per coarse rate power, over the same cells */
+	scale = ((double)noise_sum/(double)noise_cnt)/((double)coarse_sum/(double)coarse_cnt);
+	noise_sum = (int64)(coarse_noise*scale*(double)noise_cnt);
+
+	/* Fewer incoherent sums spread the noise peaks wider, the coarse ones would say nothing of the fine */
+	if(coarse_dwell != dwell)
+		return;
+
+	/* The largest coarse peak that is not the fine one */
+	for(lcv = 0; lcv < ACQ_PEAKS; lcv++)
+	{
+		d = abs(coarse[lcv].index - peaks[0].index);
+		if((d > exclude) && ((resamps_ms - d) > exclude))
+			break;
+	}
+
+	if((lcv < ACQ_PEAKS) && (coarse[lcv].mag > 0) && ((double)coarse[lcv].mag*scale > (double)peaks[1].mag))
+		peaks[1].mag = (int32)((double)coarse[lcv].mag*scale);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doSearch: Search the Doppler range, in two stages unless ACQ_COARSE is 1. The coarse stage runs over everything at
+ * coarse_ms samples per ms, the fine stage at full rate only where the coarse stage found its peaks. The coarse stage of weak
+ * is a first dwell of weak_dwell incoherent sums, strong & medium do not use dwell. _cfar is the detection threshold, for PeakSure().
+ * */
+void Acquisition::doSearch(int32 _type, int32 _sv, int32 _doppmin, int32 _doppmax, float _cfar)
+{
+
+	PeakClear();
+
+	dwell = ((_type == ACQ_WEAK) && (coarse_ms < resamps_ms)) ? weak_dwell : 15;
+	doSweep(_type, _sv, _doppmin, _doppmax, coarse_ms, _cfar);
+
+	if(coarse_ms < resamps_ms)
+		doRefine(_type, _sv);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doAcqStrong: Acquire using a 1 ms coherent integration
+ * */
+Acq_Command_M Acquisition::doAcqStrong(int32 _sv, int32 _doppmin, int32 _doppmax)
+{
+
+	Acq_Command_M *result = &results[_sv];
+	float cfar = Cfar(ACQ_STRONG, _doppmin, _doppmax);
+
+	doSearch(ACQ_STRONG, _sv, _doppmin, _doppmax, cfar);
+
+	result->sv = _sv;
+
+	result->type = ACQ_STRONG;
+
+	PeakResult(result, cfar);
+
+	return(results[_sv]);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doAcqMedium: Acquire using a 10 ms coherent integration
+ * */
+Acq_Command_M Acquisition::doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax)
+{
+
+	Acq_Command_M *result = &results[_sv];
+	float cfar = Cfar(ACQ_MEDIUM, _doppmin, _doppmax);
 
-				/* Clear out incoherent int */
-				memset(power, 0x0, 10*resamps_ms*sizeof(CPX));
-
-				/* Loop over 15 incoherent integrations */
-				for(i = 0; i < 15; i++)
-				{
-
-					if(gopt.realtime)
-						usleep(1000);
-
-					/* Do the 10 ms of coherent integration */
-					for(lcv3 = 0; lcv3 < 10; lcv3++)
-					{
-						/* Multiply in frequency domain, shifting appropiately */
-						sse_cmulsc(&baseband_rows[lcv2*310 + lcv3 + i*20 + k*10][100+lcv], fft_codes[_sv], &coherent[lcv3*resamps_ms], resamps_ms, 9);
-
-						/* Compute iFFT */
-						piFFT->doiFFT(&coherent[lcv3*resamps_ms], true);
-					}
-
-					/* Calculate the frquency doppler */
-					doppler = (double)(lcv*1000) + (float)(lcv2*250);
-
-					/* Calculate shift in samples */
-					code_doppler = (double)i*.02*IF_SAMPLE_FREQUENCY*doppler/L1;
-
-					/* Make an integer */
-					shift = (int32)floor(code_doppler);
-
-					/* For each delay do the post-corr FFT, this REALLY needs sped up */
-					for(lcv3 = 0; lcv3 < resamps_ms; lcv3++)
-					{
-						/* Copy over the relevant data pts */
-						p = (int32 *)&coherent[lcv3];
-						data[0] = *p; p += resamps_ms;
-						data[1] = *p; p += resamps_ms;
-						data[2] = *p; p += resamps_ms;
-						data[3] = *p; p += resamps_ms;
-						data[4] = *p; p += resamps_ms;
-						data[5] = *p; p += resamps_ms;
-						data[6] = *p; p += resamps_ms;
-						data[7] = *p; p += resamps_ms;
-						data[8] = *p; p += resamps_ms;
-						data[9] = *p;
-
-						/* Do the post-correlation dft */
-						sse_cacc(dp, dft_rows[0], 10, &iaccum, &qaccum); temp[0].i = iaccum >> 16; temp[0].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[1], 10, &iaccum, &qaccum); temp[1].i = iaccum >> 16; temp[1].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[2], 10, &iaccum, &qaccum); temp[2].i = iaccum >> 16; temp[2].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[3], 10, &iaccum, &qaccum); temp[3].i = iaccum >> 16; temp[3].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[4], 10, &iaccum, &qaccum); temp[4].i = iaccum >> 16; temp[4].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[5], 10, &iaccum, &qaccum); temp[5].i = iaccum >> 16; temp[5].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[6], 10, &iaccum, &qaccum); temp[6].i = iaccum >> 16; temp[6].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[7], 10, &iaccum, &qaccum); temp[7].i = iaccum >> 16; temp[7].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[8], 10, &iaccum, &qaccum); temp[8].i = iaccum >> 16; temp[8].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[9], 10, &iaccum, &qaccum); temp[9].i = iaccum >> 16; temp[9].q = qaccum >> 16;
-
-						//sse_dft(dp, dft_rows[0], &temp[0]);
-
-						x86_cmag(&temp[0], 10);
-
-						/* Accumulate into the power matrix */
-						p = (int32 *)&power[(lcv3 + shift + SAMPS_MS) % SAMPS_MS];
-						*p += dt[0]; p += resamps_ms;
-						*p += dt[1]; p += resamps_ms;
-						*p += dt[2]; p += resamps_ms;
-						*p += dt[3]; p += resamps_ms;
-						*p += dt[4]; p += resamps_ms;
-						*p += dt[5]; p += resamps_ms;
-						*p += dt[6]; p += resamps_ms;
-						*p += dt[7]; p += resamps_ms;
-						*p += dt[8]; p += resamps_ms;
-						*p += dt[9];
-					}
-
-				}//end i
-
-				/* Find the maximum */
-				x86_max((int32 *)power, &indext, &magt, 10*resamps_ms);
-
-				/* Found a new maximum */
-				if(magt > mag)
-				{
-
-					skip = false;
-					dopp = lcv*1000 + lcv2*250 + (indext/resamps_ms)*25;
-					for(j = 0; j < ncross; j++)
-						if(abs(dopp - cross_doppler[j]) < 100)
-							skip = true;
-
-					if(!skip)
-					{
-						mag = magt;
-						index = indext % resamps_ms;
-						result->delay = CODE_CHIPS - (float)index*CODE_RATE/fbase;
-						result->doppler = (float)(lcv*1000) + (float)(lcv2*250) + (indext/resamps_ms)*25.0;
-						result->magnitude = (float)mag;
-					}
-
-				}
-
-			}//end k
-
-		}//end lcv2
-
-	}//end lcv
+	doSearch(ACQ_MEDIUM, _sv, _doppmin, _doppmax, cfar);
+
+	result->sv = _sv;
+
+	result->type = ACQ_MEDIUM;
+
+	PeakResult(result, cfar);
+
+	return(results[_sv]);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doAcqWeak: Acquire using a 10 ms coherent integration and 15 incoherent integrations
+ * */
+Acq_Command_M Acquisition::doAcqWeak(int32 _sv, int32 _doppmin, int32 _doppmax)
+{
+
+	Acq_Command_M *result = &results[_sv];
+	float cfar = Cfar(ACQ_WEAK, _doppmin, _doppmax);
+
+	doSearch(ACQ_WEAK, _sv, _doppmin, _doppmax, cfar);
 
 	result->sv = _sv;
 
 	result->type = ACQ_WEAK;
 
-	if(result->magnitude > THRESH_WEAK)
-		result->success = 1;
-	else
-		result->success = 0;
+	PeakResult(result, cfar);
+
+	return(results[_sv]);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doAcqLadder: Escalate through the types set in _types (bit ACQ_STRONG, ACQ_MEDIUM, ACQ_WEAK) until one detects the SV, the
+ * IF must be as long as the deepest of them needs. The result is that of the last type tried.
+ * */
+Acq_Command_M Acquisition::doAcqLadder(int32 _sv, int32 _types, int32 _doppmin, int32 _doppmax)
+{
+
+	CPX *p = prep_buff;
+	int32 type;
+
+	if((_types & ((1 << ACQ_STRONG) | (1 << ACQ_MEDIUM) | (1 << ACQ_WEAK))) == 0)
+		_types = (1 << ACQ_STRONG);
+
+	for(type = ACQ_STRONG; type <= ACQ_WEAK; type++)
+	{
+		if((_types & (1 << type)) == 0)
+			continue;
+
+		doPrepIF(type, p);
+
+		switch(type)
+		{
+			case ACQ_STRONG:
+				doAcqStrong(_sv, _doppmin, _doppmax);
+				break;
+			case ACQ_MEDIUM:
+				doAcqMedium(_sv, _doppmin, _doppmax);
+				break;
+			case ACQ_WEAK:
+				doAcqWeak(_sv, _doppmin, _doppmax);
+				break;
+		}
+
+		if(results[_sv].success)
+			break;
+	}
 
 	return(results[_sv]);
 
@@ -596,27 +1181,25 @@ void Acquisition::Acquire()
 {
 	int32 lcv;
 
+	/* Shutting down before a window came */
+	if(buff == NULL)
+		return;
+
+	IncStartTic();
+
+	/* Strong up to request.type, the IF is as long as that needs */
+	doPrepIF(request.type, buff);
+	doAcqLadder(request.sv, request.types, request.mindopp, request.maxdopp);
+
 	IncStopTic();
 
-	switch(request.type)
+	/* Hand the window back so the next one can be captured into it */
+	if(window != -1)
 	{
-		case ACQ_STRONG:
-			doPrepIF(ACQ_STRONG, buff);
-			doAcqStrong(request.sv, request.mindopp, request.maxdopp);
-			break;
-		case ACQ_MEDIUM:
-			doPrepIF(ACQ_MEDIUM, buff);
-			doAcqMedium(request.sv, request.mindopp, request.maxdopp);
-			break;
-		case ACQ_WEAK:
-			doPrepIF(ACQ_WEAK, buff);
-			doAcqWeak(request.sv, request.mindopp, request.maxdopp);
-			break;
-		default:
-			doAcqStrong(request.sv, request.mindopp, request.maxdopp);
+		pAcq_Capture->Release(window);
+		window = -1;
+		buff = NULL;
 	}
-
-	IncStartTic();
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -627,22 +1210,58 @@ void Acquisition::Acquire()
  * */
 void Acquisition::Import()
 {
-	int32 last;
 	int32 bread;
-	int32 lastcount;
-	int32 ms;
-	int32 ms_per_read;
 	int32 lcv;
-	ms_packet *p = NULL;
-	timespec ret;
-
-	ret.tv_sec = 0;
-	ret.tv_nsec = 100000;
 
-	/* First wait for a request */
+	/* First wait for a request, all the workers read the same pipe and each request goes to one of them */
 	bread = read(Trak_2_Acq_P[READ], &request, sizeof(Acq_Command_M));
 	memcpy(&results[request.sv],&request,sizeof(Acq_Command_M));
 
+	if(gopt.acq_capture)
+	{
+		/* The newest complete window, captured while the last search ran */
+		window = pAcq_Capture->Take();
+		if(window != -1)
+		{
+			buff = pAcq_Capture->getWindow(window);
+			request.count = pAcq_Capture->getCount(window);
+			IncLag(pAcq_Capture->getStamp(window));
+		}
+	}
+	else
+		Collect();
+
+	ncross = 0;
+
+	/* If the SV is already being tracked skip the acquisition */
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		pChannels[lcv]->Lock();
+		if(pChannels[lcv]->getActive())
+			if(pChannels[lcv]->getCN0() > 45.0)	//If the CN0 is really high
+			{
+				cross_doppler[ncross] = (int32)floor(pChannels[lcv]->getNCO() - IF_FREQUENCY);
+				ncross++;
+			}
+		pChannels[lcv]->Unlock();
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Collect: Pull the 1, 10 or 310 ms the request needs from the FIFO
+ * */
+void Acquisition::Collect()
+{
+	int32 last;
+	int32 lastcount;
+	int32 ms;
+	int32 ms_per_read;
+	int32 nms;
+
 	switch(request.type)
 	{
 		case ACQ_STRONG:
@@ -680,21 +1299,29 @@ void Acquisition::Import()
 			pFIFO->Dequeue(MAX_CHANNELS, &packet);
 		}
 
-		memcpy(&buff[SAMPS_MS*ms], &packet.data, SAMPS_MS*sizeof(CPX));
+		IncLag(packet.stamp);
 
 		/* Detect broken packets */
 		if(ms > 0)
 		{
-			if((packet.count - lastcount) != 1)
+			if((packet.count - lastcount) != packet.ms)
 			{
 				//printf("Broken GPS stream %d,%d\n",packet.count,lastcount);
 				ms = 0; /* Recollect data */
 			}
 		}
-		else
+
+		if(ms == 0)
 			request.count = packet.count;
 
-		ms++;
+		/* Take as much of the block as is still needed */
+		nms = ms_per_read - ms;
+		if(nms > packet.ms)
+			nms = packet.ms;
+
+		memcpy(&buff[SAMPS_MS*ms], &packet.data[0], nms*SAMPS_MS*sizeof(CPX));
+
+		ms += nms;
 		lastcount = packet.count;
 
 	}
@@ -704,21 +1331,6 @@ void Acquisition::Import()
 	gAcq_high = false;
 	pthread_mutex_unlock(&mAcq);
 
-	ncross = 0;
-
-	/* If the SV is already being tracked skip the acquisition */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-	{
-		pChannels[lcv]->Lock();
-		if(pChannels[lcv]->getActive())
-			if(pChannels[lcv]->getCN0() > 45.0)	//If the CN0 is really high
-			{
-				ncross++;
-				cross_doppler[lcv] = (int32)floor(pChannels[lcv]->getNCO() - IF_FREQUENCY);
-			}
-		pChannels[lcv]->Unlock();
-	}
-
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -732,11 +1344,18 @@ void Acquisition::Export(char * _fname)
 
 	int32 lcv;
 	FILE *fp;
+	char fname[32];
 	Acq_Command_M *p;
 
 	if(_fname == NULL)
 	{
-		fp = fopen("Acq.txt","wa");
+		/* Each worker only has the results of the SVs it was handed */
+		if(worker == 0)
+			sprintf(fname, "Acq.txt");
+		else
+			sprintf(fname, "Acq%d.txt", worker);
+
+		fp = fopen(fname,"wa");
 		if(fp == NULL)
 			return;
 		fseek(fp, 0x0, SEEK_SET);
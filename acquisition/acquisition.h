@@ -35,33 +35,41 @@ class Acquisition : public Threaded_Object
 	private:
 
 		pthread_t thread;
-		CPX *fft_codes[NUM_CODES_WAAS];			//!< Store the FFTd Codes;
+		int32 worker;							//!< Which of the gopt.acq_workers this is
+		CPX *codes;								//!< The FFTd codes of all PRNs, GPS & WAAS
+		CPX *fft_codes[NUM_CODES_WAAS];			//!< Store the FFTd Codes, one row of codes each;
+		CPX *coarse_codes;						//!< The middle coarse_ms bins of each, for the coarse stage
 
 		ms_packet packet;						//!< Get IF data
-		CPX *buff;								//!< Result after mixing the buffer to baseband
-		CPX *baseband;							//!< Result after mixing the buffer to baseband
-		CPX *baseband_shift;					//!< Result after mixing the buffer to baseband, used for the "circular shifts"
-		CPX **baseband_rows;					//!< Row pointer
+		CPX *buff;								//!< The raw IF being searched
+		CPX *collect;							//!< Our own IF buffer for Collect(), none with -capture
+		int32 window;							//!< With -capture the Acq_Capture window being searched, -1 for none
+		CPX *prep_buff;							//!< The raw IF handed to doPrepIF()
+		int32 prep_ms;							//!< ms of it to search
+		int32 prep_offset;						//!< 250 Hz offset currently held in baseband_rows, -1 for none
+		CPX *baseband_shift;					//!< FFTd baseband of one 250 Hz offset, used for the "circular shifts"
+		CPX **baseband_rows;					//!< Row pointer, one row per ms
 		CPX *coherent;							//!< Used for the 10 ms coherent integration
-		CPX *_000Hzwipeoff;						//!< Sinusoid used to perform mix to baseband
-		CPX	*_250Hzwipeoff;						//!< Sinusoid to mix by Fif - 250 Hz
-		CPX	*_500Hzwipeoff;						//!< Sinusoid to mix by Fif - 500 Hz
-		CPX	*_750Hzwipeoff;						//!< Sinusoid to mix by Fif - 750 Hz
+		CPX *wipeoff;							//!< One ACQ_WIPE_MS period of the mix by Fif, Fif - 250, 500 & 750 Hz
 		CPX *rotate;							//!< Buffer used for circular rotation of vector
 		CPX *msbuff;							//!< Random buffer for 1 ms stuff
 		CPX *power;
+		int32 *peak_blocks;						//!< x86_peaks() scratch, the block maxima of 10 ms of powers
 		MIX *dft;								//!< Used for the post correlation DFT
 		MIX **dft_rows;							//!< Used for the post correlation DFT
 
-		float fbase;							//!< The base sample rate (2048 samps/ms);
+		float fbase;							//!< The sample rate searched, resamps_ms per ms
 		float fsample;							//!< The sample rate of the data
 		float fif;								//!< intermediate frequency
 		int32 samps_ms;							//!< Samples per ms
 		int32 resamps_ms;						//!< Resamples per ms
+		int32 exclude;							//!< ACQ_PEAK_EXCLUDE in samples of resamps_ms
+		int32 coarse_ms;						//!< Resamples per ms of the coarse stage, resamps_ms/ACQ_COARSE
 
 		FFT *pFFT;								//!< The FFT used to perform correlation
 		FFT *piFFT;								//!< The FFT used to perform correlation
 		FFT *pcFFT;								//!< The FFT used to perform the coherent integration
+		FFT *pdFFT;								//!< The iFFT of the coarse stage, coarse_ms points
 
 		int32 sv;								//!< Search for this SV
 		int32 state;							//!< Search using this state (STRONG, MEDIUM, or WEAK)
@@ -70,19 +78,47 @@ class Acquisition : public Threaded_Object
 		int32 ncross;							//!< Cross corr blocking
 		int32 cross_doppler[MAX_CHANNELS];		//!< Cross corr blocking
 
+		Acq_Peak_S peaks[ACQ_PEAKS];			//!< Top peaks of the search so far, largest first
+		int64 noise_sum;						//!< Total power of the search so far
+		int32 noise_cnt;						//!< Over this many cells
+		int32 cells;							//!< Doppler cells searched so far
+		int32 dwell;							//!< Incoherent sums of doCellWeak()
+		int32 weak_dwell;						//!< Of them in the coarse stage of a weak search, see -acq_dwell
+
 		Acq_Command_M request;					//!< Acquisition transaction
 		Acq_Command_M results[NUM_CODES];		//!< Where to store the results
 
 	public:
 
-		Acquisition(float _fsample, float _fif);											//!< Create and initialize object, need _fsample as a necessary argument
+		Acquisition(float _fsample, float _fif, int32 _worker);								//!< Create and initialize object, need _fsample as a necessary argument
 		~Acquisition();																		//!< Shutdown gracefully
 		Acq_Command_M doAcqStrong(int32 _sv, int32 _doppmin, int32 _doppmax); 				//!< Look for this sv in this doppler range using a 1 ms correlation (_buff must be 1 ms long)
 		Acq_Command_M doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax); 				//!< Look for this sv in this doppler range using a 10 ms correlation (_buff must be 20 ms long)
 		Acq_Command_M doAcqWeak(int32 _sv, int32 _doppmin, int32 _doppmax); 				//!< Look for this sv in this doppler range using a 10 ms correlation and 15 incoherent integrations (_buff must be 310 ms long)
+		Acq_Command_M doAcqLadder(int32 _sv, int32 _types, int32 _doppmin, int32 _doppmax);	//!< Strong, then medium, then weak, of those in _types, until one detects the SV
+		void GenCodes();																	//!< FFT the codes at resamps_ms
+		void CodesHeader(int32 *_hdr);														//!< What the header of ACQ_CODE_FILE has to say
+		bool ReadCodes();																	//!< Read the FFTd codes back from ACQ_CODE_FILE
+		void WriteCodes();																	//!< And cache them there
 		void doPrepIF(int32 _type, CPX *_buff);												//!< Prep the IF (done once if detecting multiple SVs in same data set)
+		void doPrepRows(int32 _offset);														//!< Mix & FFT the rows of one 250 Hz offset, as the search gets to it
 		void doDFT(CPX *in);
+		void doCorr(CPX *_row, int32 _sv, CPX *_out, int32 _n, int32 _shift, int32 *_max, int64 *_sum);	//!< Correlate one ms at _n samples per ms
+		void doCellStrong(int32 _sv, int32 _bin, int32 _offset, int32 _n);					//!< One Doppler cell of each search
+		void doCellMedium(int32 _sv, int32 _bin, int32 _offset, int32 _n);
+		void doCellWeak(int32 _sv, int32 _bin, int32 _offset, int32 _k, int32 _n);
+		void doCell(int32 _type, int32 _sv, int32 _bin, int32 _offset, int32 _n);
+		void doSweep(int32 _type, int32 _sv, int32 _doppmin, int32 _doppmax, int32 _n, float _cfar);	//!< Every cell of the Doppler range, or until PeakSure()
+		void doRefine(int32 _type, int32 _sv);												//!< Fine stage, full rate cells around the coarse peaks
+		void doSearch(int32 _type, int32 _sv, int32 _doppmin, int32 _doppmax, float _cfar);	//!< Coarse then fine
+		void PeakClear();																	//!< Start a search
+		void PeakAdd(int32 *_power, int32 _cnt, int32 _row, float _doppler, float _spacing, bool _cross);	//!< Merge a Doppler cell's peaks into the search's
+		void PeakCount(int64 _sum, int32 _cnt);												//!< Count a Doppler cell's power into the search's
+		void PeakResult(Acq_Command_M *_result, float _cfar);								//!< Fill in the result from the largest peak, detect with a CFAR & peak ratio test
+		bool PeakSure(float _cfar);															//!< The search so far is a detection by a margin, it can stop
+		float Cfar(int32 _type, int32 _doppmin, int32 _doppmax);							//!< Detection threshold of a search, for the cells it covers
 		void Import();																		//!< Get a chuck of data to operate on
+		void Collect();																		//!< Collect the request's IF from the FIFO into our own buffer
 		void Export(char *_fname);															//!< Dump results
 		void Acquire();																		//!< Acquire with respect to current state
 		void Start();																		//!< Start up the thread
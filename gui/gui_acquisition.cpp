@@ -18,7 +18,7 @@ END_EVENT_TABLE()
 GUI_Acquisition::GUI_Acquisition():iGUI_Acquisition(NULL, wxID_ANY, wxT("Acquisition"), wxDefaultPosition, wxSize(800,600), wxDEFAULT_FRAME_STYLE|wxTAB_TRAVERSAL)
 {
 	sv = 0;
-	scale[0] = scale[1] = scale[2] = THRESH_STRONG;
+	scale[0] = scale[1] = scale[2] = ACQ_CFAR_STRONG;
 }
 
 GUI_Acquisition::~GUI_Acquisition()
@@ -89,15 +89,15 @@ void GUI_Acquisition::renderBars(int32 _type)
 	{
 		case ACQ_STRONG:
 			dc = new wxBufferedPaintDC(pStrong, wxBUFFER_CLIENT_AREA);
-			thresh = THRESH_STRONG;
+			thresh = ACQ_CFAR_STRONG;
 			break;
 		case ACQ_MEDIUM:
 			dc = new wxBufferedPaintDC(pMedium, wxBUFFER_CLIENT_AREA);
-			thresh = THRESH_MEDIUM;
+			thresh = ACQ_CFAR_MEDIUM;
 			break;
 		case ACQ_WEAK:
 			dc = new wxBufferedPaintDC(pWeak, wxBUFFER_CLIENT_AREA);
-			thresh = THRESH_WEAK;
+			thresh = ACQ_CFAR_WEAK;
 			break;
 		default:
 			return;
@@ -131,7 +131,11 @@ void GUI_Acquisition::renderBars(int32 _type)
 	{
 		psv = &acq_command[_type][lcv];
 
-		pY = -600*(psv->magnitude)/thresh;
+		/* Peak over the noise floor, the detector's own test, so the dashed line is the threshold */
+		if(psv->noise > 0)
+			pY = -600*(psv->magnitude/psv->noise)/thresh;
+		else
+			pY = 0;
 		if(pY > 2000) pY = 2000;
 		pY *= scaleY;
 
@@ -90,9 +90,6 @@ GUI_Serial::GUI_Serial()
 {
 
 	grun = 1;
-	execution_tic = 0;
-	start_tic = 0;
-	stop_tic = 0;
 	message_sync = 0;
 	byte_count = 0;
 	command_head = 0;
@@ -647,36 +647,38 @@ void GUI_Toplevel::renderTask()
 
 	pTask = &messages.task_health;
 
-		 str = wxT("Task        Execution Tic   Delta     Start Tic    Stop Tic\n");
+		 str = wxT("                             Proc (us)            Wait (us)    Lag (us)\n");
 	tTask->AppendText(str);
-	     str = wxT("-----------------------------------------------------------\n");
+		 str = wxT("Task        Execution Tic    p50    p99    max    p50    p99    p99    max  Prio  CPU Node\n");
+	tTask->AppendText(str);
+	     str = wxT("-----------------------------------------------------------------------------------------\n");
 	tTask->AppendText(str);
 
-	for(lcv = 0; lcv < MAX_TASKS-1; lcv++)
+	for(lcv = 0; lcv < MAX_TASKS; lcv++)
 	{
 		if(names[lcv].Len())
 		{
-			str.Printf(wxT("%s   %10d  %6d    %9d    %9d\n"),
+			str.Printf(wxT("%s   %10d  %5d  %5d  %5d  %5d  %5d  %5d  %5d  %4d %4d %4d"),
 				names[lcv].c_str(),
 				pTask->execution_tic[lcv],
-				pTask->stop_tic[lcv]-pTask->start_tic[lcv],
-				pTask->start_tic[lcv],
-				pTask->stop_tic[lcv]);
+				pTask->proc[0][lcv],
+				pTask->proc[1][lcv],
+				pTask->proc[2][lcv],
+				pTask->wait[0][lcv],
+				pTask->wait[1][lcv],
+				pTask->lag[1][lcv],
+				pTask->lag[2][lcv],
+				SCHED_PRIO(pTask->sched[lcv]),
+				SCHED_CPU(pTask->sched[lcv]),
+				SCHED_NODE(pTask->sched[lcv]));
+
+			if(lcv < MAX_TASKS-1)
+				str += wxT("\n");
+
 			tTask->AppendText(str);
 		}
 	}
 
-	if(names[lcv].Len())
-	{
-		str.Printf(wxT("%s   %10d  %6d    %9d    %9d"),
-			names[lcv].c_str(),
-			pTask->execution_tic[lcv],
-			pTask->stop_tic[lcv]-pTask->start_tic[lcv],
-			pTask->start_tic[lcv],
-			pTask->stop_tic[lcv]);
-		tTask->AppendText(str);
-	}
-
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -44,8 +44,17 @@ Threaded_Object::Threaded_Object()
 	pthread_mutex_init(&mutex, NULL);
 	pthread_mutex_unlock(&mutex);
 	execution_tic = 0;
-	start_tic = 0;
-	stop_tic = 0;
+	start_ns = 0;
+	stop_ns = 0;
+
+	/* Histogram::Clear() lives in accessories, which the GUI does not link */
+	memset(&hproc, 0x0, sizeof(Histogram));
+	memset(&hwait, 0x0, sizeof(Histogram));
+	memset(&hlag, 0x0, sizeof(Histogram));
+	sched_policy = SCHED_OTHER;
+	sched_priority = 0;
+	cpu = -1;
+	node = -1;
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -50,6 +50,7 @@ enum CCSDS_COMMAND_IDS
 	GET_ACQ_COMMAND_C_ID,
 	GET_SV_POSITION_C_ID,
 	GET_CHANNEL_C_ID,
+	SET_CORR_TAPS_C_ID,
 	LAST_C_ID
 };
 
@@ -271,6 +272,18 @@ typedef struct Get_Channel_C
 } Get_Channel_C;
 
 
+/*! \ingroup COMMANDS
+	Set the multipath taps of a correlator
+*/
+typedef struct Set_Corr_Taps_C
+{
+	int32 command_id;	//!< Command identifier
+	int32 chan;			//!< Channel #, or all if chan >= MAX_CHANNELS
+	int32 delays;		//!< Taps (plus-minus) on top of early/prompt/late, 0 turns them off
+	float spacing;		//!< Spacing of the taps (chips)
+} Set_Corr_Taps_C;
+
+
 typedef union Union_C
 {
 	Reset_All_C			reset_all;
@@ -294,6 +307,7 @@ typedef union Union_C
 	Get_Acq_Command_C		get_acq_command;
 	Get_SV_Position_C		get_sv_position;
 	Get_Channel_C			get_channel;
+	Set_Corr_Taps_C			set_corr_taps;
 } Union_C;
 
 #endif /* COMMANDS_H_ */
@@ -73,9 +73,37 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #define ACQ_WEAK_STATE			(2)			//!< 0 for off, 1 for on, 2 for hot acquisition only
 
 #define ACQ_ITERATIONS			(1)			//!< Do this many acqs at a given type before moving to next type
-#define THRESH_STRONG			(1.3e7)		//!< Threshold for strong signal detection
-#define THRESH_MEDIUM			(1.5e7)		//!< Threshold for medium signal detection
-#define THRESH_WEAK				(1.5e7)		//!< Threshold for weak signal detection
+#define ACQ_WIPE_MS				(10)		//!< The acquisition's 250 Hz spaced wipeoffs repeat every 10 ms
+#define ACQ_WINDOWS				(2)			//!< IF windows of Acq_Capture (-capture), one searched while the other fills
+#define ACQ_WINDOW_MS			(310)		//!< Length of each, the most any acquisition type needs
+#define ACQ_WINDOW_FREE			(0)			//!< Window states
+#define ACQ_WINDOW_FILL			(1)
+#define ACQ_WINDOW_READY		(2)			//!< The newest complete window
+#define ACQ_WINDOW_SEARCH		(3)			//!< An older one, still being searched
+#define ACQ_MAX_WORKERS			(4)			//!< Most acquisition threads (-acq_workers)
+#define ACQ_CAPTURE_SLEEP		(1000)		//!< Acq_Capture & Acquisition::Import() poll the windows this often (us) while waiting
+#define ACQ_PEAKS				(4)			//!< Peaks kept of each search
+#define ACQ_PEAK_EXCLUDE		(4)			//!< Peaks are more than this many samples (2 chips) apart in code phase, at SAMPS_MS
+#define ACQ_CFAR_STRONG			(20.0)		//!< Detect when the peak is this many times the mean power of a search of ACQ_CFAR_CELLS...
+#define ACQ_CFAR_MEDIUM			(24.0)		//!< The largest of noise alone there is Gumbel, mode 11.0, 12.6 & 2.7, scale 1.2, 1.2 & 0.13,
+#define ACQ_CFAR_WEAK			(4.0)		//!< for a Pfa per search of ~5e-4, 1e-4 & 4e-5 before the ratio test
+#define ACQ_CFAR_CELLS			(20*2048)	//!< Doppler kHz times code phases those are set for, a cold +-10 kHz search at 2048 samples/ms
+#define ACQ_CFAR_STRONG_LOG		(0.8)		//!< The noise's largest grows by this per e-fold of cells searched, measured from 2 to 20 kHz &
+#define ACQ_CFAR_MEDIUM_LOG		(0.7)		//!< 2048 to 4000 samples/ms, Cfar() moves each threshold with it to keep its Pfa
+#define ACQ_CFAR_WEAK_LOG		(0.03)
+#define ACQ_PEAK_RATIO			(1.5)		//!< ...and this many times the next peak
+#define ACQ_COARSE				(2)			//!< The coarse stage of a search is decimated by this (power of 2), 1 for one full rate stage
+#define ACQ_WEAK_DWELL			(15)		//!< Incoherent sums of the coarse stage of a weak search, -acq_dwell trades fewer (faster, ~2 dB less at 5) for speed
+#define ACQ_SURE				(1.5)		//!< A search stops once its peak passes the CFAR & ratio tests by this factor...
+#define ACQ_SURE_CELLS			(8)			//!< ...after at least this many Doppler cells
+#define ACQ_IFFT_GAIN			(256)		//!< Unscaled gain of the correlation iFFTs at lengths other than powers of 2, what R2 leaves 1024 points. It leaves 2048 points 512,
+											//!< which at 4000 samples/ms clips the weak search's post-correlation DFT at 48 dB-Hz. At 256 its powers stay under 2^30
+#define ACQ_CODE_BITS			(9)			//!< The FFTd codes are scaled so their largest bin is 2^this
+#define ACQ_CODE_FILE			"fft_codes%d.dat"	//!< Cache of the FFTd codes, one per resamps_ms
+#define ACQ_CODE_VERSION		(2)			//!< Format of ACQ_CODE_FILE, bump it whenever GenCodes() or the FFT's arithmetic changes
+#define ACQ_CODE_HDR			(5+2*MAX_RANKS)	//!< int32s in its header, see Acquisition::CodesHeader()
+#define PEAK_BLOCK				(16)		//!< x86_peaks() takes the max of this many samples at a time
+#define PEAK_MAX_BLOCKS			(16*SAMPS_MS/PEAK_BLOCK)	//!< Block maxima sse_max() keeps on the stack for x86_peaks(), 16 ms of powers at SAMPS_MS, longer goes to x86_max()
 #define MAX_DOPPLER				(45000)		//!< Set the maximum Doppler frequency
 #define DOPPLER_RANGE			(1000)		//!< Search this Doppler range for hot acquisitions
 /*----------------------------------------------------------------------------------------------*/
@@ -85,17 +113,30 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 /*----------------------------------------------------------------------------------------------*/
 #define CORR_DELAYS				(1)			//!< Number of delays to calculate (plus-minus)
 #define CORR_SPACING			(.5)		//!< How far should the correlators be spaced (chips)
+#define CORR_MAX_DELAYS			(32)		//!< Most multipath taps (plus-minus) a channel can run, on top of early/prompt/late
+#define CORR_MAX_TAPS			(2*CORR_MAX_DELAYS+1) //!< Most multipath taps
+#define CORR_MAX_SPAN			(16.0)		//!< Multipath taps must lie within this many chips of prompt
+#define CORR_TAP_PAD			(48)		//!< Lead-in samples on each code row so taps can sit before prompt
+#define CORR_WIPE_SHIFT			(14)		//!< Shift after the carrier wipeoff
+#define CORR_KERNEL_BLOCK		(64)		//!< Block length of the specialized correlator kernel (x86_t.h)
+//#define CORR_KERNEL_T						//!< Use the specialized C kernel (x86_t.h) for E/P/L in place of the SSE asm, benchmark first
 #define FRAME_SIZE_PLUS_2		(12)		//!< 10 words per frame, 12 = 10 + 2
 #define MEASUREMENT_INT			(100)		//!< Packets of ~1ms data
+#define FIFO_MAX_BLOCK			(20)		//!< Most ms per FIFO packet (-block), at most one measurement may fall in a packet
 #define CODE_BINS				(20)		//!< Partial code offset bins code resolution -> 1 chip/X bins
 #define CARRIER_SPACING			(20)		//!< Spacing of bins (Hz)
 #define CARRIER_BINS			(MAX_DOPPLER/CARRIER_SPACING) //!< Number of pre-sampled carrier wipeoff bins
+#define NCO_FRAC_BITS			(40)		//!< Fractional bits of the 64 bit code & carrier phase accumulators
+#define NCO_ONE					((int64)1 << NCO_FRAC_BITS)	//!< 1.0 in NCO fixed point
+#define NCO_SCALE				(1.0/(double)NCO_ONE)		//!< NCO fixed point to double
 #define ICP_TICS				(5)			//!< Number of measurement ints (plus-minus) to calculate ICP,
 											//!< this cannot exceed TICS_PER_SECOND/2 !!!!
 
 #define TICS_2_SECONDS			(MEASUREMENT_INT/1000)
 #define TICS_PER_SECOND			(1000/MEASUREMENT_INT)
-#define	ACQS_PER_SECOND			(20)
+#define SV_SELECT_WAIT			(100)		//!< ms SV_Select waits for an event before looking at the channels anyway
+#define SV_SELECT_HANDOFF		(1000)		//!< ms a channel is held for a detected SV until its correlator takes it
+#define SV_SELECT_LOST			(30)		//!< s a lost SV is searched first, around its last Doppler
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -108,6 +149,61 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #define AGC_LOW					(4)			//!< Overflow low
 #define AGC_HIGH				(16)		//!< Overflow high
 #define MEASUREMENT_DELAY		(10)		//!< Number of measurements that have to be marked as navigate to allow PVT
+#define COAST_MS				(5000)		//!< Default for -coast, how long (ms) a channel that lost the signal coasts before it is given up
+#define COAST_RELOCK_POWER		(4e4)		//!< P_avg a coasting channel must climb back over to retake the loops
+#define COAST_CN0				(32.0)		//!< Only a channel that was tracking above this CN0 is coasted
+#define CHANNEL_TRACK			(0)			//!< Channel state, loops closed
+#define CHANNEL_COAST			(1)			//!< Channel state, NCOs held while the signal is gone
+#define LOOP_QUEUE				(16)		//!< Depth of the dump & feedback queues of each channel with -loops (power of 2)
+#define LOOP_SLEEP				(50)		//!< Tracking thread sleeps this long (us) when every queue is empty
+#define REDUCE_MAX				(20)		//!< Most ms -reduce may go between early & late correlations
+#define REDUCE_CN0				(44.0)		//!< A channel only drops to prompt only above this CN0...
+#define REDUCE_CN0_EXIT			(41.0)		//!< ...and goes back to full rate below this one
+#define REDUCE_HOLD				(2000)		//!< ms of bit & frame lock above REDUCE_CN0 before it drops
+#define REDUCE_PLL_ERR			(0.125)		//!< PLL discriminator (cycles) past which it goes back to full rate
+/*----------------------------------------------------------------------------------------------*/
+
+
+/* Low bit depth IF (-bits), samples & wipeoff/code tables packed into bit-planes, LSB first */
+/*----------------------------------------------------------------------------------------------*/
+#define IF_BITS_THRESH			(10)		//!< 2 bit mode: |sample| above this (after the AGC, about 1 sigma) weighs 3, otherwise 1
+#define IF_BITS_WORDS			(FIFO_MAX_BLOCK*SAMPS_MS/32 + 1)	//!< Words per bit-plane of a FIFO packet, plus a guard word
+#define ROW_BITS_WORDS			(2*SAMPS_MS/32 + 1)	//!< Words per bit-plane of a code/wipeoff row, plus a guard word
+#define IF_BITS_GAIN_1			(11)			//!< 1 bit mode: scale the correlations back to the int16 path
+#define IF_BITS_GAIN_2			(5)			//!< 2 bit mode: scale the correlations back to the int16 path
+/*----------------------------------------------------------------------------------------------*/
+
+
+/* Correlation recording (-record), replayed through the channels & PVT by corr-replay */
+/*----------------------------------------------------------------------------------------------*/
+#define REC_FILE				"corr%02d.rec"	//!< One file per correlator
+#define REC_START				(0)			//!< Channel started, the Acq_Command_M passed to Channel::Start() follows
+#define REC_DUMP				(1)			//!< Dump, I[3], Q[3] & el then the taps' I & Q and their spacing follow
+#define REC_SKIP				(2)			//!< The channel skipped Corr_Record_S.value ms across a gap
+#define REC_MEAS				(3)			//!< Measurement tic Corr_Record_S.value, the Measurement_M sent to the PVT follows
+/*----------------------------------------------------------------------------------------------*/
+
+
+/* Thread scheduling, priorities are only used when run with -rt, affinity only with -pin */
+/*----------------------------------------------------------------------------------------------*/
+#define FIFO_PRIORITY			(80)		//!< SCHED_FIFO priority of the FIFO, highest so the IF ring never overflows
+#define CORR_PRIORITY			(70)		//!< SCHED_FIFO priority of the correlators
+#define LOOP_PRIORITY			(60)		//!< SCHED_FIFO priority of the tracking loops (-loops)
+#define PVT_PRIORITY			(40)		//!< SCHED_FIFO priority of the PVT
+#define ACQ_PRIORITY			(20)		//!< SCHED_FIFO priority of the acquisition
+#define TELEM_PRIORITY			(10)		//!< SCHED_FIFO priority of telemetry, ephemeris, commando and SV select
+
+/*! Groups of threads whose priority (-prio) and CPU (-cpu) can be set at runtime */
+enum SCHED_GROUPS
+{
+	SCHED_FIFO_GROUP,						//!< The FIFO, and the -capture & -p reader threads on its CPU
+	SCHED_CORR_GROUP,						//!< The correlators, spread over CPU_CORES CPUs from this one
+	SCHED_LOOP_GROUP,						//!< The tracking loops (-loops)
+	SCHED_PVT_GROUP,						//!< The PVT
+	SCHED_ACQ_GROUP,						//!< The acquisition
+	SCHED_TELEM_GROUP,						//!< Telemetry, ephemeris, commando, SV select and the keyboard
+	SCHED_GROUPS
+};
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -36,9 +36,11 @@ EXTERN class Keyboard		*pKeyboard;						//!< Handle user input
 EXTERN class FIFO			*pFIFO;							//!< Get data and pass it into the receiver
 EXTERN class PVT			*pPVT;							//!< Do the PVT solution
 EXTERN class Ephemeris		*pEphemeris;					//!< Extract the ephemeris
-EXTERN class Acquisition	*pAcquisition;					//!< Perform acquisitions
+EXTERN class Acquisition	*pAcquisition[ACQ_MAX_WORKERS];	//!< Perform acquisitions, gopt.acq_workers of them
+EXTERN class Acq_Capture	*pAcq_Capture;					//!< Collects the acquisition's IF behind the search (-capture)
 EXTERN class Correlator		*pCorrelators[MAX_CHANNELS];	//!< Bank of correlators
 EXTERN class Channel		*pChannels[MAX_CHANNELS];		//!< Channels (uses correlations to close the loops)
+EXTERN class Tracking		*pTracking;						//!< Runs the channels' loops off the correlator threads (-loops)
 EXTERN class SV_Select		*pSV_Select;					//!< Contains the channels and drives the channel objects
 EXTERN class Telemetry		*pTelemetry;					//!< Simple ncurses interface
 EXTERN class Post_Process	*pPost_Process;					//!< Drive the receiver from a recorded file
@@ -83,6 +85,7 @@ EXTERN int32 PVT_2_Telem_P[2];								//!< \ingroup PIPES Send latest nav soluti
 EXTERN int32 Ephem_2_Telem_P[2];							//!< \ingroup PIPES Send latest ephemeris to GUI
 EXTERN int32 SV_Select_2_Telem_P[2];						//!< \ingroup PIPES Send predicted SV states to GUI
 EXTERN int32 PVT_2_SV_Select_P[2];							//!< \ingroup PIPES Output nav state to sat select
+EXTERN int32 Chan_2_SV_Select_P[2];							//!< \ingroup PIPES A channel lost its SV
 EXTERN int32 Telem_2_Cmd_P[2];								//!< \ingroup PIPES Send received commands to Commando
 EXTERN int32 Cmd_2_Telem_P[2];								//!< \ingroup PIPES Send results of commands to Telemetry
 /*----------------------------------------------------------------------------------------------*/
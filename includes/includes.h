@@ -44,6 +44,7 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sched.h>
 #include <curses.h>
 #include <limits.h>
@@ -61,17 +62,24 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #include "structs.h"			//!< Structs used for interprocess communication
 #include "protos.h"				//!< Functions & thread prototypes
 #include "simd.h"				//!< Include the SIMD functionality
+#include "x86_t.h"				//!< Compile time specialized kernels
 /*----------------------------------------------------------------------------------------------*/
 
 /* Include the "Threaded Objects" */
 /*----------------------------------------------------------------------------------------------*/
+#include "histogram.h"			//!< Latency histograms
+#include "spsc.h"				//!< Lock-free single producer/consumer queue
+#include "loop_bank.h"			//!< Tracking loops of many channels at once
 #include "threaded_object.h"	//!< Base class for threaded object
 #include "fft.h"				//!< Fixed point FFT object
+#include "signal_gen.h"			//!< L1 C/A IF simulator
 #include "fifo.h"				//!< Circular buffer for Importing IF data
 #include "keyboard.h"			//!< Handle user input via keyboard
 #include "channel.h"			//!< Tracking channels
 #include "correlator.h"			//!< Correlator
+#include "tracking.h"			//!< Tracking loops on their own thread
 #include "acquisition.h"		//!< Acquisition
+#include "acq_capture.h"		//!< Acquisition IF windows on their own thread
 #include "pvt.h"				//!< PVT solution
 #include "ephemeris.h"			//!< Ephemeris decode
 #include "telemetry.h"			//!< Ncurses telemetry
@@ -21,3 +21,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 ************************************************************************************************/
 
 #define _lrotl(X,N)		((X << N) ^ (X >> (32-N)))			//!< Used in the parity check algorithm
+
+#define NS_2_US16(X)	((uint16)(((X)/1000) > 0xFFFF ? 0xFFFF : ((X)/1000)))	//!< Nanoseconds to saturated 16 bit microseconds for Task_Health_M
+#define SCHED_PRIO(X)	((int32)(((X) >> 16) & 0xff))				//!< Unpack the priority from Task_Health_M.sched
+#define SCHED_NODE(X)	((int32)(int8)(((X) >> 8) & 0xff))		//!< Unpack the NUMA node from Task_Health_M.sched, -1 if unknown
+#define SCHED_CPU(X)	((int32)(int8)((X) & 0xff))				//!< Unpack the CPU from Task_Health_M.sched, -1 if not pinned
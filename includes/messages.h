@@ -134,8 +134,12 @@ typedef struct Task_Health_M
 {
 
 	uint32 execution_tic[MAX_TASKS];	//!< Execution counters
-	uint32 start_tic[MAX_TASKS];		//!< Nucleus tic at function entry
-	uint32 stop_tic[MAX_TASKS];			//!< Nucleus tic at function exit
+	uint32 sched[MAX_TASKS];			//!< Policy<<24 | priority<<16 | NUMA node<<8 | CPU, 0xFF node/CPU for unpinned
+
+	/* Latency in us, saturated at 0xFFFF, p50/p99/max since startup */
+	uint16 proc[3][MAX_TASKS];			//!< Processing time, function entry to exit
+	uint16 wait[3][MAX_TASKS];			//!< Waiting time, function exit to the next entry
+	uint16 lag[3][MAX_TASKS];			//!< FIFO lag, age of the IF data when processed
 
 } Task_Health_M;
 
@@ -164,6 +168,7 @@ typedef struct Channel_M
 	float count;		//!< Number of accumulations that have been processed
 	float subframe;		//!< Current subframe number
 	float best_epoch;	//!< Best estimate of bit edge position
+	float el_every;		//!< Tracking mode, 1 is full rate, N is prompt only with early & late every N ms
 
 } Channel_M;
 
@@ -449,6 +454,10 @@ typedef struct FIFO_M
 	uint32 agc_scale;	//!< Value used for AGC scale
 	uint32 overflw;		//!< Overflows in last ms
 	uint32 nactive;		//!< Number of channels to process the measurment packet
+	uint32 gaps;		//!< Runs of packets dropped because the FIFO was full
+	uint32 gap_ms;		//!< Total ms dropped
+	uint32 max_gap;		//!< Longest run dropped (ms)
+	uint32 jumps;		//!< Discontinuities in the source itself (recorded file looping)
 
 } FIFO_M;
 
@@ -460,7 +469,8 @@ typedef struct _Acq_Command_M
 
 	int32 chan;			//!< Which channel this will be mapped to
 	int32 sv;			//!< Look for this SV
-	int32 type;			//!< Type (STRONG/MEDIUM/WEAK)
+	int32 type;			//!< Type (STRONG/MEDIUM/WEAK), the deepest to try, the one that answered in a result
+	int32 types;		//!< Bit mask of the types to try, shallowest first, see Acquisition::doAcqLadder()
 	int32 mindopp;		//!< Minimum Doppler
 	int32 maxdopp;		//!< Maximum Doppler
 	int32 antenna;		//!< Antenna number
@@ -470,6 +480,8 @@ typedef struct _Acq_Command_M
 	float delay;		//!< Delay in chips
 	float doppler;		//!< Doppler in Hz
 	float magnitude;	//!< Magnitude
+	float noise;		//!< Mean power over the whole search
+	float ratio;		//!< Magnitude over the next largest peak elsewhere in code phase
 
 } Acq_Command_M;
 
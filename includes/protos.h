@@ -27,7 +27,9 @@ void Parse_Arguments(int32 _argc, char* _argv[]);	//!< Parse command line argume
 int32 Hardware_Init(void);							//!< Initialize any hardware (for realtime mode)
 int32 Object_Init(void);								//!< Initialize all threaded objects and global variables
 int32 Pipes_Init(void);								//!< Initialize all pipes
+int32 Sched_Init(void);								//!< Assign scheduling policy/priority/affinity to the threads
 int32 Thread_Init(void);								//!< Finally start up the threads
+void Latency_Dump(void);								//!< Dump the task latency histograms
 void Thread_Shutdown(void);							//!< First step to shutdown, stopping the threads
 void Pipes_Shutdown(void);							//!< Close all the pipes
 void Object_Shutdown(void);							//!< Delete/free all objects
@@ -50,5 +52,8 @@ int32 Invert4x4(double A[4][4], double B[4][4]);
 void FormCCSDSPacketHeader(CCSDS_Packet_Header *_p, uint32 _apid, uint32 _sf, uint32 _pl, uint32 _cm, uint32 _tic);
 void DecodeCCSDSPacketHeader(CCSDS_Decoded_Header *_d, CCSDS_Packet_Header *_p);
 uint32 adler(uint8 *data, int32 len);
+uint64 monotonic_ns(void);
+int32 cpu_node(int32 _cpu);
+int32 numa_place(void *_buff, uint32 _bytes, int32 _node);
 /*----------------------------------------------------------------------------------------------*/
 
@@ -87,6 +87,22 @@ typedef struct _Options_S
 	int32	gui;						//!< Run with the GUI program (disables ncurses)
 	int32	serial;						//!< Output telemetry over the serial port (disables ncurses)
 	int32	usrp_internal;				//!< Run usrp-gps as a child process of receiver
+	int32	sched_fifo;					//!< Run the threads with SCHED_FIFO priorities
+	int32	pin_cpu;					//!< Pin the threads to CPUs starting at this one, -1 to not pin
+	int32	sched_prio[SCHED_GROUPS];	//!< SCHED_FIFO priority of each group of threads, see SCHED_GROUPS
+	int32	sched_cpu[SCHED_GROUPS];	//!< CPU of each group of threads, -1 to follow -pin
+	int32	corr_delays;				//!< Multipath taps (plus-minus) each correlator starts with, 0 for none
+	float	corr_spacing;				//!< Spacing of the multipath taps (chips)
+	int32	if_bits;					//!< Correlate on a 1 or 2 bit IF, 0 for the full int16 IF
+	int32	block_ms;					//!< ms of IF in each FIFO packet
+	int32	coast_ms;					//!< Coast a channel this long (ms) after loss of signal before reacquiring, 0 to kill it at once
+	int32	loop_thread;				//!< Run the tracking loops on their own thread, fed through SPSC queues
+	int32	loop_batch;					//!< On that thread, run the loops of the channels that dump together as a batch
+	int32	reduce_el;					//!< Strong locked channels correlate early & late only every this many ms, 0 for off
+	int32	corr_record;				//!< Record every dump & measurement to REC_FILE for corr-replay
+	int32	acq_capture;				//!< Collect the acquisition's IF on its own thread, behind the search
+	int32	acq_workers;				//!< Acquisition threads, more than one implies acq_capture
+	int32	acq_dwell;					//!< Incoherent sums of the coarse stage of a weak search (1-15), 0 for ACQ_WEAK_DWELL
 	char	filename_direct[1024];		//!< Skyview filename
 	char	filename_reflected[1024];	//!< Reflected filename
 
@@ -102,9 +118,16 @@ typedef struct ms_packet {
 
 	ms_packet *next;
 	int32 measurement;				//!< This packet is flagged for a measurement
-	int32 count;					//!< number of packets
+	int32 measurement_ms;			//!< ms within the packet the measurement falls on
+	int32 count;					//!< ms count of the first ms in the packet
+	int32 ms;						//!< ms of data in the packet
+	int64 sample;					//!< Source sample index of the first sample, jumps where samples were lost
+	int32 skip_ms;					//!< ms within the packet where the source jumps, if skip != 0
+	int32 skip;						//!< Samples the source jumps by (negative when a file loops) ahead of skip_ms
 	int32 accessed[MAX_CHANNELS+1];	//!< keep track of accesses
-	CPX data[SAMPS_MS];				//!< payload size
+	uint64 stamp;					//!< Monotonic time (ns) the packet was read from the pipe
+	CPX *data;						//!< payload, ms*SAMPS_MS samples
+	uint32 *bits;					//!< With -bits: I sign, Q sign, I magnitude, Q magnitude planes of data, IF_BITS_WORDS apart
 
 } ms_packet;
 /*----------------------------------------------------------------------------------------------*/
@@ -127,6 +150,7 @@ typedef struct _NCO_Command
 	uint32 z_count;		//!< Actual value
 	uint32 length;		//!< Integrate for this many ms
 	uint32 navigate;		//!< Use this correlator to navigate
+	uint32 el_every;		//!< Correlate early & late only every this many ms, 1 for every ms
 
 } NCO_Command_S;
 
@@ -139,21 +163,94 @@ typedef struct _Correlation_S
 
 	int32 I[3];
 	int32 Q[3];
+	int32 el;						//!< ms of the accumulation early & late were correlated on (-reduce)
+	int32 taps;						//!< Number of multipath taps below, 0 if they are off
+	int32 tap_I[CORR_MAX_TAPS];		//!< Multipath taps, earliest first
+	int32 tap_Q[CORR_MAX_TAPS];		//!< Multipath taps, earliest first
+	float spacing;					//!< Spacing of the multipath taps (chips)
 
 } Correlation_S;
 
 
 /*! \ingroup STRUCTS
- * Hold state information of the correlator
+ * Correlator to tracking thread (-loops), one per dump
+ */
+typedef struct _Corr_Dump_S
+{
+
+	uint32 gen;						//!< Which start of the correlator this belongs to
+	int32 skip;						//!< Not a dump, the channel should Skip() this many ms
+	int64 epochs;					//!< code_epochs of the correlator at the dump
+	Correlation_S corr;				//!< The dump itself
+
+} Corr_Dump_S;
+
+
+/*! \ingroup STRUCTS
+ * Tracking thread to correlator (-loops), the answer to one dump
+ */
+typedef struct _Loop_Feedback_S
+{
+
+	uint32 gen;						//!< Copied from the dump
+	int64 epochs;					//!< Copied from the dump
+	NCO_Command_S nco;				//!< What Channel::Accum() returned
+
+} Loop_Feedback_S;
+
+
+/*! \ingroup STRUCTS
+ * Leads every record of a correlation recording (-record), the payload for the type follows
+ */
+typedef struct _Corr_Record_S
+{
+
+	int32 type;						//!< REC_START, REC_DUMP, REC_SKIP or REC_MEAS
+	int32 value;					//!< REC_DUMP: taps that follow, REC_SKIP: ms skipped, REC_MEAS: the tic
+	uint32 count;					//!< Packet count (ms) of the packet being correlated
+	uint32 _1ms_epoch;				//!< Correlator's epochs
+	uint32 _20ms_epoch;
+	uint32 _z_count;
+	int64 epochs;					//!< Correlator's code_epochs
+	double carrier_nco;				//!< NCOs the dump was correlated with
+	double code_nco;
+
+} Corr_Record_S;
+
+
+/*! \ingroup STRUCTS
+ * Multipath taps of one channel, logged alongside Channel_M
+ */
+typedef struct _Channel_Taps_S
+{
+
+	int32 chan;						//!< Channel #
+	int32 sv;						//!< SV/PRN number
+	int32 count;					//!< Accumulations processed by the channel
+	int32 taps;						//!< Number of taps
+	float spacing;					//!< Spacing of the taps (chips)
+	int32 I[CORR_MAX_TAPS];			//!< Inphase, earliest first
+	int32 Q[CORR_MAX_TAPS];			//!< Quadrature, earliest first
+
+} Channel_Taps_S;
+
+
+/*! \ingroup STRUCTS
+ * Hold state information of the correlator. The NCOs are 64 bit phase accumulators with
+ * NCO_FRAC_BITS of fraction, all in the same format and leading the struct so that a
+ * batch of channels can be advanced with 64 bit integer SIMD.
  */
 typedef struct _Correlator_State_S
 {
 
-	double 	code_phase; 		//!< Code phase (chips)
-	double 	carrier_phase;		//!< Carrier phase (cycles)
+	int64	code_phase_fix;		//!< Code phase (chips), mod 1023
+	int64	code_inc;			//!< Code phase increment per sample
+	int64	carrier_phase_fix;	//!< Carrier phase (cycles), mod 1
+	int64	carrier_inc;		//!< Carrier phase increment per sample
+	int64	code_epochs;		//!< Whole C/A code periods since the correlator was initialized
+	int64	carrier_cycles;		//!< Whole carrier cycles since the correlator was initialized
+
 	double  carrier_phase_prev;	//!< Used for phase correction to correlations
-	double 	code_phase_mod;		//!< Code phase (chips), mod 1023
-	double 	carrier_phase_mod;	//!< Carrier phsae (cycles), mod 1
 	double 	code_nco;			//!< Code NCO
 	double 	carrier_nco;		//!< Carrier NCO
 
@@ -166,10 +263,13 @@ typedef struct _Correlator_State_S
 	uint32  _20ms_epoch;		//!< _20ms_epoch
 	uint32 	_z_count;			//!< Keep track of the z count
 	uint32  rollover;			//!< rollover point of C/A code in next ms packet
-	uint32	cbin[3];			//!< Code bins
+	uint32	cbin[CORR_MAX_TAPS+3];	//!< Code bins
 	uint32	sbin;				//!< Carriers bins
+	uint32	taps;				//!< Multipath taps in the current accumulation
+	uint32	el_every;			//!< Early & late only every this many code periods, 0 or 1 for all of them
+	uint32	el;					//!< Early & late are correlated in the current code period
 	uint32	nav_history[MEASUREMENT_DELAY]; //!< keep track of the navigate flag
-	MIX		*pcode[3];			//!< pointer to early-prompt-late codes
+	MIX		*pcode[CORR_MAX_TAPS+3];	//!< pointer to early-prompt-late codes, followed by the multipath taps
 	CPX		*psine;				//!< pointer to Doppler removal vector
 
 
@@ -234,6 +334,20 @@ typedef struct _Chan_2_Ephem_S {
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*! \ingroup STRUCTS
+ * A channel let its SV go, sent to SV_Select so it can put the channel back to work at once
+ */
+typedef struct _Chan_2_SV_Select_S {
+
+	int32 chan;					//!< Channel number
+	int32 sv;					//!< The SV it was tracking
+	int32 locked;				//!< It had bit lock, so the SV is real and worth reacquiring first
+	float doppler;				//!< Last Doppler (Hz)
+
+} Chan_2_SV_Select_S;
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -287,6 +401,19 @@ typedef struct _Acq_History_S
 	int32 doppler;		//!< Last doppler
 
 } Acq_History_S;
+
+
+/*! \ingroup STRUCTS
+ * One of the top ACQ_PEAKS correlation peaks of an acquisition
+ */
+typedef struct _Acq_Peak_S
+{
+
+	int32 mag;			//!< Power
+	int32 index;		//!< Code phase (samples)
+	float doppler;		//!< Doppler (Hz)
+
+} Acq_Peak_S;
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -22,6 +22,36 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 #include "includes.h"
 
+/*! Names of the SCHED_GROUPS on the command line */
+static const char *sched_names[SCHED_GROUPS] = {"fifo", "corr", "loops", "pvt", "acq", "telem"};
+
+/*! The SCHED_GROUPS entry called _name, -1 if there is none */
+/*----------------------------------------------------------------------------------------------*/
+int32 sched_group(const char *_name)
+{
+	int32 lcv;
+
+	for(lcv = 0; lcv < SCHED_GROUPS; lcv++)
+		if(strcmp(_name, sched_names[lcv]) == 0)
+			return(lcv);
+
+	return(-1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*! The _n'th of CPU_CORES consecutive CPUs from _first, -1 (not pinned) if _first is */
+/*----------------------------------------------------------------------------------------------*/
+int32 sched_spread(int32 _first, int32 _n, int32 _ncpus)
+{
+	if(_first < 0)
+		return(-1);
+
+	return((_first + (_n % CPU_CORES)) % _ncpus);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*! Print out command arguments to std_out */
 /*----------------------------------------------------------------------------------------------*/
 void usage(int32 argc, char* argv[])
@@ -44,6 +74,22 @@ void usage(int32 argc, char* argv[])
 	fprintf(stderr, "[-ser] run receiver with the GUI app over a serial port\n");
 	fprintf(stderr, "[-w] start receiver in warm start, using almanac and last good position\n");
 	fprintf(stderr, "[-u] run receiver with usrp-gps as child process\n");
+	fprintf(stderr, "[-rt] run the threads with SCHED_FIFO priorities (needs root)\n");
+	fprintf(stderr, "[-pin] <N> pin the threads to CPUs, starting at CPU N\n");
+	fprintf(stderr, "[-prio] <group> <N> SCHED_FIFO priority of a group of threads with -rt (1-99)\n");
+	fprintf(stderr, "[-cpu] <group> <N> pin a group of threads to CPU N, overrides -pin for it\n");
+	fprintf(stderr, "        groups are fifo, corr, loops, pvt, acq & telem\n");
+	fprintf(stderr, "[-taps] <N> <spacing> run N multipath taps (plus-minus) spaced by this many chips\n");
+	fprintf(stderr, "[-bits] <1|2> correlate on a 1 or 2 bit IF with XOR/popcount\n");
+	fprintf(stderr, "[-block] <N> move the IF through the FIFO and correlators N ms at a time (1-%d)\n", FIFO_MAX_BLOCK);
+	fprintf(stderr, "[-coast] <ms> coast a channel this long after it loses the signal before reacquiring, 0 for never (default %d)\n", COAST_MS);
+	fprintf(stderr, "[-loops] run the tracking loops on their own thread, off the correlators\n");
+	fprintf(stderr, "[-batch] as -loops, running the PLL/DLL of all the channels that dump together at once\n");
+	fprintf(stderr, "[-reduce] <N> channels in strong, solid lock correlate early & late only every N ms (2-%d)\n", REDUCE_MAX);
+	fprintf(stderr, "[-record] record every correlator's dumps & measurements to corrNN.rec, see corr-replay\n");
+	fprintf(stderr, "[-capture] collect the next acquisition IF window on its own thread while the current one is searched\n");
+	fprintf(stderr, "[-acq_workers] <N> run N acquisition threads on the -capture windows, with N requests in flight (1-%d)\n", ACQ_MAX_WORKERS);
+	fprintf(stderr, "[-acq_dwell] <N> first weak search stage sums only N ms, faster but less sensitive, ~2 dB at 5 (1-15, default %d)\n", ACQ_WEAK_DWELL);
 	fprintf(stderr, "\n");
 
 	exit(1);
@@ -56,6 +102,7 @@ void usage(int32 argc, char* argv[])
 void echo_options()
 {
 	FILE *fp;
+	int32 lcv;
 
 	/* Do some error checking */
 	if(gopt.post_process)
@@ -99,6 +146,22 @@ void echo_options()
 	fprintf(stderr, "ncurses:\t\t %d\n",gopt.ncurses);
 	fprintf(stderr, "gui:\t\t\t %d\n",gopt.gui);
 	fprintf(stderr, "serial:\t\t\t %d\n",gopt.serial);
+	fprintf(stderr, "sched_fifo:\t\t %d\n",gopt.sched_fifo);
+	fprintf(stderr, "pin_cpu:\t\t %d\n",gopt.pin_cpu);
+	for(lcv = 0; lcv < SCHED_GROUPS; lcv++)
+		fprintf(stderr, "%s_group:\t\t prio %d cpu %d\n",sched_names[lcv],gopt.sched_prio[lcv],gopt.sched_cpu[lcv]);
+	fprintf(stderr, "corr_delays:\t\t %d\n",gopt.corr_delays);
+	fprintf(stderr, "corr_spacing:\t\t %.3f\n",gopt.corr_spacing);
+	fprintf(stderr, "if_bits:\t\t %d\n",gopt.if_bits);
+	fprintf(stderr, "block_ms:\t\t %d\n",gopt.block_ms);
+	fprintf(stderr, "coast_ms:\t\t %d\n",gopt.coast_ms);
+	fprintf(stderr, "loop_thread:\t\t %d\n",gopt.loop_thread);
+	fprintf(stderr, "loop_batch:\t\t %d\n",gopt.loop_batch);
+	fprintf(stderr, "reduce_el:\t\t %d\n",gopt.reduce_el);
+	fprintf(stderr, "corr_record:\t\t %d\n",gopt.corr_record);
+	fprintf(stderr, "acq_capture:\t\t %d\n",gopt.acq_capture);
+	fprintf(stderr, "acq_workers:\t\t %d\n",gopt.acq_workers);
+	fprintf(stderr, "acq_dwell:\t\t %d\n",gopt.acq_dwell);
 	fprintf(stderr, "filename_direct:\t %s\n",gopt.filename_direct);
 	fprintf(stderr, "filename_reflected:\t %s\n",gopt.filename_reflected);
 	fprintf(stderr, "\n");
@@ -131,6 +194,28 @@ void Parse_Arguments(int32 argc, char* argv[])
 	gopt.corr_sleep 	= 500;
 	gopt.startup		= COLD_START;
 	gopt.usrp_internal	= 0;
+	gopt.sched_fifo		= 0;
+	gopt.pin_cpu		= -1;
+	gopt.sched_prio[SCHED_FIFO_GROUP]	= FIFO_PRIORITY;
+	gopt.sched_prio[SCHED_CORR_GROUP]	= CORR_PRIORITY;
+	gopt.sched_prio[SCHED_LOOP_GROUP]	= LOOP_PRIORITY;
+	gopt.sched_prio[SCHED_PVT_GROUP]	= PVT_PRIORITY;
+	gopt.sched_prio[SCHED_ACQ_GROUP]	= ACQ_PRIORITY;
+	gopt.sched_prio[SCHED_TELEM_GROUP]	= TELEM_PRIORITY;
+	for(lcv = 0; lcv < SCHED_GROUPS; lcv++)
+		gopt.sched_cpu[lcv] = -1;
+	gopt.corr_delays	= 0;
+	gopt.corr_spacing	= CORR_SPACING;
+	gopt.if_bits		= 0;
+	gopt.block_ms		= 1;
+	gopt.coast_ms		= COAST_MS;
+	gopt.loop_thread	= 0;
+	gopt.loop_batch		= 0;
+	gopt.reduce_el		= 0;
+	gopt.corr_record	= 0;
+	gopt.acq_capture	= 0;
+	gopt.acq_workers	= 1;
+	gopt.acq_dwell		= ACQ_WEAK_DWELL;
 	strcpy(gopt.filename_direct, "data.bda");
 	strcpy(gopt.filename_reflected, "rdata.bda");
 
@@ -215,6 +300,158 @@ void Parse_Arguments(int32 argc, char* argv[])
 		{
 			gopt.usrp_internal = 1;
 		}
+		else if(strcmp(argv[lcv],"-rt") == 0)
+		{
+			gopt.sched_fifo = 1;
+		}
+		else if(strcmp(argv[lcv],"-pin") == 0)
+		{
+			if((argc > lcv+1) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.pin_cpu = atoi(argv[lcv]);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-prio") == 0)
+		{
+			if((argc > lcv+2) && (sched_group(argv[lcv+1]) >= 0) && (atoi(argv[lcv+2]) >= 1) && (atoi(argv[lcv+2]) <= 99))
+			{
+				gopt.sched_prio[sched_group(argv[lcv+1])] = atoi(argv[lcv+2]);
+				lcv += 2;
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-cpu") == 0)
+		{
+			if((argc > lcv+2) && (sched_group(argv[lcv+1]) >= 0) && isdigit(argv[lcv+2][0]))
+			{
+				gopt.sched_cpu[sched_group(argv[lcv+1])] = atoi(argv[lcv+2]);
+				lcv += 2;
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-bits") == 0)
+		{
+			if((argc > lcv+1) && ((atoi(argv[lcv+1]) == 1) || (atoi(argv[lcv+1]) == 2)))
+			{
+				lcv++;
+				gopt.if_bits = atoi(argv[lcv]);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-block") == 0)
+		{
+			if((argc > lcv+1) && (atoi(argv[lcv+1]) >= 1) && (atoi(argv[lcv+1]) <= FIFO_MAX_BLOCK))
+			{
+				lcv++;
+				gopt.block_ms = atoi(argv[lcv]);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-loops") == 0)
+		{
+			gopt.loop_thread = 1;
+		}
+		else if(strcmp(argv[lcv],"-batch") == 0)
+		{
+			gopt.loop_thread = 1;
+			gopt.loop_batch = 1;
+		}
+		else if(strcmp(argv[lcv],"-record") == 0)
+		{
+			gopt.corr_record = 1;
+		}
+		else if(strcmp(argv[lcv],"-capture") == 0)
+		{
+			gopt.acq_capture = 1;
+		}
+		else if(strcmp(argv[lcv],"-acq_workers") == 0)
+		{
+			if((argc > lcv+1) && (atoi(argv[lcv+1]) >= 1) && (atoi(argv[lcv+1]) <= ACQ_MAX_WORKERS))
+			{
+				lcv++;
+				gopt.acq_workers = atoi(argv[lcv]);
+
+				/* The workers share the capture windows, they cannot all pull their own IF from the FIFO */
+				if(gopt.acq_workers > 1)
+					gopt.acq_capture = 1;
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-acq_dwell") == 0)
+		{
+			if((argc > lcv+1) && (atoi(argv[lcv+1]) >= 1) && (atoi(argv[lcv+1]) <= 15))
+			{
+				lcv++;
+				gopt.acq_dwell = atoi(argv[lcv]);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-reduce") == 0)
+		{
+			if((argc > lcv+1) && (atoi(argv[lcv+1]) >= 2) && (atoi(argv[lcv+1]) <= REDUCE_MAX))
+			{
+				lcv++;
+				gopt.reduce_el = atoi(argv[lcv]);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-coast") == 0)
+		{
+			if((argc > lcv+1) && (atoi(argv[lcv+1]) >= 0))
+			{
+				lcv++;
+				gopt.coast_ms = atoi(argv[lcv]);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-taps") == 0)
+		{
+			if((argc > lcv+2) && isdigit(argv[lcv+1][0]))
+			{
+				gopt.corr_delays = atoi(argv[lcv+1]);
+				gopt.corr_spacing = atof(argv[lcv+2]);
+				lcv += 2;
+
+				if((gopt.corr_delays > CORR_MAX_DELAYS) || (gopt.corr_spacing <= 0) || (gopt.corr_delays*gopt.corr_spacing > CORR_MAX_SPAN))
+				{
+					fprintf(stderr, "\nAt most %d taps (plus-minus) within %.1f chips of prompt\n", CORR_MAX_DELAYS, CORR_MAX_SPAN);
+					usage(argc, argv);
+				}
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
 		else
 			usage(argc, argv);
 	}
@@ -227,7 +464,7 @@ void Parse_Arguments(int32 argc, char* argv[])
 
 /*! Initialize any hardware (for realtime mode) */
 /*----------------------------------------------------------------------------------------------*/
-int32 Hardware_Init(void)
+int32 Hardware_Init(void)
 {
 
 	if(CPU_MMX())
@@ -283,10 +520,10 @@ int32 Hardware_Init(void)
 }
 /*----------------------------------------------------------------------------------------------*/
 
-
-/*----------------------------------------------------------------------------------------------*/
-/*! Initialize all threaded objects and global variables */
-int32 Object_Init(void)
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Initialize all threaded objects and global variables */
+int32 Object_Init(void)
 {
 	int32 lcv;
 	int32 failed;
@@ -298,7 +535,11 @@ int32 Object_Init(void)
 	pKeyboard = new Keyboard;
 
 	/* Now do the hard work? */
-	pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY);
+	for(lcv = 0; lcv < gopt.acq_workers; lcv++)
+		pAcquisition[lcv] = new Acquisition(SAMPLE_FREQUENCY, IF_FREQUENCY, lcv);
+
+	if(gopt.acq_capture)
+		pAcq_Capture = new Acq_Capture;
 
 	pEphemeris = new Ephemeris;
 
@@ -313,6 +554,9 @@ int32 Object_Init(void)
 	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
 		pCorrelators[lcv] =  new Correlator(lcv);
 
+	if(gopt.loop_thread)
+		pTracking = new Tracking;
+
 	if(gopt.ncurses)
 		pTelemetry = new Telemetry();
 	else
@@ -342,8 +586,8 @@ int32 Object_Init(void)
 
 
 /*! Initialize all pipes */
-/*----------------------------------------------------------------------------------------------*/
-int32 Pipes_Init(void)
+/*----------------------------------------------------------------------------------------------*/
+int32 Pipes_Init(void)
 {
 	int32 lcv;
 
@@ -370,6 +614,12 @@ int32 Pipes_Init(void)
 	fcntl(PVT_2_SV_Select_P[WRITE], F_SETFL, O_NONBLOCK);
 	fcntl(PVT_2_SV_Select_P[READ], F_SETFL, O_NONBLOCK);
 
+	/* SV_Select polls these, and a channel never waits on it */
+	fcntl(Acq_2_Trak_P[READ], F_SETFL, O_NONBLOCK);
+	pipe((int *)Chan_2_SV_Select_P);
+	fcntl(Chan_2_SV_Select_P[WRITE], F_SETFL, O_NONBLOCK);
+	fcntl(Chan_2_SV_Select_P[READ], F_SETFL, O_NONBLOCK);
+
 	/* Commando pipes */
 	pipe((int *)Telem_2_Cmd_P);
 	pipe((int *)Cmd_2_Telem_P);
@@ -392,19 +642,102 @@ int32 Pipes_Init(void)
 
 	return(1);
 
-}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*! Assign the scheduling policy, priority and CPU of each thread. With -pin the correlators
+ * get CPU_CORES consecutive CPUs, followed by one for the FIFO, one for the acquisition and one
+ * shared by everything else. Pick the first CPU so they all land on the same NUMA node. -prio
+ * and -cpu then override the priority and CPU of each of the SCHED_GROUPS. */
+/*----------------------------------------------------------------------------------------------*/
+int32 Sched_Init(void)
+{
+	int32 lcv;
+	int32 policy;
+	int32 ncpus;
+	int32 cpu[SCHED_GROUPS];
+	int32 *prio;
+
+	policy = gopt.sched_fifo ? SCHED_FIFO : SCHED_OTHER;
+	prio = gopt.sched_prio;
+
+	/* The -pin layout, the first CPU of each group */
+	cpu[SCHED_CORR_GROUP]	= 0;
+	cpu[SCHED_FIFO_GROUP]	= CPU_CORES;
+	cpu[SCHED_ACQ_GROUP]	= CPU_CORES+1;
+	cpu[SCHED_LOOP_GROUP]	= CPU_CORES+2;
+	cpu[SCHED_PVT_GROUP]	= CPU_CORES+2;
+	cpu[SCHED_TELEM_GROUP]	= CPU_CORES+2;
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	for(lcv = 0; lcv < SCHED_GROUPS; lcv++)
+	{
+		if(gopt.sched_cpu[lcv] >= 0)
+			cpu[lcv] = gopt.sched_cpu[lcv] % ncpus;
+		else if(gopt.pin_cpu >= 0)
+			cpu[lcv] = (gopt.pin_cpu + cpu[lcv]) % ncpus;
+		else
+			cpu[lcv] = -1;
+	}
+
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		pCorrelators[lcv]->Set_Scheduling(policy, prio[SCHED_CORR_GROUP], sched_spread(cpu[SCHED_CORR_GROUP], lcv / CORR_PER_CPU, ncpus));
+
+	pFIFO->Set_Scheduling(policy, prio[SCHED_FIFO_GROUP], cpu[SCHED_FIFO_GROUP]);
+	pAcquisition[0]->Set_Scheduling(policy, prio[SCHED_ACQ_GROUP], cpu[SCHED_ACQ_GROUP]);
+
+	/* More workers go on the correlators' CPUs, below them in priority they only take what is left */
+	for(lcv = 1; lcv < gopt.acq_workers; lcv++)
+		pAcquisition[lcv]->Set_Scheduling(policy, prio[SCHED_ACQ_GROUP], sched_spread(cpu[SCHED_CORR_GROUP], lcv - 1, ncpus));
+
+	/* Mostly waits on the FIFO, so it shares the FIFO's CPU and leaves the search its own */
+	if(gopt.acq_capture)
+		pAcq_Capture->Set_Scheduling(policy, prio[SCHED_ACQ_GROUP], cpu[SCHED_FIFO_GROUP]);
+
+	/* Only hands out requests, so it goes with the other light tasks */
+	pSV_Select->Set_Scheduling(policy, prio[SCHED_TELEM_GROUP], cpu[SCHED_TELEM_GROUP]);
+	pPVT->Set_Scheduling(policy, prio[SCHED_PVT_GROUP], cpu[SCHED_PVT_GROUP]);
+	pEphemeris->Set_Scheduling(policy, prio[SCHED_TELEM_GROUP], cpu[SCHED_TELEM_GROUP]);
+	pCommando->Set_Scheduling(policy, prio[SCHED_TELEM_GROUP], cpu[SCHED_TELEM_GROUP]);
+	pKeyboard->Set_Scheduling(SCHED_OTHER, 0, cpu[SCHED_TELEM_GROUP]);
+
+	if(gopt.loop_thread)
+		pTracking->Set_Scheduling(policy, prio[SCHED_LOOP_GROUP], cpu[SCHED_LOOP_GROUP]);
+
+	if(gopt.ncurses)
+		pTelemetry->Set_Scheduling(policy, prio[SCHED_TELEM_GROUP], cpu[SCHED_TELEM_GROUP]);
+	else
+		pSerial_Telemetry->Set_Scheduling(policy, prio[SCHED_TELEM_GROUP], cpu[SCHED_TELEM_GROUP]);
+
+	/* Feeds the FIFO, so keep it on the FIFO's CPU */
+	if(gopt.post_process)
+		pPost_Process->Set_Scheduling(SCHED_OTHER, 0, cpu[SCHED_FIFO_GROUP]);
+
+	if(gopt.verbose)
+	{
+		printf("Cleared Sched Init\n");
+		fflush(stdout);
+	}
+
+	return(1);
+
+}
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*! Finally start up the threads */
-/*----------------------------------------------------------------------------------------------*/
-int32 Thread_Init(void)
+/*----------------------------------------------------------------------------------------------*/
+int32 Thread_Init(void)
 {
 	int32 lcv;
 
 	/* Set the global run flag to true */
 	grun = 0x1;
 
+	/* Must happen before any of the threads are created */
+	Sched_Init();
+
 	/* Start the keyboard thread to handle user input from stdio */
 	pKeyboard->Start();
 
@@ -420,8 +753,16 @@ int32 Thread_Init(void)
 		pCorrelators[lcv]->Start();
 	}
 
-	/* Start up the acquistion */
-	pAcquisition->Start();
+	/* And the loops they feed */
+	if(gopt.loop_thread)
+		pTracking->Start();
+
+	/* Start up the acquistion, and what feeds it */
+	if(gopt.acq_capture)
+		pAcq_Capture->Start();
+
+	for(lcv = 0; lcv < gopt.acq_workers; lcv++)
+		pAcquisition[lcv]->Start();
 
 	/* Start up the ephemeris */
 	pEphemeris->Start();
@@ -48,8 +48,16 @@ void Thread_Shutdown(void)
 	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
 		pCorrelators[lcv]->Stop();
 
+	/* Stop the loops */
+	if(gopt.loop_thread)
+		pTracking->Stop();
+
 	/* Stop the acquistion */
-	pAcquisition->Stop();
+	for(lcv = 0; lcv < gopt.acq_workers; lcv++)
+		pAcquisition[lcv]->Stop();
+
+	if(gopt.acq_capture)
+		pAcq_Capture->Stop();
 
 	/* Stop the ephemeris */
 	pEphemeris->Stop();
@@ -64,6 +72,95 @@ void Thread_Shutdown(void)
 	if(gopt.post_process)
 		pPost_Process->Stop();
 
+	/* Everything is stopped, the histograms are final */
+	Latency_Dump();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Write each task's latency histograms to Latency.txt (and stdout if verbose), in ns */
+void Latency_Dump(void)
+{
+	FILE *fp, *out;
+	int32 lcv, lcv2;
+	char name[32];
+	Threaded_Object *tasks[MAX_CHANNELS+16];
+	const char *names[MAX_CHANNELS+16];
+	int32 ntasks;
+
+	ntasks = 0;
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		tasks[ntasks] = pCorrelators[lcv];
+		names[ntasks++] = "CORRELATOR";
+	}
+
+	if(gopt.loop_thread)
+	{
+		tasks[ntasks] = pTracking;		names[ntasks++] = "TRACKING";
+	}
+
+	tasks[ntasks] = pFIFO;				names[ntasks++] = "FIFO";
+	for(lcv = 0; lcv < gopt.acq_workers; lcv++)
+	{
+		tasks[ntasks] = pAcquisition[lcv];	names[ntasks++] = "ACQUISITION";
+	}
+
+	if(gopt.acq_capture)
+	{
+		tasks[ntasks] = pAcq_Capture;	names[ntasks++] = "ACQ_CAPTURE";
+	}
+
+	tasks[ntasks] = pSV_Select;			names[ntasks++] = "SV_SELECT";
+	tasks[ntasks] = pPVT;				names[ntasks++] = "PVT";
+	tasks[ntasks] = pEphemeris;			names[ntasks++] = "EPHEMERIS";
+	tasks[ntasks] = pCommando;			names[ntasks++] = "COMMANDO";
+	tasks[ntasks] = pKeyboard;			names[ntasks++] = "KEYBOARD";
+
+	if(gopt.ncurses)
+	{
+		tasks[ntasks] = pTelemetry;			names[ntasks++] = "TELEMETRY";
+	}
+	else
+	{
+		tasks[ntasks] = pSerial_Telemetry;	names[ntasks++] = "TELEMETRY";
+	}
+
+	if(gopt.post_process)
+	{
+		tasks[ntasks] = pPost_Process;		names[ntasks++] = "POST_PROCESS";
+	}
+
+	fp = fopen("Latency.txt", "wt");
+
+	for(lcv2 = 0; lcv2 < 2; lcv2++)
+	{
+		out = lcv2 ? stdout : fp;
+
+		if((out == NULL) || ((out == stdout) && !gopt.verbose))
+			continue;
+
+		fprintf(out, "%-17s %-12s %10s %10s %10s %10s %10s %10s %10s\n", "Task", "Hist", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+		fprintf(out, "------------------------------------------------------------------------------------------------------------\n");
+
+		for(lcv = 0; lcv < ntasks; lcv++)
+		{
+			if(lcv < MAX_CHANNELS)
+				sprintf(name, "%s %02d", names[lcv], lcv);
+			else
+				sprintf(name, "%s", names[lcv]);
+
+			fprintf(out, "%-17s ", name); tasks[lcv]->GetProc()->Print(out, "proc");
+			fprintf(out, "%-17s ", name); tasks[lcv]->GetWait()->Print(out, "wait");
+			fprintf(out, "%-17s ", name); tasks[lcv]->GetLag()->Print(out, "lag");
+		}
+	}
+
+	if(fp != NULL)
+		fclose(fp);
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -94,6 +191,8 @@ void Pipes_Shutdown(void)
 	close(Telem_2_Cmd_P[WRITE]);
 	close(Cmd_2_Telem_P[READ]);
 	close(Cmd_2_Telem_P[WRITE]);
+	close(Chan_2_SV_Select_P[READ]);
+	close(Chan_2_SV_Select_P[WRITE]);
 
 	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
 	{
@@ -123,11 +222,18 @@ void Object_Shutdown(void)
 	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
 		delete pChannels[lcv];
 
+	if(gopt.loop_thread)
+		delete pTracking;
+
+	if(gopt.acq_capture)
+		delete pAcq_Capture;
+
 	if(gopt.post_process)
 		delete pPost_Process;
 
 	delete pKeyboard;
-	delete pAcquisition;
+	for(lcv = 0; lcv < gopt.acq_workers; lcv++)
+		delete pAcquisition[lcv];
 	delete pEphemeris;
 	delete pFIFO;
 	delete pSV_Select;
@@ -36,10 +36,16 @@ Channel::Channel(int32 _chan)
 	{
 		sprintf(fname,"chan%02d.dat",chan);
 		fp = fopen(fname, "wb");
+
+		sprintf(fname,"taps%02d.dat",chan);
+		tfp = fopen(fname, "wb");
 	}
 
 	pFFT = new FFT(FREQ_LOCK_POINTS);
 
+	gen = 0;
+	batch_slot = -1;
+
 	Clear();
 
 }
@@ -53,7 +59,10 @@ Channel::~Channel()
 	delete pFFT;
 
 	if(gopt.log_channel)
+	{
 		fclose(fp);
+		fclose(tfp);
+	}
 
 	if(gopt.verbose)
 		printf("Destructing Channel %d\n",chan);
@@ -80,6 +89,7 @@ void Channel::Clear()
 	I[0] = I[1] = I[2] = 1;
 	Q[0] = Q[1] = Q[2] = 1;
 	P[0] = P[1] = P[2] = 1;
+	memset(&taps, 0x0, sizeof(Channel_Taps_S));
 	I_prev = Q_prev = 1;		//Important to prevent divide by zero
 	I_avg = 1;
 	Q_var = 1;
@@ -115,6 +125,18 @@ void Channel::Clear()
 	bit_number = 0;
 	subframe = 0;
 
+	/* Coasting */
+	state = CHANNEL_TRACK;
+	coast_ms = 0;
+	coast_carrier = 0;
+	coast_doppler = 0;
+	coast_predict = false;
+
+	/* Reduced rate tracking */
+	el = 0;
+	el_every = 1;
+	reduce_ms = 0;
+
 	/* FFT and buffer for FFT estimate of frequency after initial lock */
 	freq_lock_ticks = 0;
 	freq_lock = false;
@@ -175,6 +197,30 @@ Channel_M Channel::getPacket()
 void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 {
 
+	IncStartTic();
+
+	/* Dump accumulation and do tracking according to integration length */
+	if(Integrate(corr))
+	{
+		Export();
+		DumpAccum();
+	}
+
+	Finish(_feedback);
+
+	IncStopTic();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Add in a 1 ms correlation, returns true when the integration is due to be dumped */
+bool Channel::Integrate(Correlation_S *corr)
+{
+
+	int32 lcv;
+
 	corr->I[0] >>= 3;
 	corr->I[1] >>= 3;
 	corr->I[2] >>= 3;
@@ -183,6 +229,7 @@ void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 	corr->Q[2] >>= 3;
 
 	/* Integrate */
+	el += corr->el;
 	I[0] += corr->I[0];
 	I[1] += corr->I[1];
 	I[2] += corr->I[2];
@@ -190,6 +237,15 @@ void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 	Q[1] += corr->Q[1];
 	Q[2] += corr->Q[2];
 
+	/* Multipath taps */
+	taps.taps = corr->taps;
+	taps.spacing = corr->spacing;
+	for(lcv = 0; lcv < taps.taps; lcv++)
+	{
+		taps.I[lcv] += corr->tap_I[lcv] >> 3;
+		taps.Q[lcv] += corr->tap_Q[lcv] >> 3;
+	}
+
 	/* Always do these, a running sum of past 20 1ms accumulations */
 	I_sum20	+= corr->I[1] - I_buff[_1ms_epoch];
 	Q_sum20 += corr->Q[1] - Q_buff[_1ms_epoch];
@@ -201,12 +257,16 @@ void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 	/* Lowpass filter */
 	P_buff[_1ms_epoch] = (63*P_buff[_1ms_epoch]	+ (I_sum20>>6)*(I_sum20>>6)	+ (Q_sum20>>6)*(Q_sum20>>6)+32)>>6;
 
-	/* Dump accumulation and do tracking according to integration length */
-	if((_1ms_epoch % len) == 0)
-	{
-		Export();
-		DumpAccum();
-	}
+	return((_1ms_epoch % len) == 0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! The every ms part of Accum(), after any dump, fills in the feedback to the correlator */
+void Channel::Finish(NCO_Command_S *_feedback)
+{
 
 	/* These functions must be called every ms */
 	BitLock();
@@ -222,6 +282,7 @@ void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 	/* copy over the updated NCO values */
 	_feedback->carrier_nco = carrier_nco;
 	_feedback->code_nco = code_nco;
+	_feedback->el_every = el_every;
 
 	/* send frame and bit lock resets */
 	if(bit_lock_pend && (_1ms_epoch == 0))
@@ -249,7 +310,7 @@ void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 	else
 		_feedback->set_z_count = false;
 
-	if((P[1] > 1.0e4) && converged)
+	if((P[1] > 1.0e4) && converged && (state == CHANNEL_TRACK))
 		_feedback->navigate = navigate;
 	else
 		_feedback->navigate = false;
@@ -258,14 +319,237 @@ void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Called from the tracking thread with -loops. Dumps left over from an earlier start of the
+ * correlator (its gen does not match) or arriving after the channel killed itself are dropped.
+ * A dump is only taken when its answer is sure to fit, the correlator must see every kill.
+ */
+int32 Channel::Service()
+{
+	Corr_Dump_S d;
+	Loop_Feedback_S f;
+	int32 n;
+
+	n = 0;
+	while((feedbacks.Count() < LOOP_QUEUE) && dumps.Pop(&d))
+	{
+		Lock();
+
+		if(active && (d.gen == gen))
+		{
+			if(d.skip)
+				Skip(d.skip);
+			else
+			{
+				Accum(&d.corr, &f.nco);
+				f.gen = d.gen;
+				f.epochs = d.epochs;
+				feedbacks.Push(&f);
+			}
+		}
+
+		Unlock();
+
+		n++;
+	}
+
+	return(n);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * First half of Service() with -batch, takes at most one dump. A dump that closes the loops
+ * is integrated and its loop inputs are gathered into a slot of _bank, BatchOut() finishes it
+ * once the bank has run. Everything else (skips, coasting, the FFT pull-in, the ms in between
+ * dumps) is done here and now, as Service() would. Returns false when there was no dump.
+ */
+bool Channel::BatchIn(Loop_Bank *_bank)
+{
+	Corr_Dump_S d;
+
+	batch_slot = -1;
+
+	if((feedbacks.Count() >= LOOP_QUEUE) || !dumps.Pop(&d))
+		return(false);
+
+	Lock();
+
+	if(active && (d.gen == gen))
+	{
+		if(d.skip)
+			Skip(d.skip);
+		else
+		{
+			batch.gen = d.gen;
+			batch.epochs = d.epochs;
+
+			IncStartTic();
+
+			if(Integrate(&d.corr))
+			{
+				Export();
+
+				if(DumpStart())
+				{
+					batch_slot = _bank->Add();
+					LoadBank(_bank, batch_slot);
+				}
+				else
+				{
+					Filters();
+					DumpEnd();
+				}
+			}
+
+			if(batch_slot < 0)
+			{
+				Finish(&batch.nco);
+				feedbacks.Push(&batch);
+			}
+
+			IncStopTic();
+		}
+	}
+
+	Unlock();
+
+	return(true);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Second half, scatter the bank's results back and finish the dump as Accum() would */
+void Channel::BatchOut(Loop_Bank *_bank)
+{
+
+	if(batch_slot < 0)
+		return;
+
+	Lock();
+
+	/* The correlator restarted the channel in between */
+	if(active && (batch.gen == gen))
+	{
+		IncStartTic();
+
+		StoreBank(_bank, batch_slot);
+		DumpEnd();
+		Finish(&batch.nco);
+		feedbacks.Push(&batch);
+
+		IncStopTic();
+	}
+
+	Unlock();
+
+	batch_slot = -1;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Gather what PLL(), DLL() and Filters() read into a slot of the bank */
+void Channel::LoadBank(Loop_Bank *_bank, int32 _slot)
+{
+
+	int32 lcv;
+
+	for(lcv = 0; lcv < 3; lcv++)
+	{
+		_bank->I[lcv][_slot] = (float)I[lcv];
+		_bank->Q[lcv][_slot] = (float)Q[lcv];
+	}
+
+	_bank->I_prev[_slot] 	= (float)I_prev;
+	_bank->Q_prev[_slot] 	= (float)Q_prev;
+	_bank->len[_slot] 		= (float)len;
+	_bank->I_sum20[_slot] 	= (float)I_sum20;
+	_bank->Q_sum20[_slot] 	= (float)Q_sum20;
+
+	for(lcv = 0; lcv < 20; lcv++)
+	{
+		_bank->I_buff[lcv][_slot] = (float)I_buff[lcv];
+		_bank->Q_buff[lcv][_slot] = (float)Q_buff[lcv];
+	}
+
+	_bank->t[_slot] 		= aPLL.t;
+	_bank->w0p3[_slot] 		= aPLL.w0p3;
+	_bank->a3w0p2[_slot] 	= aPLL.a3*aPLL.w0p2;
+	_bank->b3w0p[_slot] 	= aPLL.b3*aPLL.w0p;
+
+	_bank->w[_slot] 		= aPLL.w;
+	_bank->x[_slot] 		= aPLL.x;
+	_bank->fll_lock[_slot] 	= aPLL.fll_lock;
+	_bank->I_avg[_slot] 	= I_avg;
+	_bank->Q_var[_slot] 	= Q_var;
+	_bank->P_avg[_slot] 	= P_avg;
+	_bank->NP[_slot] 		= NP;
+	_bank->CN0[_slot] 		= CN0;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Scatter a slot back, the NCOs are set as PLL() and DLL() set them */
+void Channel::StoreBank(Loop_Bank *_bank, int32 _slot)
+{
+
+	aPLL.w 			= _bank->w[_slot];
+	aPLL.x 			= _bank->x[_slot];
+	aPLL.z 			= _bank->z[_slot];
+	aPLL.pll_lock 	= _bank->pll_lock[_slot];
+	aPLL.fll_lock 	= _bank->fll_lock[_slot];
+
+	carrier_nco = IF_FREQUENCY + aPLL.z;
+	code_nco = CODE_RATE + ((carrier_nco - IF_FREQUENCY)*CODE_RATE/L1);
+	if(el)
+		code_nco += _bank->code_err[_slot];
+
+	I_avg = _bank->I_avg[_slot];
+	Q_var = _bank->Q_var[_slot];
+	P_avg = _bank->P_avg[_slot];
+
+	/* Same conditions as Filters() */
+	if((_1ms_epoch == 0) && freq_lock && (state == CHANNEL_TRACK))
+	{
+		NP = _bank->NP[_slot];
+		CN0 = _bank->CN0[_slot];
+	}
+
+	if(state == CHANNEL_TRACK)
+		CN0_old = _bank->CN0_old[_slot];
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Channel::DumpAccum()
 {
-	int32 lcv, bwrote;
-	float NBP;
-	float WBP;
-	float cerr;
-	float serr;
+
+	if(DumpStart())
+	{
+		PLL();
+		DLL();
+	}
+
+	Filters();
+	DumpEnd();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Powers, then the FFT pull-in or coasting. Returns true when PLL() and DLL() are to run */
+bool Channel::DumpStart()
+{
 
 	/* Compute the powers */
 	P[0] = I[0]*I[0]+Q[0]*Q[0];
@@ -273,23 +557,39 @@ void Channel::DumpAccum()
 	P[2] = I[2]*I[2]+Q[2]*Q[2];
 
 	/* First do estimate of frequency offset via FFT */
-	if(freq_lock == false)
+	if(state == CHANNEL_COAST)
 	{
-		FrequencyLock();
+		Coast();
+		return(false);
 	}
-	else
+	else if(freq_lock == false)
 	{
-		PLL();
-		DLL();
+		FrequencyLock();
+		return(false);
 	}
 
+	return(true);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Lock filters & CN0 estimates */
+void Channel::Filters()
+{
+
+	int32 lcv;
+	float NBP;
+	float WBP;
+
 	/* Lowpass filtered values here */
 	I_avg += (fabs((float)I[1]) - I_avg) * .02;
 	Q_var += ((float)Q[1]*(float)Q[1] - Q_var) * .02;
 	P_avg += ((float)P[1]/float(len) - P_avg) * .1;
 
-	/* Try out new CN0 estimate, PG 393 of Global Positioning System, Theory and Applications */
-	if((_1ms_epoch == 0) && freq_lock)
+	/* Try out new CN0 estimate, PG 393 of Global Positioning System, Theory and Applications, held while coasting */
+	if((_1ms_epoch == 0) && freq_lock && (state == CHANNEL_TRACK))
 	{
 		NBP = I_sum20*I_sum20 + Q_sum20*Q_sum20;
 		WBP = 0;
@@ -310,18 +610,34 @@ void Channel::DumpAccum()
 	}
 
 	/* Old school CN0 */
-	CN0_old = 10*log10(I_avg*I_avg/(2*Q_var)) - 10*log10(aPLL.t);
+	if(state == CHANNEL_TRACK)
+		CN0_old = 10*log10(I_avg*I_avg/(2*Q_var)) - 10*log10(aPLL.t);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Check the channel's health and start the next integration */
+void Channel::DumpEnd()
+{
 
 	/* Dump pertinent data */
 	Error();
 
+	if(active)
+		Reduce();
+
 	/* Save Previous Correlations for Loops */
 	I_prev = I[1];
 	Q_prev = Q[1];
 
 	/* Zero out the correlations */
+	el = 0;
 	I[0] = I[1] = I[2] = 0;
 	Q[0] = Q[1] = Q[2] = 0;
+	memset(&taps.I[0], 0x0, CORR_MAX_TAPS*sizeof(int32));
+	memset(&taps.Q[0], 0x0, CORR_MAX_TAPS*sizeof(int32));
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -400,6 +716,10 @@ void Channel::DLL()
 
 	code_err  = (ep - lp)/(ep + lp);
 
+	/* -reduce, no early & late in this dump, the code is carrier aided only */
+	if(el == 0)
+		code_err = 0;
+
 	/* Not working too well right now, debug some later */
 //	aDLL.x += aDLL.t*(code_err*aDLL.w02);
 //	aDLL.z = 0.5*aDLL.x + aDLL.a*aDLL.w02*code_err;
@@ -488,6 +808,44 @@ void Channel::Epoch()
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * The correlator lost _ms of IF (negative when a recorded file loops) and propagated its NCOs
+ * across the hole, move the epochs along with it rather than dropping lock. Partial sums that
+ * straddle the hole are thrown away, the data bits that fell in it are lost but the subframe bit
+ * count stays in step so the frame sync survives.
+ */
+void Channel::Skip(int32 _ms)
+{
+	int64 ms, week, bits;
+
+	/* Same ms of the week arithmetic as Epoch(), z count is in 6 second steps */
+	week = (int64)SECONDS_IN_WEEK*1000;
+	ms = (int64)z_count*1000 + _20ms_epoch*20 + _1ms_epoch;
+
+	bits = (ms + _ms + week)/20 - (ms + week)/20;
+	if(frame_lock)
+		bit_number = (int32)(((bit_number + bits) % 300 + 300) % 300);
+
+	ms = (((ms + _ms) % week) + week) % week;
+	z_count = (int32)((ms/6000)*6);
+	_20ms_epoch = (int32)((ms % 6000)/20);
+	_1ms_epoch = (int32)(ms % 20);
+
+	/* Start the integrations over */
+	el = 0;
+	I[0] = I[1] = I[2] = 0;
+	Q[0] = Q[1] = Q[2] = 0;
+	memset(taps.I, 0x0, sizeof(taps.I));
+	memset(taps.Q, 0x0, sizeof(taps.Q));
+	memset(I_buff, 0x0, sizeof(I_buff));
+	memset(Q_buff, 0x0, sizeof(Q_buff));
+	I_sum20 = Q_sum20 = 0;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Channel::BitLock()
 {
@@ -895,9 +1253,16 @@ void Channel::Error()
 
 	mcn0 = CN0 > CN0_old ? CN0 : CN0_old;
 
+	/* Coasting, Coast() decides */
+	if(state == CHANNEL_COAST)
+		return;
+
 	/* Monitor DLL */
 	if((P_avg < 2e4) && (count > 2000))
-		Kill();
+	{
+		Lost();
+		return;
+	}
 
 	/* Monitor CN0 for false PLL lock */
 	if(count > 10000 && mcn0 < 17.0)
@@ -940,12 +1305,166 @@ void Channel::Error()
 /*----------------------------------------------------------------------------------------------*/
 void Channel::Kill()
 {
+	Chan_2_SV_Select_S event;
+
+	/* Tell SV_Select the channel is free, it does not have to wait for its next look */
+	if(active)
+	{
+		event.chan = chan;
+		event.sv = sv;
+		event.locked = bit_lock;
+		event.doppler = carrier_nco - IF_FREQUENCY;
+		write(Chan_2_SV_Select_P[WRITE], &event, sizeof(Chan_2_SV_Select_S));
+	}
+
 	active = false;
 	Clear();
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * The signal went away. A channel that was really tracking (the CN0 estimate lags, so it still
+ * says how good the signal was) keeps its correlator running on the last loop estimates for
+ * gopt.coast_ms, and closes the loops again from there if the signal comes back, without going
+ * through the acquisition. Anything else is killed as before.
+ */
+void Channel::Lost()
+{
+
+	if((gopt.coast_ms <= 0) || (freq_lock == false) || (CN0 < COAST_CN0))
+	{
+		Kill();
+		return;
+	}
+
+	/* The integration length stays, P_avg is normalized to it */
+	state = CHANNEL_COAST;
+	coast_ms = 0;
+	coast_carrier = carrier_nco;
+	coast_predict = PredictDoppler(&coast_doppler);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * -reduce. A channel that has held bit & frame lock above REDUCE_CN0 for REDUCE_HOLD ms has the
+ * correlator skip early & late on all but every gopt.reduce_el'th ms, the DLL runs on those only.
+ * Losing either lock, the CN0 falling under REDUCE_CN0_EXIT or a big PLL error puts it straight
+ * back to full rate.
+ */
+void Channel::Reduce()
+{
+
+	bool locked;
+
+	if(gopt.reduce_el <= 1)
+		return;
+
+	locked = bit_lock && frame_lock && freq_lock && (state == CHANNEL_TRACK) && (fabs(aPLL.pll_lock) < REDUCE_PLL_ERR);
+
+	if(el_every > 1)
+	{
+		if(!locked || (CN0 < REDUCE_CN0_EXIT))
+		{
+			el_every = 1;
+			reduce_ms = 0;
+		}
+	}
+	else
+	{
+		if(locked && (CN0 > REDUCE_CN0))
+			reduce_ms += len;
+		else
+			reduce_ms = 0;
+
+		if(reduce_ms >= REDUCE_HOLD)
+			el_every = gopt.reduce_el;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Called from DumpAccum() in place of the loops */
+void Channel::Coast()
+{
+
+	float doppler;
+
+	/* Carrier follows the PVT prediction if there is one, the code is carrier aided */
+	carrier_nco = coast_carrier;
+	if(coast_predict && PredictDoppler(&doppler))
+		carrier_nco += doppler - coast_doppler;
+	code_nco = CODE_RATE + ((carrier_nco - IF_FREQUENCY)*CODE_RATE/L1);
+
+	coast_ms += len;
+
+	if(P_avg > COAST_RELOCK_POWER)
+		Relock();
+	else if((coast_ms > gopt.coast_ms) || (fabs(carrier_nco-IF_FREQUENCY) > CARRIER_BINS*CARRIER_SPACING))
+		Kill();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Same as Start(), but from the coasted NCOs, bit & frame sync and the z count are kept */
+void Channel::Relock()
+{
+
+	float doppler;
+
+	doppler = carrier_nco - IF_FREQUENCY;
+
+	memset(&aPLL, 0x0, sizeof(Phase_lock_loop));
+	memset(&aDLL, 0x0, sizeof(Delay_lock_loop));
+
+	aDLL.x		= 2.0*doppler*CODE_RATE/L1;
+	aPLL.x		= 2.0*doppler;
+	aPLL.z		= doppler;
+
+	PLL_W(len == 1 ? 30.0 : (len == 10 ? 25.0 : 20.0));
+	DLL_W(1.0);
+
+	/* Pull the frequency back in with the FFT */
+	freq_lock = false;
+	freq_lock_ticks = 0;
+
+	state = CHANNEL_TRACK;
+	coast_ms = 0;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Only trusted with a recent PVT (hot start), the change in it is used, not its absolute value */
+bool Channel::PredictDoppler(float *_doppler)
+{
+
+	SV_Prediction_M pred;
+
+	if((pSV_Select == NULL) || (pSV_Select->getMode() != HOT_START))
+		return(false);
+
+	pred = pSV_Select->getSVPrediction(sv);
+	if(pred.visible == false)
+		return(false);
+
+	*_doppler = pred.doppler;
+
+	return(true);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Channel::Export()
 {
@@ -970,9 +1489,18 @@ void Channel::Export()
 	packet.best_epoch 	= (float)best_epoch;
 	packet.code_nco 	= (float)code_nco;
 	packet.carrier_nco 	= (float)carrier_nco;
+	packet.el_every		= (float)el_every;
 
 	if(gopt.log_channel && (fp != NULL))
 		fwrite(&packet, sizeof(Channel_M), 1,  fp);
+
+	if(gopt.log_channel && (tfp != NULL) && taps.taps)
+	{
+		taps.chan = chan;
+		taps.sv = sv;
+		taps.count = count;
+		fwrite(&taps, sizeof(Channel_Taps_S), 1, tfp);
+	}
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -40,6 +40,7 @@ class Channel : public Threaded_Object
 		/* Status info */
 		/*----------------------------------------------------------------------------------------------*/
 		FILE *fp;
+		FILE *tfp;				//!< Multipath taps log
 		int32 len;				//!< accumulation length
 		int32 count;			//!< number of accumulations processed
 		int32 active;			//!< is this channel active
@@ -67,6 +68,7 @@ class Channel : public Threaded_Object
 		int32 I[3];				//!< Inphase correlations
 		int32 Q[3];				//!< Quadrature correlations
 		int32 P[3];				//!< Power
+		Channel_Taps_S taps;	//!< Multipath taps, integrated like I & Q
 		int32 I_prev;			//!< Previous I prompt correlation
 		int32 Q_prev;			//!< Previous Q prompt correlation
 		float I_avg;			//!< Moving average of I
@@ -112,6 +114,21 @@ class Channel : public Threaded_Object
 		int32 subframe;			//!< The current subframe
 		/*----------------------------------------------------------------------------------------------*/
 
+		/* Coasting through a loss of signal */
+		/*----------------------------------------------------------------------------------------------*/
+		int32 coast_ms;				//!< ms spent coasting
+		double coast_carrier;		//!< carrier_nco when the signal was lost
+		float coast_doppler;		//!< PVT predicted Doppler when the signal was lost
+		bool coast_predict;			//!< Follow the change in the PVT predicted Doppler while coasting
+		/*----------------------------------------------------------------------------------------------*/
+
+		/* Reduced rate tracking (-reduce) */
+		/*----------------------------------------------------------------------------------------------*/
+		int32 el;					//!< ms of the current integration that have early & late
+		int32 el_every;				//!< Ask the correlator for early & late every this many ms
+		int32 reduce_ms;			//!< ms the channel has qualified for the reduced rate
+		/*----------------------------------------------------------------------------------------------*/
+
 		/* FFT and buffer for FFT estimate of frequency after initial lock
 		/*----------------------------------------------------------------------------------------------*/
 		bool freq_lock;				//!< Has the FFT estimate of frequency been completed?
@@ -120,6 +137,15 @@ class Channel : public Threaded_Object
 		FFT *pFFT;					//!< This is where the actual FFT lives
 		/*----------------------------------------------------------------------------------------------*/
 
+		/* With -loops the correlator and the tracking thread only talk through these */
+		/*----------------------------------------------------------------------------------------------*/
+		SPSC_Queue<Corr_Dump_S, LOOP_QUEUE> dumps;			//!< Correlator to tracking thread
+		SPSC_Queue<Loop_Feedback_S, LOOP_QUEUE> feedbacks;	//!< Tracking thread to correlator
+		uint32 gen;					//!< Start of the correlator this channel is following
+		Loop_Feedback_S batch;		//!< With -batch, the answer to the dump waiting on the bank
+		int32 batch_slot;			//!< Its slot in the bank, -1 for none
+		/*----------------------------------------------------------------------------------------------*/
+
 	public:
 
 		Channel(int32 _chan);
@@ -128,12 +154,16 @@ class Channel : public Threaded_Object
 		void Clear();
 		void Kill();									//!< Shutdown the channel
 		void DumpAccum();								//!< Dump the accumulation and do rest of processing
+		bool DumpStart();								//!< Powers, coasting & FFT pull-in, true when the loops are to run
+		void Filters();									//!< Lock filters & CN0 estimates
+		void DumpEnd();									//!< Error(), then start the next integration
 		void FrequencyLock();							//!< Use FFT to pull in the PLL
 		void PLL_W(float _bw);							//!< Change the PLL bandwidth
 		void DLL_W(float _bw);							//!< Change the DLL bandwidth
 		void PLL();										//!< Perform the phase lock loop
 		void DLL();										//!< Do the DLL
 		void Epoch();									//!< Increase _1ms_epoch, _20ms_epoch
+		void Skip(int32 _ms);							//!< Step the epochs over _ms the correlator never saw
 		void BitLock();									//!< Declare the bit lock?
 		void BitStuff();								//!< Get data bits from I_Sum20 and stuff them into data_buff
 		void ProcessDataBit();							//!< Process the data bits, how fun!, calls the following 3 functions
@@ -141,14 +171,29 @@ class Channel : public Threaded_Object
 			bool ParityCheck(uint32 gpsword);			//!< parity check
 			bool ValidFrameFormat(uint32 *subframe);	//!< valid frame
 		void Error();									//!< look for errors in tracking, killing channel if necessary
+		void Lost();									//!< Loss of signal, coast or kill the channel
+		void Coast();									//!< Hold the NCOs and wait for the signal to come back
+		void Reduce();									//!< Drop to prompt only or back to full rate (-reduce)
+		void Relock();									//!< The signal is back, close the loops from the coasted state
+		bool PredictDoppler(float *_doppler);			//!< PVT predicted Doppler of this SV, if there is one
 		void Export();									//!< Return NCO command to correlator
 		Channel_M getPacket();
 		void Accum(Correlation_S *corr, NCO_Command_S *_feedback);	//!< Process an accumulation
+		bool Integrate(Correlation_S *corr);			//!< Add in a 1 ms correlation, true when a dump is due
+		void Finish(NCO_Command_S *_feedback);			//!< Every ms bit & frame sync, fill in the feedback
+		void LoadBank(Loop_Bank *_bank, int32 _slot);	//!< Gather the loop inputs into a slot of the bank
+		void StoreBank(Loop_Bank *_bank, int32 _slot);	//!< Scatter the bank's results back
 		float getCN0(){return(CN0);};
 		float getNCO(){return(carrier_nco);};
 		int32 getActive(){return(active);};
 		void setActive(int32 _active){active = _active;};
 		int32 getSV(){return(sv);};
+		bool PostDump(Corr_Dump_S *_dump){return(dumps.Push(_dump));};				//!< Correlator side, queue a dump
+		bool GetFeedback(Loop_Feedback_S *_f){return(feedbacks.Pop(_f));};		//!< Correlator side, collect an answer
+		void setGen(uint32 _gen){gen = _gen;};										//!< Correlator side, under Lock() with Start()
+		int32 Service();								//!< Tracking thread side, run Accum() on every queued dump
+		bool BatchIn(Loop_Bank *_bank);					//!< Tracking thread side with -batch, take one dump into the bank
+		void BatchOut(Loop_Bank *_bank);				//!< And finish it once the bank has run
 };
 
 #endif /* Channel_H */
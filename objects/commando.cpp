@@ -59,8 +59,6 @@ Commando::Commando()
 {
 
 	execution_tic = 0;	//!< Execution counter
-	start_tic = 0;		//!< OS tic at start of function
-	stop_tic = 0;		//!< OS tic at end of function
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -160,6 +158,9 @@ void Commando::Import()
 		case GET_CHANNEL_C_ID:
 			getChannel();
 			break;
+		case SET_CORR_TAPS_C_ID:
+			setCorr_Taps();
+			break;
 		default:
 			break;
 	}
@@ -481,6 +482,27 @@ void Commando::setAcq_Config()
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void Commando::setCorr_Taps()
+{
+
+	int32 chan;
+	Set_Corr_Taps_C *c = &command_body.set_corr_taps;
+
+	if((c->chan >= 0) && (c->chan < MAX_CHANNELS))
+	{
+		pCorrelators[c->chan]->SetTaps(c->delays, c->spacing);
+	}
+	else
+	{
+		for(chan = 0; chan < MAX_CHANNELS; chan++)
+			pCorrelators[chan]->SetTaps(c->delays, c->spacing);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Commando::setPVT()
 {
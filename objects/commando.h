@@ -66,6 +66,7 @@ class Commando : public Threaded_Object
 		void setEphemeris();
 		void setAlmanac();
 		void setAcq_Config();
+		void setCorr_Taps();
 
 		void getMeasurement();
 		void getPseudorange();
@@ -0,0 +1,456 @@
+/*! \file corr-replay.cpp
+	Rerun the channels, ephemeris and PVT on a correlation recording (-record), no IF needed
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#define GLOBALS_HERE
+
+#include "includes.h"
+#include <sys/ioctl.h>
+
+/*! \ingroup STRUCTS
+ * Options for the replay
+ */
+typedef struct _Corr_Replay_Options
+{
+	int32 verbose;			//!< Print the nav solution every second
+	int32 log_channel;		//!< Channels log to chanNN.dat as in the receiver
+	int32 coast_ms;			//!< Channels coast this long after losing the signal
+	int32 recorded_nav;		//!< Navigate on the recorded flags only, ignore what the replayed channels decide
+	int32 batch;			//!< Run the loops through a Loop_Bank, as -batch does
+	double seconds;			//!< Stop after this much, 0 for the whole recording
+} Corr_Replay_Options;
+
+/*! \ingroup STRUCTS
+ * Replay state of one channel
+ */
+typedef struct _Replay_Chan
+{
+	FILE *fp;				//!< The correlator's REC_FILE
+	int32 starts;			//!< REC_START records
+	int32 dumps;			//!< REC_DUMP records run through Channel::Accum()
+	int32 skips;			//!< REC_SKIP records
+	int32 kills;			//!< Times the replayed channel killed itself
+	int32 navigate;			//!< Last navigate flag the replayed channel fed back
+	int32 nav[TICS_PER_SECOND];	//!< navigate at each tic, combined like Correlator::TakeMeasurement()
+	int32 have_nco;			//!< carrier_nco below belongs to the previous dump
+	double carrier_nco;		//!< Carrier NCO the replayed channel fed back at the previous dump
+	double nco_err;			//!< Sum of (recorded - replayed carrier NCO)^2
+	int32 nco_n;			//!< Number of terms in the above
+} Replay_Chan;
+
+Replay_Chan chans[MAX_CHANNELS];
+Loop_Bank *pBank = NULL;
+
+/*----------------------------------------------------------------------------------------------*/
+void replay_usage(char *_str)
+{
+
+    fprintf(stderr, "usage: [-v] [-c] [-t] [-coast] [-r] [-b]\n");
+    fprintf(stderr, "Replays corr00.rec..corr%02d.rec from the current directory, written by gps-sdr -record\n", MAX_CHANNELS-1);
+    fprintf(stderr, "[-v] print the nav solution every second\n");
+    fprintf(stderr, "[-c] log high rate channel data, as gps-sdr -c\n");
+    fprintf(stderr, "[-t] <seconds> stop after this much of the recording\n");
+    fprintf(stderr, "[-coast] <ms> channels coast this long after losing the signal, 0 kills them (default %d)\n", COAST_MS);
+    fprintf(stderr, "[-r] navigate on the recorded navigate flags only\n");
+    fprintf(stderr, "[-b] run the loops through the vectorized loop bank, as gps-sdr -batch\n");
+    fflush(stderr);
+
+    exit(1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Feed whatever the channels wrote to the ephemeris pipe through the Ephemeris object */
+void replay_ephemeris(void)
+{
+	int32 nbytes;
+
+	while(1)
+	{
+		nbytes = 0;
+		ioctl(Chan_2_Ephem_P[READ], FIONREAD, &nbytes);
+		if(nbytes < (int32)sizeof(Chan_2_Ephem_S))
+			break;
+
+		pEphemeris->Import();
+		pEphemeris->Export();
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Channel::Accum() with the PLL/DLL run through a one slot Loop_Bank, as Channel::BatchIn() & BatchOut() do */
+void replay_accum(Channel *_chan, Correlation_S *_corr, NCO_Command_S *_feedback)
+{
+	if(pBank == NULL)
+	{
+		_chan->Accum(_corr, _feedback);
+		return;
+	}
+
+	if(_chan->Integrate(_corr))
+	{
+		_chan->Export();
+
+		if(_chan->DumpStart())
+		{
+			pBank->Clear();
+			_chan->LoadBank(pBank, pBank->Add());
+			pBank->Run();
+			_chan->StoreBank(pBank, 0);
+		}
+		else
+			_chan->Filters();
+
+		_chan->DumpEnd();
+	}
+
+	_chan->Finish(_feedback);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Start the channel exactly as Correlator::Import() did */
+void replay_start(int32 _chan, Acq_Command_M *_result)
+{
+	switch(_result->type)
+	{
+		case ACQ_STRONG:
+			pChannels[_chan]->Start(_result->sv, *_result, 1);
+			break;
+		case ACQ_MEDIUM:
+			pChannels[_chan]->Start(_result->sv, *_result, 10);
+			break;
+		case ACQ_WEAK:
+			pChannels[_chan]->Start(_result->sv, *_result, 10);
+			break;
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Run one channel's records up to and including its next measurement. Open loop: the recorded
+ * correlations were made with the recorded channel's NCOs, the replayed channel's feedback is
+ * only compared against them. Returns false at the end of the recording.
+ */
+int32 replay_channel(int32 _chan, Measurement_M *_meas, int32 *_tic, Corr_Replay_Options *_opt)
+{
+	Replay_Chan *r;
+	Channel *aChannel;
+	Corr_Record_S rec;
+	Acq_Command_M result;
+	Correlation_S corr;
+	NCO_Command_S feedback;
+	double err;
+	int32 tic;
+
+	r = &chans[_chan];
+	aChannel = pChannels[_chan];
+
+	while(fread(&rec, sizeof(Corr_Record_S), 1, r->fp) == 1)
+	{
+		switch(rec.type)
+		{
+			case REC_START:
+
+				if(fread(&result, sizeof(Acq_Command_M), 1, r->fp) != 1)
+					return(false);
+
+				replay_start(_chan, &result);
+				r->starts++;
+				r->have_nco = false;
+				r->navigate = false;
+				break;
+
+			case REC_DUMP:
+
+				if((rec.value < 0) || (rec.value > CORR_MAX_TAPS))
+				{
+					printf("Channel %d: bad record\n", _chan);
+					return(false);
+				}
+
+				memset(&corr, 0x0, sizeof(Correlation_S));
+				corr.taps = rec.value;
+				if(fread(&corr.I[0], sizeof(int32), 3, r->fp) != 3)
+					return(false);
+				if(fread(&corr.Q[0], sizeof(int32), 3, r->fp) != 3)
+					return(false);
+				if(fread(&corr.el, sizeof(int32), 1, r->fp) != 1)
+					return(false);
+				if(corr.taps)
+				{
+					if(fread(&corr.tap_I[0], sizeof(int32), corr.taps, r->fp) != (size_t)corr.taps)
+						return(false);
+					if(fread(&corr.tap_Q[0], sizeof(int32), corr.taps, r->fp) != (size_t)corr.taps)
+						return(false);
+					if(fread(&corr.spacing, sizeof(float), 1, r->fp) != 1)
+						return(false);
+				}
+
+				/* Killed in the replay but not in the recording, wait for the next start */
+				if(aChannel->getActive() == false)
+					break;
+
+				/* The recorded NCOs are the recorded channel's answer to the previous dump */
+				if(r->have_nco)
+				{
+					err = rec.carrier_nco - r->carrier_nco;
+					r->nco_err += err*err;
+					r->nco_n++;
+				}
+
+				memset(&feedback, 0x0, sizeof(NCO_Command_S));
+				replay_accum(aChannel, &corr, &feedback);
+				r->dumps++;
+
+				r->carrier_nco = feedback.carrier_nco;
+				r->have_nco = true;
+				r->navigate = feedback.navigate;
+
+				if(feedback.kill)
+				{
+					r->kills++;
+					r->have_nco = false;
+					r->navigate = false;
+				}
+
+				/* Frames go to the ephemeris as soon as they are decoded */
+				replay_ephemeris();
+				break;
+
+			case REC_SKIP:
+
+				if(aChannel->getActive())
+					aChannel->Skip(rec.value);
+				r->skips++;
+				r->have_nco = false;
+				break;
+
+			case REC_MEAS:
+
+				if(fread(_meas, sizeof(Measurement_M), 1, r->fp) != 1)
+					return(false);
+
+				/* Same three tic rule as the correlator, on the replayed channel's flag */
+				tic = rec.value;
+				r->nav[tic % TICS_PER_SECOND] = r->navigate;
+				if(_opt->recorded_nav == false)
+				{
+					_meas->navigate = _meas->navigate &&
+						r->nav[(tic - 2*ICP_TICS + TICS_PER_SECOND) % TICS_PER_SECOND] &&
+						r->nav[(tic - ICP_TICS + TICS_PER_SECOND) % TICS_PER_SECOND] &&
+						r->nav[tic % TICS_PER_SECOND];
+				}
+
+				*_tic = tic;
+				return(true);
+
+			default:
+
+				printf("Channel %d: bad record\n", _chan);
+				return(false);
+		}
+	}
+
+	return(false);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! One measurement tic through the PVT, as if the FIFO and correlators had just sent it */
+void replay_pvt(int32 _tic, Measurement_M *_meas)
+{
+	FIFO_M telem;
+	int32 lcv;
+
+	memset(&telem, 0x0, sizeof(FIFO_M));
+	telem.tic = _tic;
+
+	write(FIFO_2_PVT_P[WRITE], &telem, sizeof(FIFO_M));
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		write(Corr_2_PVT_P[lcv][WRITE], &_meas[lcv], sizeof(Measurement_M));
+
+	pPVT->Import();
+	pPVT->Lock();
+	pPVT->Navigate();
+	pPVT->Export();
+	pPVT->Unlock();
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int main(int32 argc, char* argv[])
+{
+	Corr_Replay_Options opt;
+	Measurement_M meas[MAX_CHANNELS];
+	SPS_M nav;
+	char fname[1024];
+	int32 lcv, tic, tics, fixes, mismatch, running;
+	int32 tics_chan[MAX_CHANNELS];
+	uint64 start, elapsed;
+	double seconds;
+
+	opt.verbose = false;
+	opt.log_channel = false;
+	opt.coast_ms = COAST_MS;
+	opt.recorded_nav = false;
+	opt.batch = false;
+	opt.seconds = 0;
+
+	for(lcv = 1; lcv < argc; lcv++)
+	{
+		if(!strcmp(argv[lcv], "-v"))
+			opt.verbose = true;
+		else if(!strcmp(argv[lcv], "-c"))
+			opt.log_channel = true;
+		else if(!strcmp(argv[lcv], "-r"))
+			opt.recorded_nav = true;
+		else if(!strcmp(argv[lcv], "-b"))
+			opt.batch = true;
+		else if(!strcmp(argv[lcv], "-t") && (lcv+1 < argc))
+			opt.seconds = atof(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-coast") && (lcv+1 < argc))
+			opt.coast_ms = atoi(argv[++lcv]);
+		else
+			replay_usage(argv[0]);
+	}
+
+	if((opt.seconds < 0) || (opt.coast_ms < 0))
+		replay_usage(argv[0]);
+
+	/* Receiver options, the channels & PVT are the only ones that matter */
+	memset(&gopt, 0x0, sizeof(Options_S));
+	gopt.log_channel = opt.log_channel;
+	gopt.coast_ms = opt.coast_ms;
+	gopt.block_ms = 1;
+	gopt.pin_cpu = -1;
+	grun = 0x1;
+
+	memset(chans, 0x0, sizeof(chans));
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		sprintf(fname, REC_FILE, lcv);
+		chans[lcv].fp = fopen(fname, "rb");
+		if(chans[lcv].fp == NULL)
+		{
+			printf("Could not open %s for reading\n", fname);
+			return(-1);
+		}
+	}
+
+	Init_SIMD();
+
+	/* Nobody reads the outputs, do not let them block */
+	Pipes_Init();
+	fcntl(PVT_2_Telem_P[WRITE], F_SETFL, O_NONBLOCK);
+	fcntl(PVT_2_SV_Select_P[WRITE], F_SETFL, O_NONBLOCK);
+	fcntl(Ephem_2_Telem_P[WRITE], F_SETFL, O_NONBLOCK);
+
+	/* The real objects, driven from this thread */
+	pEphemeris = new Ephemeris;
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		pChannels[lcv] = new Channel(lcv);
+	pPVT = new PVT(COLD_START);
+	if(opt.batch)
+		pBank = new Loop_Bank;
+
+	tics = fixes = mismatch = 0;
+	memset(tics_chan, 0x0, sizeof(tics_chan));
+	running = true;
+
+	start = monotonic_ns();
+
+	while(running)
+	{
+		/* Every correlator writes a measurement at every tic, active or not */
+		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		{
+			if(replay_channel(lcv, &meas[lcv], &tics_chan[lcv], &opt) == false)
+				running = false;
+		}
+
+		if(running == false)
+			break;
+
+		tic = tics_chan[0];
+		for(lcv = 1; lcv < MAX_CHANNELS; lcv++)
+			if(tics_chan[lcv] != tic)
+				mismatch++;
+
+		replay_pvt(tic, meas);
+		tics++;
+
+		nav = pPVT->getNav();
+		if(nav.converged)
+			fixes++;
+
+		if(opt.verbose && ((tics % TICS_PER_SECOND) == 0))
+			printf("tic %8d\tchans %2d\tconverged %d\tlat %12.7f\tlon %12.7f\talt %10.2f\n",
+				tic, nav.nav_channels, nav.converged, nav.latitude*RAD_2_DEG, nav.longitude*RAD_2_DEG, nav.altitude);
+
+		if(opt.seconds && ((double)tics >= opt.seconds*TICS_PER_SECOND))
+			break;
+	}
+
+	elapsed = monotonic_ns() - start;
+
+	seconds = (double)tics/(double)TICS_PER_SECOND;
+	printf("Replayed %.1f s in %.3f s, %.0fx realtime\n", seconds, (double)elapsed*1e-9, seconds*1e9/(double)(elapsed ? elapsed : 1));
+	printf("%d tics, %d converged", tics, fixes);
+	if(mismatch)
+		printf(", %d channel tics out of step", mismatch);
+	printf("\n\n");
+
+	printf("%5s %7s %10s %7s %7s %14s\n", "chan", "starts", "dumps", "skips", "kills", "NCO rms (Hz)");
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		printf("%5d %7d %10d %7d %7d %14.3f\n", lcv, chans[lcv].starts, chans[lcv].dumps, chans[lcv].skips, chans[lcv].kills,
+			chans[lcv].nco_n ? sqrt(chans[lcv].nco_err/(double)chans[lcv].nco_n) : 0.0);
+
+	nav = pPVT->getNav();
+	if(nav.converged)
+		printf("\nLast fix:\tlat %.7f\tlon %.7f\talt %.2f\n", nav.latitude*RAD_2_DEG, nav.longitude*RAD_2_DEG, nav.altitude);
+
+	grun = 0x0;
+
+	delete pPVT;
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		delete pChannels[lcv];
+		fclose(chans[lcv].fp);
+	}
+	delete pEphemeris;
+	if(pBank != NULL)
+		delete pBank;
+
+	Pipes_Shutdown();
+
+	return(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
@@ -27,6 +27,8 @@ CPX *Correlator::sine_table = new CPX[(2*CARRIER_BINS+1)*2*SAMPS_MS];
 CPX **Correlator::sine_rows = new CPX*[2*CARRIER_BINS+1];
 MIX *Correlator::main_code_table = new MIX[NUM_CODES*(2*CODE_BINS+1)*2*SAMPS_MS];
 MIX **Correlator::main_code_rows = new MIX*[NUM_CODES*(2*CODE_BINS+1)];
+uint32 *Correlator::sine_bits = NULL;
+uint32 *Correlator::main_code_bits = NULL;
 
 /*----------------------------------------------------------------------------------------------*/
 void *Correlator_Thread(void *_arg)
@@ -53,15 +55,24 @@ void *Correlator_Thread(void *_arg)
 void Correlator::Start()
 {
 
-	/* With new priority specified */
-	//if((chan % CORR_PER_CPU) == 0)
+	/* Move the tables to the node we are pinned to, chan 0 owns the shared ones */
+	if(node >= 0)
 	{
-		Start_Thread(Correlator_Thread, &chan);
+		numa_place(code_table, sizeof(MIX)*(2*CODE_BINS+1)*2*SAMPS_MS, node);
 
-		if(gopt.verbose)
-			printf("Started correlator %d\n",chan);
+		if(chan == 0)
+		{
+			numa_place(sine_table, sizeof(CPX)*(2*CARRIER_BINS+1)*2*SAMPS_MS, node);
+			numa_place(main_code_table, sizeof(MIX)*NUM_CODES*(2*CODE_BINS+1)*2*SAMPS_MS, node);
+		}
 	}
 
+	/* With priority/affinity given by Set_Scheduling() */
+	Start_Thread(Correlator_Thread, &chan);
+
+	if(gopt.verbose)
+		printf("Started correlator %d (cpu %d, node %d, priority %d)\n", chan, cpu, node, sched_priority);
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -85,18 +96,51 @@ Correlator::Correlator(int32 _chan)
 {
 
 	int32 lcv;
+	char fname[1024];
 
 	chan = _chan;
 	packet_count = 0;
 	state.active = 0;
 	aChannel = pChannels[chan];
 
+	memset(&corr, 0x0, sizeof(Correlation_S));
+	taps_pend = false;
+
+	next_sample = 0;
+	dump_epochs = 0;
+	resync = false;
+
+	gen = 0;
+	loop_lost = 0;
+	loop_full = 0;
+	loop_late = 0;
+
+	rfp = NULL;
+	if(gopt.corr_record)
+	{
+		sprintf(fname, REC_FILE, chan);
+		rfp = fopen(fname, "wb");
+		if(rfp == NULL)
+			printf("Could not open %s for writing\n", fname);
+	}
+
+	/* Our copy of the FIFO's packets */
+	memset(&packet, 0x0, sizeof(ms_packet));
+	packet.data = new CPX[gopt.block_ms*SAMPS_MS];
+	if(gopt.if_bits)
+		packet.bits = new uint32[4*IF_BITS_WORDS];
+	ApplyTaps(gopt.corr_delays, gopt.corr_spacing);
+
 	/* Malloc memory for local code vector */
 	code_table = new MIX[(2*CODE_BINS+1)*2*SAMPS_MS];
 	code_rows = new MIX*[2*CODE_BINS+1];
 	for(lcv = 0; lcv < 2*CODE_BINS+1; lcv++)
 		code_rows[lcv] = &code_table[lcv*2*SAMPS_MS];
 
+	code_bits = NULL;
+	if(gopt.if_bits)
+		code_bits = new uint32[(2*CODE_BINS+1)*ROW_BITS_WORDS];
+
 	if(chan == 0)
 	{
 		/* Get the pointers */
@@ -111,6 +155,9 @@ Correlator::Correlator(int32 _chan)
 			main_code_rows[lcv] = &main_code_table[lcv*2*SAMPS_MS];
 
 		SamplePRN();
+
+		if(gopt.if_bits)
+			PackRows();
 	}
 
 	if(gopt.verbose)
@@ -126,6 +173,16 @@ Correlator::~Correlator()
 
 	delete [] code_table;
 	delete [] code_rows;
+	delete [] packet.data;
+
+	if(rfp != NULL)
+		fclose(rfp);
+
+	if(packet.bits != NULL)
+		delete [] packet.bits;
+
+	if(code_bits != NULL)
+		delete [] code_bits;
 
 	if(chan == 0)
 	{
@@ -133,6 +190,11 @@ Correlator::~Correlator()
 		delete [] sine_rows;
 		delete [] main_code_table;
 		delete [] main_code_rows;
+
+		if(sine_bits != NULL)
+			delete [] sine_bits;
+		if(main_code_bits != NULL)
+			delete [] main_code_bits;
 	}
 
 	if(gopt.verbose)
@@ -173,7 +235,16 @@ void Correlator::Import()
 					break;
 			}
 
+			/* From here on the tracking thread drops anything left from the last start */
+			aChannel->setGen(gen);
+
 			aChannel->Unlock();
+
+			if(rfp != NULL)
+			{
+				Record(REC_START, 0);
+				fwrite(&result, sizeof(Acq_Command_M), 1, rfp);
+			}
 		}
 	}
 
@@ -188,6 +259,8 @@ void Correlator::Import()
 		pFIFO->Dequeue(chan, &packet);
 	}
 
+	IncLag(packet.stamp);
+
 	packet_count++;
 
 }
@@ -198,84 +271,78 @@ void Correlator::Import()
 void Correlator::Correlate()
 {
 	Correlation_S *c;
-	CPX *if_data;
-	int32 leftover;
+	int32 samps, pos, leftover, meas, jump, stop, n;
 
 	IncStartTic();
 
-	if(packet.measurement)
-		TakeMeasurement();
+	/* Packets were dropped between this one and the last */
+	if(state.active && (packet.sample != next_sample))
+		Skip(packet.sample - next_sample);
 
-	if(state.active)
-	{
-		if_data = &packet.data[0];
-		c = &corr;
-		leftover = SAMPS_MS;
+	/* Sample in the block the measurement falls on, -1 if there is none */
+	meas = packet.measurement ? packet.measurement_ms*SAMPS_MS : -1;
 
-		/* If the rollover occurs in this packet */
-		if(state.rollover <= SAMPS_MS)
-		{
-			/* Do the actual accumulation */
-			Accum(c, if_data, state.rollover);
+	/* Sample in the block the source jumps at, -1 if it does not */
+	jump = packet.skip ? packet.skip_ms*SAMPS_MS : -1;
 
-			/* Remaining number of samples to be processed in this ms packet of data */
-			leftover = SAMPS_MS - state.rollover;
-			if_data += state.rollover;
+	c = &corr;
+	samps = packet.ms*SAMPS_MS;
+	pos = 0;
 
-			/* Update the code/carrier phase etc */
-			UpdateState(state.rollover);
+	/* Walk the block, stopping at every code rollover to dump, at the jump and at the measurement */
+	while(state.active && (pos < samps))
+	{
+		if(pos == jump)
+			Skip(packet.skip);
 
-			/* Dump the accumulation */
-			DumpAccum(c);
+		if(pos == meas)
+			TakeMeasurement();
 
-			if(state.active == 0)
-				return;
+		/* Samples up to the next event or the end of the block */
+		stop = samps;
+		if((meas > pos) && (meas < stop))
+			stop = meas;
+		if((jump > pos) && (jump < stop))
+			stop = jump;
+		leftover = stop - pos;
 
-			/* Now process remaining segment of IF data  */
-			if(state.rollover <= leftover) /* Rollover occurs in THIS packet of data */
-			{
-				/* Do the actual accumulation */
-				Accum(c, if_data, state.rollover);
+		if(state.rollover <= leftover) /* Rollover occurs in this segment */
+		{
+			n = state.rollover;
 
-				/* Remaining number of samples to be processed in this ms packet of data */
-				leftover -= state.rollover;
-				if_data += state.rollover;
+			/* Do the actual accumulation, nothing is accumulated on the far side of a gap until the next rollover */
+			if(!resync)
+				Accum(c, &packet.data[pos], n);
+			pos += n;
 
-				/* Update the code/carrier phase etc */
-				UpdateState(state.rollover);
+			/* Update the code/carrier phase etc */
+			UpdateState(n);
 
-				/* Dump the accumulation */
+			/* Dump the accumulation */
+			if(resync)
+				Resync();
+			else
 				DumpAccum(c);
-				if(state.active == 0)
-					return;
-
-				/* Do the actual accumulation */
-				Accum(c, if_data, leftover);
-
-				/* Update the code/carrier phase etc */
-				UpdateState(leftover);
-
-			}
-			else /* Rollover occurs in NEXT packet of data */
-			{
-				/* Do the actual accumulation */
-				Accum(c, if_data, leftover);
-
-				/* Update the code/carrier phase */
-				UpdateState(leftover);
-			}
-
 		}
 		else /* Just accumulate, no dumping */
 		{
 			/* Do the actual accumulation */
-			Accum(c, if_data, SAMPS_MS);
+			if(!resync)
+				Accum(c, &packet.data[pos], leftover);
+			pos += leftover;
 
 			/* Update the code/carrier phase */
-			UpdateState(SAMPS_MS);
+			UpdateState(leftover);
 		}
 	}
 
+	/* The channel is idle, or dropped before reaching the measurement */
+	if((meas >= 0) && (pos <= meas))
+		TakeMeasurement();
+
+	/* Where the next packet starts if nothing is lost */
+	next_sample = packet.sample + samps + packet.skip;
+
 	IncStopTic();
 
 }
@@ -288,6 +355,8 @@ void Correlator::TakeMeasurement()
 
 	int32 lcv, tic;
 	int32 n_dp, n_p, n_c;
+	double code_phase, code_phase_mod;
+	double carrier_phase, carrier_phase_mod;
 	Measurement_M *pmeas;
 
 	tic = packet.measurement;
@@ -298,23 +367,29 @@ void Correlator::TakeMeasurement()
 	/* Get carrier phase prev from 2*ICP_TICKS ago */
 	meas.carrier_phase_prev = meas_buff[(tic - 2*ICP_TICS + TICS_PER_SECOND) % TICS_PER_SECOND].carrier_phase;
 
+	/* Whole cycles/periods plus the NCO fractions */
+	code_phase_mod = (double)state.code_phase_fix*NCO_SCALE;
+	carrier_phase_mod = (double)state.carrier_phase_fix*NCO_SCALE;
+	code_phase = (double)state.code_epochs*(double)CODE_CHIPS + code_phase_mod;
+	carrier_phase = (double)state.carrier_cycles + carrier_phase_mod;
+
 	/* Get current carrier phase */
-	meas.carrier_phase = state.carrier_phase;
+	meas.carrier_phase = carrier_phase;
 
 	/* Store rest of measurement in buffer to do the delay */
 	pmeas = &meas_buff[tic % (TICS_PER_SECOND)];
 	pmeas->chan				 = chan;
-	pmeas->code_phase 		 = state.code_phase;
-	pmeas->code_phase_mod 	 = state.code_phase_mod;
-	pmeas->carrier_phase 	 = state.carrier_phase;
-	pmeas->carrier_phase_mod = state.carrier_phase_mod;
+	pmeas->code_phase 		 = code_phase;
+	pmeas->code_phase_mod 	 = code_phase_mod;
+	pmeas->carrier_phase 	 = carrier_phase;
+	pmeas->carrier_phase_mod = carrier_phase_mod;
 	pmeas->code_nco 		 = state.code_nco;
 	pmeas->carrier_nco 		 = state.carrier_nco;
 	pmeas->_1ms_epoch 		 = state._1ms_epoch;
 	pmeas->_20ms_epoch 		 = state._20ms_epoch;
 	pmeas->_z_count 		 = state._z_count;
 	pmeas->sv				 = state.sv;
-	pmeas->count			 = packet.count;
+	pmeas->count			 = packet.count + packet.measurement_ms;
 	pmeas->navigate			 = state.navigate;
 
 	n_dp = meas_buff[(tic - 2*ICP_TICS + TICS_PER_SECOND) % TICS_PER_SECOND].navigate;
@@ -327,6 +402,12 @@ void Correlator::TakeMeasurement()
 	/* Write over measurement */
 	write(Corr_2_PVT_P[chan][WRITE], &meas, sizeof(Measurement_M));
 
+	if(rfp != NULL)
+	{
+		Record(REC_MEAS, tic);
+		fwrite(&meas, sizeof(Measurement_M), 1, rfp);
+	}
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -335,41 +416,26 @@ void Correlator::TakeMeasurement()
 void Correlator::UpdateState(int32 samps)
 {
 
-
+	int32 lcv;
 
 	/* Update phase states */
-	state.code_phase 	 		+= samps*state.code_nco/SAMPLE_FREQUENCY;
-	state.carrier_phase			+= samps*state.carrier_nco/SAMPLE_FREQUENCY;
+	state.code_phase_fix		+= (int64)samps*state.code_inc;
+	state.carrier_phase_fix		+= (int64)samps*state.carrier_inc;
 
-	/* Do this to catch code epoch rollovers */
-	state.code_phase_mod		+= samps*state.code_nco/SAMPLE_FREQUENCY;
-	state.carrier_phase_mod		+= samps*state.carrier_nco/SAMPLE_FREQUENCY;
+	/* Move whole carrier cycles into the counter, keeping the fraction in [0, 1) */
+	state.carrier_cycles		+= state.carrier_phase_fix >> NCO_FRAC_BITS;
+	state.carrier_phase_fix		&= NCO_ONE - 1;
 
-	/* A double rollover MIGHT occur? */
-	if(state.code_phase_mod >= 2.0*(double)CODE_CHIPS)
+	/* If the C/A code rolls over then the 1ms and 20ms counters need incremented, a double rollover MIGHT occur */
+	while(state.code_phase_fix >= CODE_CHIPS*NCO_ONE)
 	{
-		state._1ms_epoch += 2;
-		if(state._1ms_epoch >= 20)
-		{
-			state._1ms_epoch %= 20;
-			state._20ms_epoch++;
+		state.code_phase_fix -= CODE_CHIPS*NCO_ONE;
+		state.code_epochs++;
 
-			if(state._20ms_epoch >= 300)
-			{
-				state._20ms_epoch = 0;
-				state._z_count += 6;
-
-				if(state._z_count > SECONDS_IN_WEEK)
-					state._z_count = 0;
-			}
-		}
-	} /* If the C/A code rolls over then the 1ms and 20ms counters need incremented */
-	else if(state.code_phase_mod >= (double)CODE_CHIPS)
-	{
 		state._1ms_epoch++;
 		if(state._1ms_epoch >= 20)
 		{
-			state._1ms_epoch %= 20;
+			state._1ms_epoch = 0;
 			state._20ms_epoch++;
 
 			if(state._20ms_epoch >= 300)
@@ -383,17 +449,12 @@ void Correlator::UpdateState(int32 samps)
 		}
 	}
 
-	/* Update partial phase states */
-	state.carrier_phase_mod  	 = fmod(state.carrier_phase_mod, 1.0);
-	state.code_phase_mod	  	 = fmod(state.code_phase_mod, CODE_CHIPS);
-
 	state.rollover -= samps;
 
 	/* Update pointers to presampled Doppler and PRN vectors */
 	state.psine    += samps;
-	state.pcode[0] += samps;
-	state.pcode[1] += samps;
-	state.pcode[2] += samps;
+	for(lcv = 0; lcv < (int32)state.taps + 3; lcv++)
+		state.pcode[lcv] += samps;
 	state.scount   += samps;
 
 
@@ -405,17 +466,57 @@ void Correlator::UpdateState(int32 samps)
 void Correlator::Accum(Correlation_S *c, CPX *data, int32 samps)
 {
 
-	CPX_ACCUM EPL[3];
+	CPX_ACCUM EPL[CORR_MAX_TAPS+3];
+	int32 lcv;
+
+	if(gopt.if_bits)
+	{
+		AccumBits(c, data, samps);
+		return;
+	}
 
 	//SineGen(samps);
 	//state.psine = sine_rows[chan];
 
-	/* First do the wipeoff */
-	sse_cmulsc(data, state.psine, scratch, samps, 14);
-
-	/* Now do the accumulation */
+	/* Now do the accumulation, all the taps share one pass over the samples */
 	//sse_prn_accum(scratch, state.pcode[0], state.pcode[1], state.pcode[2], samps, &EPL[0]);
-	sse_prn_accum_new(scratch, state.pcode[0], state.pcode[1], state.pcode[2], samps, &EPL[0]);
+	if(state.taps)
+	{
+		/* First do the wipeoff */
+		sse_cmulsc(data, state.psine, scratch, samps, CORR_WIPE_SHIFT);
+
+		x86_prn_accum_taps(scratch, state.pcode, state.taps + 3, samps, &EPL[0]);
+
+		for(lcv = 0; lcv < (int32)state.taps; lcv++)
+		{
+			c->tap_I[lcv] += EPL[lcv+3].i;
+			c->tap_Q[lcv] += EPL[lcv+3].q;
+		}
+	}
+#ifdef CORR_KERNEL_T
+	else if(state.el)
+	{
+		/* Wipeoff & E/P/L in one pass, specialized for the shift and block length */
+		x86_corr_t<CORR_WIPE_SHIFT, 3, CORR_KERNEL_BLOCK>(data, state.psine, state.pcode, samps, &EPL[0]);
+	}
+	else
+	{
+		/* -reduce, prompt only this code period */
+		EPL[0].i = EPL[0].q = EPL[2].i = EPL[2].q = 0;
+		x86_corr_t<CORR_WIPE_SHIFT, 1, CORR_KERNEL_BLOCK>(data, state.psine, &state.pcode[1], samps, &EPL[1]);
+	}
+#else
+	else
+	{
+		/* Wipeoff, then E/P/L with the SSE asm */
+		sse_cmulsc(data, state.psine, scratch, samps, CORR_WIPE_SHIFT);
+		sse_prn_accum_new(scratch, state.pcode[0], state.pcode[1], state.pcode[2], samps, &EPL[0]);
+
+		/* -reduce, prompt only this code period */
+		if(!state.el)
+			EPL[0].i = EPL[0].q = EPL[2].i = EPL[2].q = 0;
+	}
+#endif
 
 	c->I[0] += (int32) EPL[0].i;
 	c->I[1] += (int32) EPL[1].i;
@@ -429,12 +530,65 @@ void Correlator::Accum(Correlation_S *c, CPX *data, int32 samps)
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::AccumBits(Correlation_S *c, CPX *data, int32 samps)
+{
+
+	CPX_ACCUM EPL[CORR_MAX_TAPS+3];
+	uint32 *codes[CORR_MAX_TAPS+3];
+	int32 coff[CORR_MAX_TAPS+3];
+	uint32 *wipe;
+	int32 lcv, offset, woff, gain;
+
+	/* The bit tables are laid out like the CPX/MIX ones, so work out the row & sample from the pointers */
+	offset = state.psine - sine_table;
+	wipe = &sine_bits[(offset / (2*SAMPS_MS))*2*ROW_BITS_WORDS];
+	woff = offset % (2*SAMPS_MS);
+
+	for(lcv = 0; lcv < (int32)state.taps + 3; lcv++)
+	{
+		offset = state.pcode[lcv] - code_table;
+		codes[lcv] = &code_bits[(offset / (2*SAMPS_MS))*ROW_BITS_WORDS];
+		coff[lcv] = offset % (2*SAMPS_MS);
+	}
+
+	if(state.el)
+		x86_prn_accum_bits(&packet.bits[0], IF_BITS_WORDS, data - &packet.data[0], wipe, ROW_BITS_WORDS, woff,
+							codes, coff, state.taps + 3, samps, gopt.if_bits == 2, &EPL[0]);
+	else
+	{
+		/* -reduce, prompt only this code period (there are never taps then) */
+		EPL[0].i = EPL[0].q = EPL[2].i = EPL[2].q = 0;
+		x86_prn_accum_bits(&packet.bits[0], IF_BITS_WORDS, data - &packet.data[0], wipe, ROW_BITS_WORDS, woff,
+							&codes[1], &coff[1], 1, samps, gopt.if_bits == 2, &EPL[1]);
+	}
+
+	gain = (gopt.if_bits == 2) ? IF_BITS_GAIN_2 : IF_BITS_GAIN_1;
+
+	c->I[0] += EPL[0].i*gain;
+	c->I[1] += EPL[1].i*gain;
+	c->I[2] += EPL[2].i*gain;
+
+	c->Q[0] += EPL[0].q*gain;
+	c->Q[1] += EPL[1].q*gain;
+	c->Q[2] += EPL[2].q*gain;
+
+	for(lcv = 0; lcv < (int32)state.taps; lcv++)
+	{
+		c->tap_I[lcv] += EPL[lcv+3].i*gain;
+		c->tap_Q[lcv] += EPL[lcv+3].q*gain;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::DumpAccum(Correlation_S *c)
 {
 	float f1, f2, fix, ang;
 	float code_phase;
-	int32 bin, offset, lcv, bread;
+	int32 offset, lcv, bread;
 	float sang, cang, tI, tQ;
 
 	/* First rotate correlation based on nco frequency and actually frequency used for correlation */
@@ -445,7 +599,7 @@ void Correlator::DumpAccum(Correlation_S *c)
 	ang = state.carrier_phase_prev*(float)TWO_PI + fix;
 	ang = -ang; cang = cos(ang); sang = sin(ang);
 
-	state.carrier_phase_prev = state.carrier_phase_mod;
+	state.carrier_phase_prev = (double)state.carrier_phase_fix*NCO_SCALE;
 
 	tI = c->I[0];	tQ = c->Q[0];
 	c->I[0] = (int32)floor(cang*tI - sang*tQ);
@@ -459,11 +613,44 @@ void Correlator::DumpAccum(Correlation_S *c)
 	c->I[2] = (int32)floor(cang*tI - sang*tQ);
 	c->Q[2] = (int32)floor(sang*tI + cang*tQ);
 
-	/* Get the feedback */
-	aChannel->Accum(c, &feedback);
+	c->el = state.el;
+	c->taps = state.taps;
+	c->spacing = tap_spacing;
+	for(lcv = 0; lcv < c->taps; lcv++)
+	{
+		tI = c->tap_I[lcv];	tQ = c->tap_Q[lcv];
+		c->tap_I[lcv] = (int32)floor(cang*tI - sang*tQ);
+		c->tap_Q[lcv] = (int32)floor(sang*tI + cang*tQ);
+	}
+
+	/* What the channel is about to see, and the NCOs that made it */
+	if(rfp != NULL)
+	{
+		Record(REC_DUMP, c->taps);
+		fwrite(&c->I[0], sizeof(int32), 3, rfp);
+		fwrite(&c->Q[0], sizeof(int32), 3, rfp);
+		fwrite(&c->el, sizeof(int32), 1, rfp);
+		if(c->taps)
+		{
+			fwrite(&c->tap_I[0], sizeof(int32), c->taps, rfp);
+			fwrite(&c->tap_Q[0], sizeof(int32), c->taps, rfp);
+			fwrite(&c->spacing, sizeof(float), 1, rfp);
+		}
+	}
+
+	if(gopt.loop_thread)
+	{
+		/* The tracking thread runs the channel, the feedback comes back a dump later */
+		Loops(c);
+	}
+	else
+	{
+		/* Get the feedback */
+		aChannel->Accum(c, &feedback);
 
-	 /* Apply feedback */
-	ProcessFeedback(&feedback);
+		 /* Apply feedback */
+		ProcessFeedback(&feedback, state.code_epochs);
+	}
 
 	/* Is this needed? */
 	state.count++;
@@ -471,49 +658,234 @@ void Correlator::DumpAccum(Correlation_S *c)
 	/* Now clear out accumulation */
 	c->I[0] = c->I[1] = c->I[2] = 0;
 	c->Q[0] = c->Q[1] = c->Q[2] = 0;
+	for(lcv = 0; lcv < c->taps; lcv++)
+		c->tap_I[lcv] = c->tap_Q[lcv] = 0;
+
+	/* The channel killed itself, the state is cleared (code_inc is 0) */
+	if(state.active == 0)
+		return;
 
 	/* Calculate when next rollover occurs (in samples) */
-	state.rollover = (int32) ceil(((double)CODE_CHIPS - state.code_phase_mod)*SAMPLE_FREQUENCY/state.code_nco);
+	state.rollover = (uint32)((CODE_CHIPS*NCO_ONE - state.code_phase_fix + state.code_inc - 1)/state.code_inc);
 
-	bin = (int32) floor((state.code_phase_mod + 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[0] = code_rows[bin];
-	state.cbin[0] = bin;
+	SetBins();
 
-	bin = (int32) floor((state.code_phase_mod + 0.0)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[1] = code_rows[bin];
-	state.cbin[1] = bin;
+	/* Remember to nuke this! */
+	state.scount = 0;
 
-	bin = (int32) floor((state.code_phase_mod - 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[2] = code_rows[bin];
-	state.cbin[2] = bin;
+	dump_epochs = state.code_epochs;
 
-	/* Update pointer to pre-sampled sine vector */
-	bin = (int32) floor((state.carrier_nco - IF_FREQUENCY)/CARRIER_SPACING + 0.5) + CARRIER_BINS;
+}
+/*----------------------------------------------------------------------------------------------*/
 
-	/* Catch errors if Doppler goes out of range */
-	if(bin < 0)	bin = 0; if(bin > 2*CARRIER_BINS) bin = 2*CARRIER_BINS;
-	state.psine = sine_rows[bin];
-	state.sbin = bin;
 
-	/* Remember to nuke this! */
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Propagate the code & carrier NCOs across _samps samples that never arrived (negative when a
+ * recorded file loops), at the current code & carrier rates. Done in double, _samps*inc can
+ * overflow the fixed point. The 1 ms/20 ms/z count epochs move with the code, the channel is
+ * caught up at the next rollover, see Resync().
+ */
+void Correlator::Skip(int64 _samps)
+{
+	double chips, cycles, whole;
+	int64 epochs;
+
+	/* Whole code periods go into the epoch counters, the fraction back into the NCO */
+	chips = (double)state.code_phase_fix*NCO_SCALE + (double)_samps*(double)state.code_inc*NCO_SCALE;
+	epochs = (int64)floor(chips/(double)CODE_CHIPS);
+	state.code_phase_fix = (int64)floor((chips - (double)epochs*(double)CODE_CHIPS)*(double)NCO_ONE);
+	if(state.code_phase_fix < 0)
+		state.code_phase_fix = 0;
+	if(state.code_phase_fix >= CODE_CHIPS*NCO_ONE)
+		state.code_phase_fix = CODE_CHIPS*NCO_ONE - 1;
+	state.code_epochs += epochs;
+
+	/* Same for the carrier */
+	cycles = (double)state.carrier_phase_fix*NCO_SCALE + (double)_samps*(double)state.carrier_inc*NCO_SCALE;
+	whole = floor(cycles);
+	state.carrier_cycles += (int64)whole;
+	state.carrier_phase_fix = (int64)floor((cycles - whole)*(double)NCO_ONE) & (NCO_ONE - 1);
+
+	nco_phase += (uint32)((uint64)_samps*nco_phase_inc);
+
+	StepEpochs(epochs);
+
+	/* Next rollover from the new phase */
+	state.rollover = (uint32)((CODE_CHIPS*NCO_ONE - state.code_phase_fix + state.code_inc - 1)/state.code_inc);
+
+	resync = true;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Takes the place of DumpAccum() at the first rollover after a gap */
+void Correlator::Resync()
+{
+	Corr_Dump_S d;
+	int32 lcv;
+
+	/* What was accumulated up to the gap is a partial period, drop it */
+	corr.I[0] = corr.I[1] = corr.I[2] = 0;
+	corr.Q[0] = corr.Q[1] = corr.Q[2] = 0;
+	for(lcv = 0; lcv < CORR_MAX_TAPS; lcv++)
+		corr.tap_I[lcv] = corr.tap_Q[lcv] = 0;
+
+	/* The channel skips the code periods it never saw */
+	if(rfp != NULL)
+		Record(REC_SKIP, (int32)(state.code_epochs - dump_epochs));
+
+	if(gopt.loop_thread)
+	{
+		d.gen = gen;
+		d.skip = (int32)(state.code_epochs - dump_epochs);
+		d.epochs = state.code_epochs;
+		Post(&d);
+	}
+	else
+		aChannel->Skip((int32)(state.code_epochs - dump_epochs));
+	dump_epochs = state.code_epochs;
+
+	state.carrier_phase_prev = (double)state.carrier_phase_fix*NCO_SCALE;
+	state.rollover = (uint32)((CODE_CHIPS*NCO_ONE - state.code_phase_fix + state.code_inc - 1)/state.code_inc);
+
+	SetBins();
+
 	state.scount = 0;
+	resync = false;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Header of a -record record, stamped with the packet and the correlator's current state. Dumps
+ * carry only the taps in use, so a recording without -taps costs 76 bytes per ms per channel.
+ */
+void Correlator::Record(int32 _type, int32 _value)
+{
+	Corr_Record_S r;
+
+	r.type			= _type;
+	r.value			= _value;
+	r.count			= packet.count;
+	r._1ms_epoch	= state._1ms_epoch;
+	r._20ms_epoch	= state._20ms_epoch;
+	r._z_count		= state._z_count;
+	r.epochs		= state.code_epochs;
+	r.carrier_nco	= state.carrier_nco;
+	r.code_nco		= state.code_nco;
+
+	fwrite(&r, sizeof(Corr_Record_S), 1, rfp);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Move the epochs as a ms of the week, z count is in 6 second steps */
+void Correlator::StepEpochs(int64 _epochs)
+{
+	int64 ms, week;
+
+	week = (int64)SECONDS_IN_WEEK*1000;
+	ms = (int64)state._z_count*1000 + state._20ms_epoch*20 + state._1ms_epoch + _epochs;
+	ms = ((ms % week) + week) % week;
+	state._z_count = (uint32)((ms/6000)*6);
+	state._20ms_epoch = (uint32)((ms % 6000)/20);
+	state._1ms_epoch = (uint32)(ms % 20);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * With -loops the correlator never waits on the channel. The dump is queued for the tracking
+ * thread and the feedback that has come back since the last dump (normally the answer to the
+ * previous one) is applied, so the NCOs run one dump behind the loops.
+ */
+void Correlator::Loops(Correlation_S *c)
+{
+	Corr_Dump_S d;
+	Loop_Feedback_S f;
+
+	d.gen = gen;
+	d.skip = 0;
+	d.epochs = state.code_epochs;
+	d.corr = *c;
+	Post(&d);
+
+	while(aChannel->GetFeedback(&f))
+	{
+		/* Left over from before the last start */
+		if(f.gen != gen)
+			continue;
+
+		if(state.code_epochs - f.epochs > 1)
+			loop_late++;
+
+		ProcessFeedback(&f.nco, f.epochs);
+
+		/* Killed, the rest is for a correlator that is gone */
+		if(state.active == 0)
+			break;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * A dump the channel's queue has no room for is lost, the channel then has to skip the code
+ * periods it missed ahead of the next dump that gets through, or its epochs fall out of step.
+ */
+void Correlator::Post(Corr_Dump_S *_dump)
+{
+	Corr_Dump_S s;
+
+	if(loop_lost)
+	{
+		s.gen = gen;
+		s.skip = loop_lost;
+		s.epochs = state.code_epochs;
+		if(aChannel->PostDump(&s))
+			loop_lost = 0;
+	}
+
+	if(loop_lost || !aChannel->PostDump(_dump))
+	{
+		loop_lost += _dump->skip ? _dump->skip : 1;
+		loop_full++;
+	}
 
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
-void Correlator::ProcessFeedback(NCO_Command_S *f)
+/*!
+ * _epochs is the correlator's code_epochs at the dump the feedback answers. The epoch resets are
+ * relative to that dump, so with -loops they are applied there and then carried forward to now.
+ */
+void Correlator::ProcessFeedback(NCO_Command_S *f, int64 _epochs)
 {
+	int64 lag;
 
 	state.carrier_nco  	= f->carrier_nco;
 	state.code_nco 	   	= f->code_nco;
 	state.navigate		= f->navigate;
+	state.el_every		= f->el_every;
 
-	nco_phase_inc = (uint32)floor((double)state.carrier_nco*(double)2.097152000000000e+03);
+	SetNCO();
+
+	lag = state.code_epochs - _epochs;
+	if(lag && (f->reset_1ms || f->reset_20ms || f->set_z_count))
+		StepEpochs(-lag);
 
 	if(f->reset_1ms)
 		state._1ms_epoch = 0;
@@ -524,6 +896,9 @@ void Correlator::ProcessFeedback(NCO_Command_S *f)
 	if(f->set_z_count)
 		state._z_count = f->z_count;
 
+	if(lag && (f->reset_1ms || f->reset_20ms || f->set_z_count))
+		StepEpochs(lag);
+
 	/* Update correlator state */
 	if(f->kill)
 	{
@@ -542,6 +917,114 @@ void Correlator::ProcessFeedback(NCO_Command_S *f)
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::SetNCO()
+{
+
+	state.code_inc		= (int64)floor(state.code_nco*(double)NCO_ONE/SAMPLE_FREQUENCY + 0.5);
+	state.carrier_inc	= (int64)floor(state.carrier_nco*(double)NCO_ONE/SAMPLE_FREQUENCY + 0.5);
+
+	nco_phase_inc = (uint32)floor((double)state.carrier_nco*(double)2.097152000000000e+03);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::SetBins()
+{
+	int32 lcv, bin;
+	int64 phase, shift, step;
+
+	/* Pick up a new tap configuration between accumulations */
+	if(taps_pend)
+	{
+		Lock();
+		ApplyTaps(tap_delays_pend, tap_spacing_pend);
+		taps_pend = false;
+		Unlock();
+	}
+
+	state.taps = tap_delays ? 2*tap_delays + 1 : 0;
+
+	/* Early & late this code period? Always with the taps, they are measuring the whole peak */
+	state.el = state.taps || (state.el_every <= 1) || ((state.code_epochs % state.el_every) == 0);
+
+	/* Code advance per sample of the pre-sampled rows */
+	step = (int64)((double)CODE_RATE*(double)NCO_ONE/(double)SAMPLE_FREQUENCY);
+
+	for(lcv = 0; lcv < (int32)state.taps + 3; lcv++)
+	{
+		/* Whole samples of the tap's offset move the pointer along the row... */
+		phase = state.code_phase_fix + tap_offset[lcv];
+		shift = (phase + (step >> 1)) / step;
+		if(shift*step > phase + (step >> 1)) shift--;
+		if(shift < -CORR_TAP_PAD) shift = -CORR_TAP_PAD; if(shift > CORR_TAP_PAD) shift = CORR_TAP_PAD;
+
+		/* ...and the rest picks one of the CODE_BINS per chip rows, round to the nearest */
+		phase -= shift*step;
+		bin = (int32)((phase*CODE_BINS + (NCO_ONE >> 1)) >> NCO_FRAC_BITS) + CODE_BINS/2;
+		if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
+		state.pcode[lcv] = code_rows[bin] + CORR_TAP_PAD + shift;
+		state.cbin[lcv] = bin;
+	}
+
+	/* Update pointer to pre-sampled sine vector */
+	bin = (int32) floor((state.carrier_nco - IF_FREQUENCY)/CARRIER_SPACING + 0.5) + CARRIER_BINS;
+
+	/* Catch errors if Doppler goes out of range */
+	if(bin < 0)	bin = 0; if(bin > 2*CARRIER_BINS) bin = 2*CARRIER_BINS;
+	state.psine = sine_rows[bin];
+	state.sbin = bin;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::SetTaps(int32 _delays, float _spacing)
+{
+
+	if((_delays < 0) || (_delays > CORR_MAX_DELAYS) || (_spacing <= 0) || (_delays*_spacing > CORR_MAX_SPAN))
+	{
+		if(gopt.verbose)
+			printf("Correlator %d can not run %d taps spaced %f chips\n", chan, _delays, _spacing);
+		return;
+	}
+
+	Lock();
+	tap_delays_pend = _delays;
+	tap_spacing_pend = _spacing;
+	taps_pend = true;
+	Unlock();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::ApplyTaps(int32 _delays, float _spacing)
+{
+
+	int32 lcv;
+
+	tap_delays = _delays;
+	tap_spacing = _spacing;
+
+	/* Early, prompt & late for the loops */
+	tap_offset[0] = NCO_ONE >> 1;
+	tap_offset[1] = 0;
+	tap_offset[2] = -(NCO_ONE >> 1);
+
+	/* Then the multipath taps, earliest first */
+	for(lcv = 0; lcv < 2*tap_delays + 1; lcv++)
+		tap_offset[lcv+3] = (int64)floor((double)(tap_delays - lcv)*(double)tap_spacing*(double)NCO_ONE + 0.5);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::Export()
 {
@@ -576,7 +1059,7 @@ void Correlator::SamplePRN()
 	MIX *row;
 	int32 lcv, lcv2, sv, k;
 	int32 index;
-	float phase_step, phase;
+	double phase_step, phase;
 
 	k = 0;
 
@@ -591,12 +1074,13 @@ void Correlator::SamplePRN()
 			row = main_code_rows[k];
 			k++;
 
-			phase = -0.5 + (float)lcv/(float)CODE_BINS;
+			/* Row starts CORR_TAP_PAD samples early so taps can reach behind prompt */
 			phase_step = CODE_RATE/SAMPLE_FREQUENCY;
+			phase = -0.5 + (double)lcv/(double)CODE_BINS - CORR_TAP_PAD*phase_step;
 
 			for(lcv2 = 0; lcv2 < 2*SAMPS_MS; lcv2++)
 			{
-				index  = (int32)floor(phase + CODE_CHIPS) % CODE_CHIPS;
+				index  = (int32)floor(phase + lcv2*phase_step + CODE_CHIPS) % CODE_CHIPS;
 
 				if(scratch[index].i)
 					row[lcv2].i = row[lcv2].ni = 0x0001; /* Map 1 to 0x0000, and 0 to 0xffff for SIMD code */
@@ -604,8 +1088,6 @@ void Correlator::SamplePRN()
 					row[lcv2].i = row[lcv2].ni = 0xffff;
 
 				row[lcv2].q = row[lcv2].nq = 0x0;
-
-				phase += phase_step;
 			}
 		}
 
@@ -615,6 +1097,39 @@ void Correlator::SamplePRN()
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::PackRows()
+{
+	uint32 planes[4*ROW_BITS_WORDS];
+	int32 lcv, lcv2, rows;
+
+	/* Carrier, keep the cos & sin sign planes */
+	sine_bits = new uint32[(2*CARRIER_BINS+1)*2*ROW_BITS_WORDS];
+	for(lcv = 0; lcv < 2*CARRIER_BINS+1; lcv++)
+	{
+		x86_pack_bits(sine_rows[lcv], planes, ROW_BITS_WORDS, 2*SAMPS_MS, 0);
+		memcpy(&sine_bits[lcv*2*ROW_BITS_WORDS], planes, 2*ROW_BITS_WORDS*sizeof(uint32));
+	}
+
+	/* Codes, just the sign of the inphase */
+	rows = NUM_CODES*(2*CODE_BINS+1);
+	main_code_bits = new uint32[rows*ROW_BITS_WORDS];
+	for(lcv = 0; lcv < rows; lcv++)
+	{
+		for(lcv2 = 0; lcv2 < 2*SAMPS_MS; lcv2++)
+		{
+			scratch[lcv2].i = main_code_rows[lcv][lcv2].i;
+			scratch[lcv2].q = 0;
+		}
+
+		x86_pack_bits(scratch, planes, ROW_BITS_WORDS, 2*SAMPS_MS, 0);
+		memcpy(&main_code_bits[lcv*ROW_BITS_WORDS], planes, ROW_BITS_WORDS*sizeof(uint32));
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::GetPRN(int32 _sv)
 {
@@ -625,8 +1140,11 @@ void Correlator::GetPRN(int32 _sv)
 	{
 		for(lcv = 0; lcv < (2*CODE_BINS+1); lcv++)
 		{
-			memcpy(code_rows[lcv], main_code_rows[lcv + _sv*(2*CODE_BINS+1)], 2*SAMPS_MS*sizeof(CPX));
+			memcpy(code_rows[lcv], main_code_rows[lcv + _sv*(2*CODE_BINS+1)], 2*SAMPS_MS*sizeof(MIX));
 		}
+
+		if(code_bits != NULL)
+			memcpy(code_bits, &main_code_bits[_sv*(2*CODE_BINS+1)*ROW_BITS_WORDS], (2*CODE_BINS+1)*ROW_BITS_WORDS*sizeof(uint32));
 	}
 
 }
@@ -636,13 +1154,10 @@ void Correlator::GetPRN(int32 _sv)
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::InitCorrelator()
 {
-	double code_phase;
 	double dt;
-	int32 bin;
-	int32 inc;
 
-	/* Update delay based on current packet count */
-	dt = (double)packet.count - (double)result.count;
+	/* Update delay based on the last ms correlated */
+	dt = (double)(packet.count + packet.ms - 1) - (double)result.count;
 	dt *= (double).001;
 	dt *= (double)result.doppler*(double)CODE_RATE/(double)L1;
 	result.delay += (double)CODE_CHIPS + dt;
@@ -653,51 +1168,34 @@ void Correlator::InitCorrelator()
 	state.active 				= 1;
 	state.count					= 0;
 	state.scount				= 0;
-	state.code_phase 			= result.delay;
-	state.code_phase_mod 		= result.delay;
-	state.carrier_phase 		= 0;
-	state.carrier_phase_mod 	= 0;
+	state.code_phase_fix		= (int64)floor(result.delay*(double)NCO_ONE + 0.5) % (CODE_CHIPS*NCO_ONE);
+	state.carrier_phase_fix		= 0;
+	state.code_epochs			= 0;
+	state.carrier_cycles		= 0;
+	state.carrier_phase_prev	= 0;
 	state.code_nco				= CODE_RATE + result.doppler*CODE_RATE/L1;
 	state.carrier_nco			= IF_FREQUENCY + result.doppler;
 	state._1ms_epoch 			= 0;
 	state._20ms_epoch			= 0;
-	state.rollover 				= (int32) ceil(((double)CODE_CHIPS - state.code_phase)*SAMPLE_FREQUENCY/state.code_nco); /* Calculate rollover point */
-
-	GetPRN(state.sv);
+	state.el_every				= 1;
 
-	nco_phase_inc = (uint32)floor((double)state.carrier_nco*(double)2.097152000000000e+03);
+	SetNCO();
 	nco_phase = 0;
 
-	//inc = (int32)floor(result.delay*2048.0/1023.0);
-
-	/* Initialize the code bin pointers */
-	bin = (int32) floor((state.code_phase_mod + 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[0] = code_rows[bin];
-	state.pcode[0] += inc;
-	state.cbin[0] = bin;
+	dump_epochs = 0;
+	resync = false;
 
-	bin = (int32) floor((state.code_phase_mod + 0.0)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[1] = code_rows[bin];
-	state.pcode[1] += inc;
-	state.cbin[1] = bin;
+	gen++;
+	loop_lost = 0;
 
-	bin = (int32) floor((state.code_phase_mod - 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[2] = code_rows[bin];
-	state.pcode[2] += inc;
-	state.cbin[2] = bin;
+	/* Calculate rollover point */
+	state.rollover = (uint32)((CODE_CHIPS*NCO_ONE - state.code_phase_fix + state.code_inc - 1)/state.code_inc);
 
-	/* Update pointer to pre-sampled sine vector */
-	bin = (int32) floor((state.carrier_nco - IF_FREQUENCY)/CARRIER_SPACING + 0.5) + CARRIER_BINS;
+	GetPRN(state.sv);
 
-	/* Catch errors if Doppler goes out of range */
-	if(bin < 0)	bin = 0; if(bin > 2*CARRIER_BINS) bin = 2*CARRIER_BINS;
-	state.psine = sine_rows[bin];
-	state.sbin = bin;
+	SetBins();
 
-	//printf("Correlator initialized %d,%d,%f,%f,%f,%d,%d\n",chan,result.sv,state.carrier_nco,state.code_nco,state.code_phase,packet.count,result.count);
+	//printf("Correlator initialized %d,%d,%f,%f,%f,%d,%d\n",chan,result.sv,state.carrier_nco,state.code_nco,result.delay,packet.count,result.count);
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -34,10 +34,11 @@ class Correlator : public Threaded_Object
 	private:
 
 		FILE *crap;
+		FILE *rfp;												//!< -record, this correlator's REC_FILE
 
 		/* Default object variables */
-		int32				packet_count;						//!< Count 1ms packets
-		ms_packet			packet;								//!< 1ms of data
+		int32				packet_count;						//!< Count FIFO packets
+		ms_packet			packet;								//!< block_ms of data
 
 		int32 				chan;			 					//!< Which channel is this?
 		Acq_Command_M 		result; 							//!< An acquisition result has been returned!
@@ -54,13 +55,29 @@ class Correlator : public Threaded_Object
 		static CPX 			**sine_rows;						//!< Row pointers to above
 		static MIX  		*main_code_table;					//!< Hold the PRN lookup table for all 32 SVs  [2*CODE_BINS+1][2*SAMPS_MS];
 		static MIX 			**main_code_rows;					//!< Row pointers to above
+		static uint32		*sine_bits;							//!< With -bits: cos & sin sign planes of each wipeoff row
+		static uint32		*main_code_bits;					//!< With -bits: sign plane of each row of main_code_table
 
 		MIX					*code_table;						//!< Local code table
 		MIX					**code_rows;						//!< Row pointers to above
+		uint32				*code_bits;							//!< With -bits: sign plane of each row of code_table
 		CPX					scratch[2*SAMPS_MS];				//!< Scratch data
 		CPX					lookup[SAMPS_MS];					//!< Hold the sine lookup
 		uint32				nco_phase_inc;						//!< For dynamically generating the wipeoff
 		uint32				nco_phase;							//!< For dynamically generating the wipeoff
+		int64				tap_offset[CORR_MAX_TAPS+3];		//!< Code offset of E, P, L and the multipath taps (NCO fixed point)
+		int32				tap_delays;							//!< Multipath taps (plus-minus), 0 for none
+		float				tap_spacing;						//!< Spacing of the multipath taps (chips)
+		int32				taps_pend;							//!< A new tap configuration is waiting
+		int32				tap_delays_pend;					//!< Pending tap_delays
+		float				tap_spacing_pend;					//!< Pending tap_spacing
+		int64				next_sample;						//!< Source sample the next packet should start at
+		int64				dump_epochs;						//!< code_epochs at the last dump to the channel
+		int32				resync;								//!< Propagated across a gap, waiting for the next rollover
+		uint32				gen;								//!< Bumped at every start, tags the dumps & feedback with -loops
+		int32				loop_lost;							//!< ms of dumps the channel's queue had no room for, yet to be skipped
+		int32				loop_full;							//!< Dumps that found the channel's queue full
+		int32				loop_late;							//!< Feedback that came back more than one dump late
 
 	public:
 
@@ -77,9 +94,23 @@ class Correlator : public Threaded_Object
 		void InitCorrelator();									//!< Initialize a correlator/channel with an acquisition result
 		void DumpAccum(Correlation_S *c);						//!< Dump accumulation to channel for processing
 		void UpdateState(int32 samps);							//!< Update correlator state
-		void ProcessFeedback(NCO_Command_S *f);					//!< Process the feedback
+		void AccumBits(Correlation_S *c, CPX *data, int32 samps);	//!< Accum() on the 1/2 bit IF with XOR/popcount
+		void PackRows();										//!< Pack the wipeoff & code tables into bit-planes
+		void ProcessFeedback(NCO_Command_S *f, int64 _epochs);	//!< Process the feedback to the dump made at code_epochs _epochs
+		void Loops(Correlation_S *c);							//!< -loops, queue the dump and apply whatever feedback has come back
+		void Post(Corr_Dump_S *_dump);							//!< -loops, queue a dump or skip for the tracking thread
+		void StepEpochs(int64 _epochs);							//!< Move the 1 ms/20 ms/z count epochs by _epochs code periods
+		void SetNCO();											//!< Convert the code/carrier NCO frequencies to per sample phase increments
+		void SetBins();											//!< Point at the pre-sampled code & wipeoff rows nearest the current phase
+		void SetTaps(int32 _delays, float _spacing);			//!< Run 2*_delays+1 multipath taps, applied at the next dump
+		void ApplyTaps(int32 _delays, float _spacing);			//!< Work out the code offset of every tap
 		void Accum(Correlation_S *c, CPX *data, int32 samps);	//!< Do the actual accumulation
 		void SineGen(int32 samps);								//!< Dynamic wipeoff generation
+		void Skip(int64 _samps);								//!< Propagate the NCOs across _samps missing samples
+		void Resync();											//!< First rollover after a gap, catch the channel up
+		void Record(int32 _type, int32 _value);					//!< -record, write a record header, the payload follows
+		int32 getLoopFull(){return(loop_full);};				//!< Dumps that found the channel's queue full
+		int32 getLoopLate(){return(loop_late);};				//!< Feedback more than one dump late
 };
 
 #endif /* Correlator_H */
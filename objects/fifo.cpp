@@ -47,6 +47,13 @@ void *FIFO_Thread(void *_arg)
 void FIFO::Start()
 {
 
+	/* Keep the IF ring on the same node as the FIFO thread */
+	if(node >= 0)
+	{
+		numa_place(buff, sizeof(ms_packet)*depth, node);
+		numa_place(data_buff, sizeof(CPX)*depth*block_ms*SAMPS_MS, node);
+	}
+
 	Start_Thread(FIFO_Thread, NULL);
 
 	if(gopt.verbose)
@@ -68,21 +75,32 @@ FIFO::FIFO()
 {
 	int32 lcv;
 
+	/* Each packet carries block_ms of IF, keep the depth at ~FIFO_DEPTH ms */
+	block_ms = gopt.block_ms;
+	depth = FIFO_DEPTH/block_ms;
+
 	/* Create the buffer */
-	buff = new ms_packet[FIFO_DEPTH];
+	buff = new ms_packet[depth];
+	data_buff = new CPX[depth*block_ms*SAMPS_MS];
+	bits_buff = NULL;
+	if(gopt.if_bits)
+		bits_buff = new uint32[depth*4*IF_BITS_WORDS];
 
-	memset(buff, 0x0, sizeof(ms_packet)*FIFO_DEPTH);
+	memset(buff, 0x0, sizeof(ms_packet)*depth);
 
 	head = &buff[0];
 	tail = &buff[0];
 
-	for(lcv = 0; lcv < FIFO_DEPTH-1; lcv++)
-		buff[lcv].next = &buff[lcv+1];
-
-	buff[FIFO_DEPTH-1].next = &buff[0];
+	for(lcv = 0; lcv < depth; lcv++)
+	{
+		buff[lcv].next = &buff[(lcv+1) % depth];
+		buff[lcv].data = &data_buff[lcv*block_ms*SAMPS_MS];
+		if(bits_buff != NULL)
+			buff[lcv].bits = &bits_buff[lcv*4*IF_BITS_WORDS];
+	}
 
 	/* Buffer for the raw IF data */
-	if_buff = new CPX[IF_SAMPS_MS];
+	if_buff = new CPX[block_ms*IF_SAMPS_MS];
 
 	/* Make pipe write non-blocking, this is to prevent the USRP from overflowing,
 	 * which hoses the data steam. It is up to the CLIENT to make sure it is
@@ -91,6 +109,12 @@ FIFO::FIFO()
 
 	tic = overflw = count = 0;
 
+	last_sample = -1;
+	block_sample = 0;
+	block_skip_ms = block_skip = 0;
+	gap_run = 0;
+	gaps = gap_ms = max_gap = jumps = 0;
+
 	//agc_scale = 1 << AGC_BITS;
 	agc_scale = 2048;
 
@@ -119,6 +143,9 @@ FIFO::~FIFO()
 
 	delete [] if_buff;
 	delete [] buff;
+	delete [] data_buff;
+	if(bits_buff != NULL)
+		delete [] bits_buff;
 
 	close(npipe);
 
@@ -145,9 +172,9 @@ void FIFO::Import()
 	char *p;
 	int32 nbytes, bread, bytes_per_read, agc_scale_p = agc_scale;
 
-	bytes_per_read = IF_SAMPS_MS*sizeof(CPX);
+	bytes_per_read = block_ms*IF_SAMPS_MS*sizeof(CPX);
 
-	/* Get data from pipe (1 ms) */
+	/* Get data from pipe (block_ms) */
 	nbytes = 0; p = (char *)&if_buff[0];
 	while((nbytes < bytes_per_read) && grun)
 	{
@@ -159,25 +186,69 @@ void FIFO::Import()
 
 	IncStartTic();
 
-	/* Add to the buff */
-	if(count == 0)
+	/* The AGC still runs every ms */
+	for(lcv = 0; lcv < block_ms; lcv++)
 	{
-		init_agc(&if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
-	}
-	else if(count < 1000)
-	{
-		overflw = run_agc(&if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
+		if((count + lcv) == 0)
+			init_agc(&if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
+		else
+			overflw = run_agc(&if_buff[lcv*IF_SAMPS_MS], IF_SAMPS_MS, AGC_BITS, &agc_scale);
 	}
-	else
-	{
-		overflw = run_agc(&if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
+
+	Sequence();
+
+	/* Add to the buff */
+	if(count >= 1000)
 		Enqueue();
-	}
 
 	IncStopTic();
 
 	/* Resample? */
-	count++;
+	count += block_ms;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Number every sample by where it sits in the source, so the correlators can tell a hole in the
+ * stream (an overflow here, or the recorded file looping) from contiguous data. A live front end
+ * is contiguous by construction, a file being replayed jumps back each time it loops.
+ */
+void FIFO::Sequence()
+{
+	int32 lcv;
+	int64 src, prev;
+
+	block_skip_ms = block_skip = 0;
+	prev = last_sample;
+
+	for(lcv = 0; lcv < block_ms; lcv++)
+	{
+		if(gopt.post_process)
+			src = pPost_Process->Source(count + lcv);
+		else
+			src = (int64)(count + lcv)*SAMPS_MS;
+
+		if(lcv == 0)
+			block_sample = src;
+
+		if((prev >= 0) && (src != prev + SAMPS_MS))
+		{
+			jumps++;
+
+			/* At most one jump lands inside a block, one at its start shows up in block_sample */
+			if(lcv > 0)
+			{
+				block_skip_ms = lcv;
+				block_skip = (int32)(src - (prev + SAMPS_MS));
+			}
+		}
+
+		prev = src;
+	}
+
+	last_sample = prev;
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -196,20 +267,45 @@ void FIFO::Enqueue()
 		overflw++;
 		if((overflw % 1000) == 0)
 			printf("FIFO overflow!\n");
+
+		/* The correlators see the hole through the sample numbers */
+		gap_run += block_ms;
 	}
 	else
 	{
-		memcpy(&head->data[0], &if_buff[0], SAMPS_MS*sizeof(CPX));
-		head->count = count;
+		if(gap_run)
+		{
+			gaps++;
+			gap_ms += gap_run;
+			if((uint32)gap_run > max_gap)
+				max_gap = gap_run;
+			gap_run = 0;
+		}
+
+		memcpy(&head->data[0], &if_buff[0], block_ms*SAMPS_MS*sizeof(CPX));
 
-		/* Actual measurement rate needs to be double to properly calculate ICP */
-		if((count % (MEASUREMENT_INT)) == 0)
+		/* Low bit depth mode, the correlators only look at these */
+		if(gopt.if_bits)
+			x86_pack_bits(&head->data[0], &head->bits[0], IF_BITS_WORDS, block_ms*SAMPS_MS, IF_BITS_THRESH);
+		head->count = count;
+		head->ms = block_ms;
+		head->sample = block_sample;
+		head->skip_ms = block_skip_ms;
+		head->skip = block_skip;
+		head->stamp = start_ns; /* Time the packet came out of the pipe */
+
+		/* Actual measurement rate needs to be double to properly calculate ICP, at most one lands in a packet */
+		head->measurement = 0;
+		head->measurement_ms = 0;
+		for(lcv = 0; lcv < block_ms; lcv++)
 		{
-			tic++;
-			head->measurement = tic;
+			if(((count + lcv) % (MEASUREMENT_INT)) == 0)
+			{
+				tic++;
+				head->measurement = tic;
+				head->measurement_ms = lcv;
+			}
 		}
-		else
-			head->measurement = 0;
 
 		for(lcv = 0; lcv < (MAX_CHANNELS+1); lcv++)
 			head->accessed[lcv] = 666;
@@ -226,13 +322,32 @@ void FIFO::Enqueue()
 /*----------------------------------------------------------------------------------------------*/
 void FIFO::Dequeue(int32 _resource, ms_packet *p)
 {
-	int32 lcv, complete;
+	int32 lcv, complete, words;
 
 	Lock();
 
 	if(tail->accessed[_resource] = 666)
 	{
-		memcpy(p, tail, sizeof(ms_packet));
+		/* The payload goes into the caller's own buffers */
+		p->measurement = tail->measurement;
+		p->measurement_ms = tail->measurement_ms;
+		p->count = tail->count;
+		p->ms = tail->ms;
+		p->sample = tail->sample;
+		p->skip_ms = tail->skip_ms;
+		p->skip = tail->skip;
+		p->stamp = tail->stamp;
+
+		/* With -bits the correlators run from the bit-planes alone, only the acquisition needs the int16 IF */
+		if(p->bits != NULL)
+		{
+			/* Only the words of this packet's ms and the guard, each plane still IF_BITS_WORDS apart */
+			words = ((tail->ms*SAMPS_MS + 31) >> 5) + 1;
+			for(lcv = 0; lcv < 4; lcv++)
+				memcpy(&p->bits[lcv*IF_BITS_WORDS], &tail->bits[lcv*IF_BITS_WORDS], words*sizeof(uint32));
+		}
+		else
+			memcpy(p->data, tail->data, tail->ms*SAMPS_MS*sizeof(CPX));
 		tail->accessed[_resource] = 333;
 	}
 
@@ -260,10 +375,14 @@ void FIFO::Dequeue(int32 _resource, ms_packet *p)
 		{
 			telem.tic = tail->measurement;
 			telem.count = count;
-			telem.head = ((uint32)head - (uint32)&buff[0])/sizeof(ms_packet);
-			telem.tail = ((uint32)tail - (uint32)&buff[0])/sizeof(ms_packet);
+			telem.head = block_ms*(((uint32)head - (uint32)&buff[0])/sizeof(ms_packet));
+			telem.tail = block_ms*(((uint32)tail - (uint32)&buff[0])/sizeof(ms_packet));
 			telem.agc_scale = agc_scale;
 			telem.overflw = overflw;
+			telem.gaps = gaps;
+			telem.gap_ms = gap_ms;
+			telem.max_gap = max_gap;
+			telem.jumps = jumps;
 
 			write(FIFO_2_Telem_P[WRITE], &telem, sizeof(FIFO_M));
 			write(FIFO_2_PVT_P[WRITE], &telem, sizeof(FIFO_M));
@@ -40,7 +40,11 @@ class FIFO : public Threaded_Object
 		pthread_mutex_t	chan_mutex[MAX_CHANNELS+1]; //!< For each correlator
 
 		CPX *if_buff;		//!< Get the data from the named pipe
-		ms_packet *buff;	//!< 1 second buffer (in 1 ms packets)
+		ms_packet *buff;	//!< 1 second buffer (in block_ms packets)
+		CPX *data_buff;		//!< Payloads of the packets
+		uint32 *bits_buff;	//!< Bit-planes of the packets (-bits)
+		int32	block_ms;	//!< ms per packet
+		int32	depth;		//!< Number of packets
 		ms_packet *head;	//!< Pointer to the head
 		ms_packet *tail;	//!< Pointer to the tail
 
@@ -50,6 +54,16 @@ class FIFO : public Threaded_Object
 		int32	overflw;
 		int32	tic;		//!< Master receiver tic
 
+		int64	block_sample;	//!< Source sample of the first sample of the block just read
+		int64	last_sample;	//!< Source sample of the last ms of the previous block
+		int32	block_skip_ms;	//!< ms within the block where the source jumps...
+		int32	block_skip;		//!< ...and by how many samples
+		int32	gap_run;		//!< ms dropped since the last packet made it into the FIFO
+		uint32	gaps;			//!< Runs of dropped packets
+		uint32	gap_ms;			//!< Total ms dropped
+		uint32	max_gap;		//!< Longest run dropped (ms)
+		uint32	jumps;			//!< Discontinuities in the source
+
 		FIFO_M telem; //!< Stuff to dump to the telemetry
 
 	public:
@@ -61,10 +75,12 @@ class FIFO : public Threaded_Object
 		void Export();								//!< Get data out of the thread
 
 		void Open();
+		void Sequence();							//!< Find the source sample numbers of the block just read
 		void Enqueue();
 		void Dequeue(int32 _resource, ms_packet *p);
 		void SetScale(int32 _agc_scale);
 		void Wait(int32 _resource);
+		FIFO_M getTelem(){return(telem);};			//!< Last telemetry packet, including the gap statistics
 };
 
 #endif /* FIFO_H */
@@ -76,6 +76,12 @@ Post_Process::Post_Process(char *_fname)
 	bytes = -1000*60*IF_SAMPS_MS*sizeof(CPX);
 	fseek(fp, bytes, SEEK_END);
 
+	/* The stream starts here */
+	written = 0;
+	njumps = 1;
+	jump_ms[0] = 0;
+	jump_sample[0] = ftell(fp)/sizeof(CPX);
+
 	if(gopt.verbose)
 		printf("Creating Post_Process\n");
 
@@ -104,16 +110,26 @@ Post_Process::~Post_Process()
 void Post_Process::Import()
 {
 
-	int32 bytes;
+	int32 bytes, nread;
 
-	bytes = fread(&buff[0], sizeof(CPX), IF_SAMPS_MS, fp);
+	nread = fread(&buff[0], sizeof(CPX), IF_SAMPS_MS, fp);
 
 	bytes = -1000*60*IF_SAMPS_MS*sizeof(CPX);
 
-	/* Reset to loop forever */
-	if(feof(fp))
+	/* Reset to loop forever, remember where so the FIFO can flag the jump */
+	if(nread < IF_SAMPS_MS)
+	{
 		fseek(fp, bytes, SEEK_END);
 
+		Lock();
+		jump_ms[njumps % PP_JUMPS] = written;
+		jump_sample[njumps % PP_JUMPS] = ftell(fp)/sizeof(CPX);
+		njumps++;
+		Unlock();
+
+		fread(&buff[0], sizeof(CPX), IF_SAMPS_MS, fp);
+	}
+
 	IncStartTic();
 
 }
@@ -124,6 +140,7 @@ void Post_Process::Import()
 void Post_Process::Export()
 {
 	write(npipe, &buff[0], sizeof(CPX)*IF_SAMPS_MS);
+	written++;
 	IncStopTic();
 	usleep(1000);
 }
@@ -140,4 +157,27 @@ void Post_Process::Open()
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*! The FIFO reads the pipe in the order it was written, so ms _ms of what it reads came from here */
+int64 Post_Process::Source(int64 _ms)
+{
+	int64 sample;
+	int32 lcv;
+
+	Lock();
+
+	/* Latest (re)start at or before _ms */
+	for(lcv = njumps-1; lcv > 0 && lcv > njumps - PP_JUMPS; lcv--)
+		if(jump_ms[lcv % PP_JUMPS] <= _ms)
+			break;
+
+	sample = jump_sample[lcv % PP_JUMPS] + (_ms - jump_ms[lcv % PP_JUMPS])*IF_SAMPS_MS;
+
+	Unlock();
+
+	return(sample);
+}
+/*----------------------------------------------------------------------------------------------*/
 
+
+
@@ -25,6 +25,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 #include "includes.h"
 
+#define PP_JUMPS	(4)		//!< Loops of the file remembered for Source()
+
 /*! \ingroup CLASSES
  *
  */
@@ -40,6 +42,10 @@ class Post_Process : public Threaded_Object
 		CPX			*buff;
 		CPX 		*buff_in;
 		Acq_Command_M results[NUM_CODES];
+		int64		written;				//!< ms written to the pipe
+		int64		jump_ms[PP_JUMPS];		//!< ms of the stream at which the file was (re)started...
+		int64		jump_sample[PP_JUMPS];	//!< ...and the sample of the file it restarted at
+		int32		njumps;					//!< Number of the above so far
 
 	public:
 
@@ -49,6 +55,7 @@ class Post_Process : public Threaded_Object
 		void Start();								//!< Start the thread
 		void Import();								//!< Get data into the thread
 		void Export();								//!< Get data out of the thread
+		int64 Source(int64 _ms);					//!< Sample of the file that ms _ms of the stream started at
 
 };
 
@@ -55,7 +55,7 @@ void *Serial_Telemetry_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Serial_Telemetry::Start()
 {
-	/* With new priority specified */
+	/* With priority/affinity given by Set_Scheduling() */
 	Start_Thread(Serial_Telemetry_Thread, NULL);
 
 	if(gopt.verbose)
@@ -68,7 +68,7 @@ void Serial_Telemetry::Start()
 Serial_Telemetry::Serial_Telemetry(int32 _serial)
 {
 
-	execution_tic = start_tic = stop_tic = 0;
+	execution_tic = 0;
 	spipe_open = npipe_open = 0;
 	npipe[READ] = npipe[WRITE] = spipe = NULL;
 
@@ -454,51 +454,47 @@ void Serial_Telemetry::SendTaskHealth()
 {
 
 	uint32 lcv;
+	Threaded_Object *tasks[MAX_TASKS];
+
+	memset(tasks, 0x0, sizeof(tasks));
 
-	/* Get execution counters */
-	for(lcv = 0; lcv < CORRELATOR_TASK_ID; lcv++)
-		task_health.execution_tic[lcv] 					= pCorrelators[lcv]->GetExecTic();
-	//task_health.execution_tic[POST_PROCESS_TASK_ID]  	= pPost_Process->GetExecTic();
-	task_health.execution_tic[FIFO_TASK_ID]  			= pFIFO->GetExecTic();
-	task_health.execution_tic[COMMANDO_TASK_ID]  		= pCommando->GetExecTic();
-	//task_health.execution_tic[TELEMETRY_TASK_ID]  	= pTelemetry->GetExecTic();
-	task_health.execution_tic[SERIAL_TELEMETRY_TASK_ID] = pSerial_Telemetry->GetExecTic();
-	task_health.execution_tic[KEYBOARD_TASK_ID]  		= pKeyboard->GetExecTic();
-	task_health.execution_tic[EPHEMERIS_TASK_ID]  		= pEphemeris->GetExecTic();
-	task_health.execution_tic[SV_SELECT_TASK_ID]  		= pSV_Select->GetExecTic();
-	task_health.execution_tic[ACQUISITION_TASK_ID]  	= pAcquisition->GetExecTic();
-	task_health.execution_tic[PVT_TASK_ID]  			= pPVT->GetExecTic();
-	//task_health.execution_tic[EKF_TASK_ID]  			= pEKF->GetExecTic();
-
-	/* Get execution counters */
-	for(lcv = 0; lcv < CORRELATOR_TASK_ID; lcv++)
-		task_health.start_tic[lcv] 						= pCorrelators[lcv]->GetStartTic();
-	//task_health.start_tic[POST_PROCESS_TASK_ID]  		= pPost_Process->GetStartTic();
-	task_health.start_tic[FIFO_TASK_ID]  				= pFIFO->GetStartTic();
-	task_health.start_tic[COMMANDO_TASK_ID]  			= pCommando->GetStartTic();
-	//task_health.start_tic[TELEMETRY_TASK_ID]  		= pTelemetry->GetStartTic();
-	task_health.start_tic[SERIAL_TELEMETRY_TASK_ID] 	= pSerial_Telemetry->GetStartTic();
-	task_health.start_tic[KEYBOARD_TASK_ID]  			= pKeyboard->GetStartTic();
-	task_health.start_tic[EPHEMERIS_TASK_ID]  			= pEphemeris->GetStartTic();
-	task_health.start_tic[SV_SELECT_TASK_ID]  			= pSV_Select->GetStartTic();
-	task_health.start_tic[ACQUISITION_TASK_ID]  			= pAcquisition->GetStartTic();
-	task_health.start_tic[PVT_TASK_ID]  				= pPVT->GetStartTic();
-	//task_health.start_tic[EKF_TASK_ID]  				= pEKF->GetStartTic();
-
-	/* Get execution counters */
 	for(lcv = 0; lcv < CORRELATOR_TASK_ID; lcv++)
-		task_health.stop_tic[lcv]						= pCorrelators[lcv]->GetStopTic();
-	//task_health.stop_tic[POST_PROCESS_TASK_ID]  		= pPost_Process->GetStopTic();
-	task_health.stop_tic[FIFO_TASK_ID]  				= pFIFO->GetStopTic();
-	task_health.stop_tic[COMMANDO_TASK_ID]  			= pCommando->GetStopTic();
-	//task_health.stop_tic[TELEMETRY_TASK_ID]  			= pTelemetry->GetStopTic();
-	task_health.stop_tic[SERIAL_TELEMETRY_TASK_ID]		= pSerial_Telemetry->GetStopTic();
-	task_health.stop_tic[KEYBOARD_TASK_ID]  			= pKeyboard->GetStopTic();
-	task_health.stop_tic[EPHEMERIS_TASK_ID]  			= pEphemeris->GetStopTic();
-	task_health.stop_tic[SV_SELECT_TASK_ID]  			= pSV_Select->GetStopTic();
-	task_health.stop_tic[ACQUISITION_TASK_ID]  			= pAcquisition->GetStopTic();
-	task_health.stop_tic[PVT_TASK_ID]  					= pPVT->GetStopTic();
-	//task_health.stop_tic[EKF_TASK_ID]  				= pEKF->GetStopTic();
+		tasks[lcv] 						= pCorrelators[lcv];
+	//tasks[POST_PROCESS_TASK_ID]  		= pPost_Process;
+	tasks[FIFO_TASK_ID]  				= pFIFO;
+	tasks[COMMANDO_TASK_ID]  			= pCommando;
+	//tasks[TELEMETRY_TASK_ID]  		= pTelemetry;
+	tasks[SERIAL_TELEMETRY_TASK_ID] 	= pSerial_Telemetry;
+	tasks[KEYBOARD_TASK_ID]  			= pKeyboard;
+	tasks[EPHEMERIS_TASK_ID]  			= pEphemeris;
+	tasks[SV_SELECT_TASK_ID]  			= pSV_Select;
+	tasks[ACQUISITION_TASK_ID]  		= pAcquisition[0];
+	tasks[PVT_TASK_ID]  				= pPVT;
+	//tasks[EKF_TASK_ID]  				= pEKF;
+
+	memset(&task_health, 0x0, sizeof(Task_Health_M));
+
+	/* Get execution counters, scheduling and latencies */
+	for(lcv = 0; lcv < MAX_TASKS; lcv++)
+	{
+		if(tasks[lcv] == NULL)
+			continue;
+
+		task_health.execution_tic[lcv] = tasks[lcv]->GetExecTic();
+		task_health.sched[lcv] = tasks[lcv]->GetSched();
+
+		task_health.proc[0][lcv] = NS_2_US16(tasks[lcv]->GetProc()->Percentile(50.0));
+		task_health.proc[1][lcv] = NS_2_US16(tasks[lcv]->GetProc()->Percentile(99.0));
+		task_health.proc[2][lcv] = NS_2_US16(tasks[lcv]->GetProc()->GetMax());
+
+		task_health.wait[0][lcv] = NS_2_US16(tasks[lcv]->GetWait()->Percentile(50.0));
+		task_health.wait[1][lcv] = NS_2_US16(tasks[lcv]->GetWait()->Percentile(99.0));
+		task_health.wait[2][lcv] = NS_2_US16(tasks[lcv]->GetWait()->GetMax());
+
+		task_health.lag[0][lcv] = NS_2_US16(tasks[lcv]->GetLag()->Percentile(50.0));
+		task_health.lag[1][lcv] = NS_2_US16(tasks[lcv]->GetLag()->Percentile(99.0));
+		task_health.lag[2][lcv] = NS_2_US16(tasks[lcv]->GetLag()->GetMax());
+	}
 
 	/* Form the packet header */
 	FormCCSDSPacketHeader(&packet_header, TASK_HEALTH_M_ID, 0, sizeof(Task_Health_M), 0, packet_tic++);
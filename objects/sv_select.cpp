@@ -47,7 +47,7 @@ void *SV_Select_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void SV_Select::Start()
 {
-	/* With new priority specified */
+	/* With priority/affinity given by Set_Scheduling() */
 	Start_Thread(SV_Select_Thread, NULL);
 
 	if(gopt.verbose)
@@ -60,10 +60,29 @@ void SV_Select::Start()
 SV_Select::SV_Select()
 {
 
+	int32 lcv;
+
 	sv = 0;
 	mode = WARM_START;
 	mask_angle = PI/2;
 
+	/* Scheduler state */
+	inflight = 0;
+	nqueue = 0;
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		chan_sv[lcv] = -1;
+		chan_ns[lcv] = 0;
+	}
+
+	for(lcv = 0; lcv < NUM_CODES; lcv++)
+	{
+		tried_ns[lcv] = 0;
+		lost_ns[lcv] = 0;
+		lost_doppler[lcv] = 0;
+		misses[lcv] = 0;
+	}
+
 	pnav = &pvt.master_nav;
 	pclock = &pvt.master_clock;
 
@@ -106,20 +125,31 @@ void SV_Select::setConfig(Acq_Config_M *cfg)
 
 
 /*----------------------------------------------------------------------------------------------*/
+/*!
+ * Sleep until something happens, an acquisition result, a channel letting its SV go or a new PVT,
+ * or SV_SELECT_WAIT ms without any of them. Then take in everything that is waiting.
+ */
 void SV_Select::Import()
 {
 
+	struct pollfd fds[3];
+	Chan_2_SV_Select_S event;
 	int32 bread;
 
-	/* Pend on PVT sltn */
+	fds[0].fd = Acq_2_Trak_P[READ];
+	fds[1].fd = Chan_2_SV_Select_P[READ];
+	fds[2].fd = PVT_2_SV_Select_P[READ];
+	fds[0].events = fds[1].events = fds[2].events = POLLIN;
+
+	poll(fds, 3, SV_SELECT_WAIT);
+
+	/* Latest PVT sltn */
 	bread = sizeof(PVT_2_SV_Select_S);
 	while(bread == sizeof(PVT_2_SV_Select_S))
 	{
 		bread =	read(PVT_2_SV_Select_P[READ], &pvt, sizeof(PVT_2_SV_Select_S));
 	}
 
-	usleep(1000000/ACQS_PER_SECOND);
-
 	/* If the PVT is less than 1 minutes old, still use it */
 	if((pnav->stale_ticks < (60*TICS_PER_SECOND)) && pnav->initial_convergence)
 	{
@@ -136,94 +166,179 @@ void SV_Select::Import()
 		mode = COLD_START;
 	}
 
+	/* An SV lost by a channel that really had it goes to the front of the queue */
+	while(read(Chan_2_SV_Select_P[READ], &event, sizeof(Chan_2_SV_Select_S)) == sizeof(Chan_2_SV_Select_S))
+	{
+		if(event.locked && (event.sv >= 0) && (event.sv < NUM_CODES))
+		{
+			lost_ns[event.sv] = monotonic_ns();
+			lost_doppler[event.sv] = event.doppler;
+		}
+	}
+
+	/* Finished acquisitions, the channel comes back with the result */
+	while(read(Acq_2_Trak_P[READ], &result, sizeof(Acq_Command_M)) == sizeof(Acq_Command_M))
+	{
+		inflight--;
+
+		sv = result.sv;
+		memcpy(&result_history[sv], &result, sizeof(Acq_Command_M));
+		result_history[sv].sv = sv;
+
+		ProcessResult();
+	}
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
+/*!
+ * Hand the best SVs of the queue to the free channels, with up to gopt.acq_workers acquisitions in
+ * flight at once.
+ */
 void SV_Select::Acquire()
 {
-	int32 lcv, chan, already;
-
-	chan = 666;
-	already = 0;
+	int32 lcv, chan, active;
+	int32 busy[MAX_CHANNELS];
+	uint64 now;
 
 	IncStartTic();
 
-	/* If an empty channel exists, ask for an acquisition */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-		if(pChannels[lcv]->getActive() == 0)
-		{
-			chan = lcv;
-			break;
-		}
+	now = monotonic_ns();
 
-	sv_prediction[sv].tracked = false;
+	for(lcv = 0; lcv < NUM_CODES; lcv++)
+		sv_prediction[lcv].tracked = false;
 
-	/* If the SV is already being tracked skip the acquisition */
+	/* Which channels are tracking what */
 	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
 	{
 		pChannels[lcv]->Lock();
-		if(pChannels[lcv]->getActive())
-			if(pChannels[lcv]->getSV() == sv)
-			{
-				already = 666;
-				sv_prediction[sv].tracked = true;
-			}
+		active = pChannels[lcv]->getActive();
+		if(active)
+			sv_prediction[pChannels[lcv]->getSV()].tracked = true;
 		pChannels[lcv]->Unlock();
+
+		/* A detected SV holds its channel until the correlator starts it, or for SV_SELECT_HANDOFF ms */
+		if((chan_sv[lcv] != -1) && (chan_ns[lcv] != 0))
+			if(active || ((now - chan_ns[lcv]) > (uint64)SV_SELECT_HANDOFF*1000000))
+				chan_sv[lcv] = -1;
+
+		busy[lcv] = active || (chan_sv[lcv] != -1);
 	}
 
-	/* Update prediction if the SV is being tracked */
-	if((already == 666) || (chan == 666))
+	/* Run the SV prediction routine based on Almanac data, the queue is ordered by it */
+	for(lcv = 0; lcv < NUM_CODES; lcv++)
 	{
-		GetAlmanac(sv);
-		SV_Position(sv);
-		SV_LatLong(sv);
-		SV_Predict(sv);
-		UpdateState();
-		IncStopTic();
-		return;
+		GetAlmanac(lcv);
+		SV_Position(lcv);
+		SV_LatLong(lcv);
+		SV_Predict(lcv);
 	}
 
-	/* Run the SV prediction routine based on Almanac data */
-	GetAlmanac(sv);
-	SV_Position(sv);
-	SV_LatLong(sv);
-	SV_Predict(sv);
+	Prioritize(now);
+
+	chan = 0;
+	for(lcv = 0; (lcv < nqueue) && (inflight < gopt.acq_workers); lcv++)
+	{
+		while((chan < MAX_CHANNELS) && busy[chan])
+			chan++;
+
+		if(chan == MAX_CHANNELS)
+			break;
+
+		sv = queue[lcv];
+
+		if(Request(chan))
+		{
+			busy[chan] = true;
+			tried_ns[sv] = now;
+		}
+	}
 
 	IncStopTic();
 
-	/* Do something with acquisition */
-	if(chan != 666)
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Order the SVs that are neither tracked nor held by a channel, best first. SVs lost in the last
+ * SV_SELECT_LOST s come first, then the higher predicted elevation, then the longer since the last
+ * search, and every miss in a row puts an SV further back.
+ */
+void SV_Select::Prioritize(uint64 _now)
+{
+	int32 lcv, lcv2, held;
+	float pri, age;
+
+	nqueue = 0;
+	for(lcv = 0; lcv < NUM_CODES; lcv++)
 	{
-		/* Tell the acquisition what to try */
-		if(SetupRequest())
-		{
+		if(sv_prediction[lcv].tracked)
+			continue;
 
-			/* Send to the acquisition thread */
-			write(Trak_2_Acq_P[WRITE], &request, sizeof(Acq_Command_M));
+		held = false;
+		for(lcv2 = 0; lcv2 < MAX_CHANNELS; lcv2++)
+			if(chan_sv[lcv2] == lcv)
+				held = true;
 
-			/* Wait for acq to return, do stuff depending on the state */
-			read(Acq_2_Trak_P[READ], &result, sizeof(Acq_Command_M));
+		if(held)
+			continue;
 
-			memcpy(&result_history[sv], &result, sizeof(Acq_Command_M));
-			result_history[sv].sv = sv;
+		pri = 0;
 
-			/* Pass over channel */
-			result.chan = chan;
+		if(lost_ns[lcv] && ((_now - lost_ns[lcv]) < (uint64)SV_SELECT_LOST*1000000000))
+			pri += 4.0;
 
-			/* Do something! */
-			if(already != 666)
-				ProcessResult();
-		}
+		/* 0 to 2 from the horizon to overhead, nothing to go on without an almanac */
+		if(almanacs[lcv].decoded && (mode != COLD_START))
+			pri += 2.0*sin(sv_prediction[lcv].elev);
+
+		/* 0 to 1, never searched counts as the longest ago */
+		age = tried_ns[lcv] ? (float)((_now - tried_ns[lcv])/1000000)/1000.0 : 1e6;
+		pri += age/(age + 10.0);
 
-		UpdateState();
+		pri -= 0.25*((misses[lcv] < 4) ? misses[lcv] : 4);
+
+		priority[lcv] = pri;
+
+		/* Insertion sort, ties keep PRN order */
+		for(lcv2 = nqueue; (lcv2 > 0) && (priority[queue[lcv2-1]] < pri); lcv2--)
+			queue[lcv2] = queue[lcv2-1];
+		queue[lcv2] = lcv;
+		nqueue++;
 	}
 
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Send an acquisition of sv for _chan. False if the SV is not worth searching now (every type
+ * turned off for it, or predicted not visible).
+ */
+bool SV_Select::Request(int32 _chan)
+{
+
+	if(!SetupRequest())
+		return(false);
+
+	request.chan = _chan;
+	write(Trak_2_Acq_P[WRITE], &request, sizeof(Acq_Command_M));
+
+	chan_sv[_chan] = sv;
+	chan_ns[_chan] = 0;
+	inflight++;
+
+	return(true);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void SV_Select::Export()
 {
@@ -241,35 +356,62 @@ void SV_Select::Export()
 
 
 /*----------------------------------------------------------------------------------------------*/
+/*!
+ * One request goes up the whole ladder of types the SV is allowed, Acquisition::doAcqLadder()
+ * stops at the first that detects it. Types set to 2 are only for SVs whose Doppler is known.
+ */
 bool SV_Select::SetupRequest()
 {
 
 	SV_Prediction_M *ppred;
 	int32 doppler;
-	int32 acq_method;
+	int32 lcv;
+	bool lost, hot;
+
+	lost = lost_ns[sv] && ((monotonic_ns() - lost_ns[sv]) < (uint64)SV_SELECT_LOST*1000000000);
+	hot = lost || ((mode != COLD_START) && almanacs[sv].decoded);
 
 	/* Initialize parameters */
 	request.state = 1;
-	request.type = sv_history[sv].type;
+	request.type = ACQ_STRONG;
+	request.types = 0;
 	request.sv = sv;
 	request.mindopp = config.min_doppler;
 	request.maxdopp = config.max_doppler;
 	sv_history[sv].mindopp = config.min_doppler;
 	sv_history[sv].maxdopp = config.max_doppler;
 
-	acq_method = config.acq_method[request.type];
+	for(lcv = ACQ_STRONG; lcv <= ACQ_WEAK; lcv++)
+	{
+		if((config.acq_method[lcv] == 1) || ((config.acq_method[lcv] == 2) && hot))
+		{
+			request.types |= (1 << lcv);
+			request.type = lcv;
+		}
+	}
 
-	/* This type is turned off completely */
-	if(acq_method == 0)
+	/* Every type is turned off for it */
+	if(request.types == 0)
 		return(false);
 
-	if((mode == COLD_START) || (almanacs[sv].decoded == false))
+	/* Lost a moment ago, it is still close to where the channel left it */
+	if(lost)
 	{
-		/* This type is turned on for cold starts */
-		if(acq_method == 1)
-			return(true);
-		else
-			return(false);
+		doppler = (int32)lost_doppler[sv];
+		doppler = doppler - (doppler % 1000);
+
+		request.mindopp = (doppler - config.doppler_range);
+		request.maxdopp = (doppler + config.doppler_range);
+		sv_history[sv].mindopp = request.mindopp;
+		sv_history[sv].maxdopp = request.maxdopp;
+
+		return(true);
+	}
+
+	if(!hot)
+	{
+		/* The whole range, only the types turned on for cold starts */
+		return(true);
 	}
 	else
 	{
@@ -304,7 +446,8 @@ void SV_Select::ProcessResult()
 	int32 type;
 	Acq_History_S *psv;
 	psv = &sv_history[sv];
-	type = psv->type;
+	type = result.type;
+	psv->type = type;
 
 //	if((mode == HOT_START) && (almanacs[sv].decoded))
 //	{
@@ -321,37 +464,23 @@ void SV_Select::ProcessResult()
 	{
 		psv->successes[type]++;
 		write(Trak_2_Corr_P[result.chan][WRITE], &result, sizeof(Acq_Command_M));
+
+		/* Hold the channel until its correlator has started */
+		chan_ns[result.chan] = monotonic_ns();
+		misses[sv] = 0;
+		lost_ns[sv] = 0;
 	}
 	else
 	{
 		psv->failures[type]++;
+		chan_sv[result.chan] = -1;
+		misses[sv]++;
 	}
 
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
-/*----------------------------------------------------------------------------------------------*/
-void SV_Select::UpdateState()
-{
-
-	int32 type;
-	Acq_History_S *psv;
-
-	psv = &sv_history[sv];
-
-	psv->type++;
-	if(psv->type > ACQ_WEAK)
-		psv->type = ACQ_STRONG;
-
-	sv++;
-	if(sv >= NUM_CODES)
-		sv = 0;
-
-}
-/*----------------------------------------------------------------------------------------------*/
-
-
 /*----------------------------------------------------------------------------------------------*/
 void SV_Select::GetAlmanac(int32 _sv)
 {
@@ -54,7 +54,16 @@ class SV_Select : public Threaded_Object
 		SV_Select_2_Telem_S	output_s;						//!< Send predicted states to telemetry
 		int32				mode;							//!< SV select mode (COLD, WARM, HOT)
 		int32				sv;								//!< Current SV
-		int32				acq_ticks;
+		int32				inflight;						//!< Acquisitions sent and not answered yet
+		int32				chan_sv[MAX_CHANNELS];			//!< SV each channel is held for, -1 for none
+		uint64				chan_ns[MAX_CHANNELS];			//!< When its detection went to the correlator, 0 while the acquisition runs
+		int32				queue[NUM_CODES];				//!< Candidate SVs, best first
+		int32				nqueue;							//!< How many
+		float				priority[NUM_CODES];			//!< Of each SV, see Prioritize()
+		uint64				tried_ns[NUM_CODES];			//!< When each SV was last searched, 0 for never
+		uint64				lost_ns[NUM_CODES];				//!< When a channel with bit lock last lost it, 0 for never
+		float				lost_doppler[NUM_CODES];		//!< Its Doppler then
+		int32				misses[NUM_CODES];				//!< Failed acquisitions in a row
 		float				mask_angle;						//!< Elevation mask angle
 
 	public:
@@ -62,11 +71,12 @@ class SV_Select : public Threaded_Object
 		SV_Select();
 		~SV_Select();
 		void Start();								//!< Start the thread
-		void Import();								//!< Get data into the thread
+		void Import();								//!< Wait for an event and take in the results, lost SVs & PVT
 		void Export();								//!< Get data out of the thread
 
- 		void UpdateState();							//!< Update acq type
- 		void Acquire();								//!< Run the acquisition
+ 		void Acquire();								//!< Send the best SVs to the free channels
+		void Prioritize(uint64 _now);				//!< Order the queue
+		bool Request(int32 _chan);					//!< Send an acquisition of sv for this channel
 		void GetAlmanac(int32 _sv);					//!< Get the most up-to-date almanacs from the ephemeris
 
 		void SV_Predict(int32 _sv);					//!< Predict states of SVs
@@ -78,6 +88,7 @@ class SV_Select : public Threaded_Object
 
 		void setConfig(Acq_Config_M *_cfg);			//!< Set the acquisition behaviour
 		Acq_Config_M getConfig(){return(config);};	//!< Return the acquisition behaviour
+		int32 getMode(){return(mode);};				//!< COLD_START, WARM_START or HOT_START
 		SV_Prediction_M getSVPrediction(int32 _sv){return(sv_prediction[_sv]);};	//!< Return given SV predicition
 		Acq_Command_M getAcqCommand(int32 _sv){return(result_history[_sv]);};		//!< Return acquisition result per sv
 
@@ -48,7 +48,7 @@ void *Telemetry_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Telemetry::Start()
 {
-	/* With new priority specified */
+	/* With priority/affinity given by Set_Scheduling() */
 	Start_Thread(Telemetry_Thread, NULL);
 
 	if(gopt.verbose)
@@ -61,7 +61,7 @@ void Telemetry::Start()
 Telemetry::Telemetry()
 {
 
-	execution_tic = start_tic = stop_tic = 0;
+	execution_tic = 0;
 	display = 0;
 	count = 0;
 
@@ -217,6 +217,7 @@ void Telemetry::UpdateScreen()
 
 	mvwprintw(screen,line,1,"                                                                               ");
 	mvwprintw(screen,line++,1,"FIFO:\t%d\t%d\t%d\t%d",(FIFO_DEPTH-(tFIFO.head-tFIFO.tail)) % FIFO_DEPTH,tFIFO.count,tFIFO.agc_scale,tFIFO.overflw);
+	mvwprintw(screen,line++,1,"Gaps:\t%d\t%d ms\tmax %d ms\tjumps %d",tFIFO.gaps,tFIFO.gap_ms,tFIFO.max_gap,tFIFO.jumps);
 
 	Lock();
 
@@ -284,7 +285,7 @@ void Telemetry::PrintChan()
 			strcpy(buff, "---------");
 
 			/*Flag buffer*/
-			buff[0] = ' ';
+			((int32)p->state == CHANNEL_COAST) ? buff[0] = 'C' : (((int32)p->el_every > 1) ? buff[0] = 'R' : buff[0] = ' ');
 			((int32)p->bit_lock)   ? buff[1] = 'B'  : buff[1] = '-';
 			((int32)p->frame_lock) ? buff[2] = 'F'  : buff[2] = '-';
 			(pNav->nsvs >> lcv) & 0x1 ? buff[3] = 'N'  : buff[3] = '-';
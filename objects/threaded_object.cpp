@@ -25,7 +25,94 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 /*----------------------------------------------------------------------------------------------*/
 void Threaded_Object::Start_Thread(void *(*_start_routine)(void*), void *_arg)
 {
-	pthread_create(&thread, NULL, _start_routine, _arg);
+	pthread_attr_t attr;
+	struct sched_param param;
+	cpu_set_t cpus;
+	int32 ret;
+
+	pthread_attr_init(&attr);
+
+	/* Pin the thread, keeps it (and its memory) on one NUMA node */
+	if(cpu >= 0)
+	{
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpus);
+	}
+
+	/* Otherwise the thread inherits the scheduler of main() */
+	if(sched_policy == SCHED_FIFO)
+	{
+		param.sched_priority = sched_priority;
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		pthread_attr_setschedparam(&attr, &param);
+	}
+
+	ret = pthread_create(&thread, &attr, _start_routine, _arg);
+
+	/* Not root (or no CAP_SYS_NICE), drop back to the default scheduler but keep the affinity */
+	if((ret == EPERM) && (sched_policy == SCHED_FIFO))
+	{
+		printf("Could not get SCHED_FIFO priority %d, running with SCHED_OTHER\n", sched_priority);
+
+		sched_policy = SCHED_OTHER;
+		sched_priority = 0;
+		pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+		ret = pthread_create(&thread, &attr, _start_routine, _arg);
+	}
+
+	if(ret)
+		printf("pthread_create failed: %s\n", strerror(ret));
+
+	pthread_attr_destroy(&attr);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Threaded_Object::Set_Scheduling(int32 _policy, int32 _priority, int32 _cpu)
+{
+	int32 ncpus;
+
+	if(_policy == SCHED_FIFO)
+	{
+		sched_policy = SCHED_FIFO;
+		sched_priority = _priority;
+
+		if(sched_priority < sched_get_priority_min(SCHED_FIFO))
+			sched_priority = sched_get_priority_min(SCHED_FIFO);
+
+		if(sched_priority > sched_get_priority_max(SCHED_FIFO))
+			sched_priority = sched_get_priority_max(SCHED_FIFO);
+	}
+	else
+	{
+		sched_policy = SCHED_OTHER;
+		sched_priority = 0;
+	}
+
+	/* Ignore CPUs that do not exist */
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if((_cpu >= 0) && (_cpu < ncpus) && (_cpu < CPU_SETSIZE))
+	{
+		cpu = _cpu;
+		node = cpu_node(cpu);
+	}
+	else
+	{
+		cpu = -1;
+		node = -1;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+uint32 Threaded_Object::GetSched()
+{
+	return(((sched_policy & 0xff) << 24) | ((sched_priority & 0xff) << 16) | ((node & 0xff) << 8) | (cpu & 0xff));
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -44,8 +131,15 @@ Threaded_Object::Threaded_Object()
 	pthread_mutex_init(&mutex, NULL);
 	pthread_mutex_unlock(&mutex);
 	execution_tic = 0;
-	start_tic = 0;
-	stop_tic = 0;
+	start_ns = 0;
+	stop_ns = 0;
+	hproc.Clear();
+	hwait.Clear();
+	hlag.Clear();
+	sched_policy = SCHED_OTHER;
+	sched_priority = 0;
+	cpu = -1;
+	node = -1;
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -61,8 +155,10 @@ Threaded_Object::~Threaded_Object()
 /*----------------------------------------------------------------------------------------------*/
 void Threaded_Object::IncStartTic()
 {
-	gettimeofday(&tv, NULL);
-    start_tic = 100*(tv.tv_sec - starttime.tv_sec) + (tv.tv_usec - starttime.tv_usec)/10000;
+	start_ns = monotonic_ns();
+
+	if(stop_ns)
+		hwait.Add(start_ns - stop_ns);
 };
 /*----------------------------------------------------------------------------------------------*/
 
@@ -70,8 +166,24 @@ void Threaded_Object::IncStartTic()
 /*----------------------------------------------------------------------------------------------*/
 void Threaded_Object::IncStopTic()
 {
-	gettimeofday(&tv, NULL);
-    stop_tic = 100*(tv.tv_sec - starttime.tv_sec) + (tv.tv_usec - starttime.tv_usec)/10000;
+	/* Some tasks have more than one exit point, only log the first */
+	if(start_ns > stop_ns)
+	{
+		stop_ns = monotonic_ns();
+		hproc.Add(stop_ns - start_ns);
+	}
 };
 /*----------------------------------------------------------------------------------------------*/
 
+
+/*----------------------------------------------------------------------------------------------*/
+void Threaded_Object::IncLag(uint64 _stamp)
+{
+	uint64 now;
+
+	now = monotonic_ns();
+	if(_stamp && (now > _stamp))
+		hlag.Add(now - _stamp);
+};
+/*----------------------------------------------------------------------------------------------*/
+
@@ -38,11 +38,17 @@ class Threaded_Object
 		/* Default object variables */
 		uint32				pid;			//!< Pid value
 		uint32 				execution_tic;	//!< Execution counter
-		uint32 				start_tic;		//!< OS tic at start of function
-		uint32 				stop_tic;		//!< OS tic at end of function
+		uint64 				start_ns;		//!< Monotonic time at start of function
+		uint64 				stop_ns;		//!< Monotonic time at end of function
 		pthread_t 			thread;			//!< For the thread
 		pthread_mutex_t		mutex;			//!< Protect the following variable
-		struct timeval 		tv;				//!< To time the threads
+		Histogram			hproc;			//!< Processing time, IncStartTic() to IncStopTic()
+		Histogram			hwait;			//!< Waiting time, IncStopTic() to the next IncStartTic()
+		Histogram			hlag;			//!< Age of the IF data when it is processed
+		int32				sched_policy;	//!< SCHED_OTHER or SCHED_FIFO
+		int32				sched_priority;	//!< Realtime priority, only used with SCHED_FIFO
+		int32				cpu;			//!< Pin the thread to this CPU, -1 to let the OS migrate it
+		int32				node;			//!< NUMA node of the pinned CPU, -1 if unknown
 	public:
 
 		/* Default object methods */
@@ -50,6 +56,7 @@ class Threaded_Object
 		~Threaded_Object();										//!< Destructor
 
 		void Start_Thread(void *(*_start_routine)(void*), void *_arg);	//!< Start the thread
+		void Set_Scheduling(int32 _policy, int32 _priority, int32 _cpu);	//!< Set policy/priority/affinity, call before Start_Thread
 		void Stop();											//!< Stop the thread
 		void Lock(){pthread_mutex_lock(&mutex);};				//!< Lock the object's mutex
 		void Unlock(){pthread_mutex_unlock(&mutex);};			//!< Unlock the object's mutex
@@ -58,12 +65,16 @@ class Threaded_Object
 		uint32 GetPid(){return(pid);};							//!< Get the pid
 
 		uint32 GetExecTic(){return(execution_tic);};			//!< Get the execution counter
-		uint32 GetStartTic(){return(start_tic);};				//!< Get the Nucleus tic at start of function
-		uint32 GetStopTic(){return(stop_tic);};					//!< Get the Nucleus tic at	end of function
+		Histogram *GetProc(){return(&hproc);};					//!< Get the processing time histogram
+		Histogram *GetWait(){return(&hwait);};					//!< Get the waiting time histogram
+		Histogram *GetLag(){return(&hlag);};					//!< Get the data age histogram
+		uint32 GetSched();										//!< Get the packed scheduling info for the task health message
+		int32 GetNode(){return(node);};							//!< Get the NUMA node the thread runs on
 
 		void IncExecTic(){execution_tic++;};					//!< Increment execution tic
-		void IncStartTic();										//!< Use OS method to set the start tic
-		void IncStopTic();										//!< Use OS method to set the stop tic
+		void IncStartTic();										//!< Mark the start of processing, logs the waiting time
+		void IncStopTic();										//!< Mark the end of processing, logs the processing time
+		void IncLag(uint64 _stamp);								//!< Log the age of data enqueued at monotonic time _stamp
 
 };
 
@@ -0,0 +1,669 @@
+/*! \file track-bench.cpp
+	Benchmark the FIFO->Correlator->Channel path, find the maximum sustainable channel count
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#define GLOBALS_HERE
+
+#include "includes.h"
+
+#define BENCH_LOOP_MS		(1000)		//!< Length of the IF buffer that is looped through the pipe (ms)
+#define BENCH_WARMUP_MS		(1000)		//!< FIFO runs AGC only for the first 1000 ms
+#define BENCH_LEAD			(2)			//!< Packets the FIFO runs ahead of the correlators
+#define BENCH_NOISE_SIGMA	(256.0)		//!< Noise sigma (per I/Q component) of the synthetic IF
+
+/*! \ingroup STRUCTS
+ * Options for the tracking benchmark
+ */
+typedef struct _Track_Bench_Options
+{
+	int32 ms_per_step;		//!< Milliseconds of signal to run at each channel count
+	int32 max_channels;		//!< Step up to this many active channels
+	double cn0;				//!< C/N0 of the synthetic SVs (dB-Hz)
+	int32 corr_delays;		//!< Multipath taps (plus-minus) per correlator
+	float corr_spacing;		//!< Spacing of the multipath taps (chips)
+	int32 if_bits;			//!< Correlate on a 1 or 2 bit IF, 0 for int16
+	int32 block_ms;			//!< ms per FIFO packet
+	int32 stall_ms;			//!< Stall the correlators this long halfway through every step, 0 for none
+	int32 fade_ms;			//!< Replace the signal with noise this long halfway through every step, 0 for none
+	int32 coast_ms;			//!< Channels coast this long after losing the signal
+	int32 loops;			//!< Run the channels on the tracking thread
+	int32 batch;			//!< And batch their loops through the Loop_Bank
+	int32 reduce;			//!< Early & late every this many ms on strong channels, 0 for off
+	int32 record;			//!< Record the correlators for corr-replay
+	char filename[1024]; 	//!< Use recorded IF instead of the synthetic signal
+} Track_Bench_Options;
+
+/*! \ingroup STRUCTS
+ * Results of one step
+ */
+typedef struct _Track_Bench_Step
+{
+	int32 channels;			//!< Active channels
+	int32 restarts;			//!< Channels that were killed and had to be restarted
+	double wall;			//!< Wall time (s)
+	double fifo;			//!< FIFO CPU time (s)
+	double corr;			//!< Correlator CPU time, including the channels (s)
+	double chan;			//!< Channel time (s), on the tracking thread with -loops
+} Track_Bench_Step;
+
+CPX 			*if_data;			//!< IF buffer looped through the pipe
+CPX 			*if_noise;			//!< Same length, noise only (-fade)
+volatile int32	fade;				//!< ms of if_noise the writer still has to send
+int32			if_ms;				//!< Length of the above (ms)
+int32			nimport;			//!< Number of ms pulled through the FIFO
+Acq_Command_M 	bench_acq[MAX_CHANNELS];	//!< Commands used to start the channels
+
+/*----------------------------------------------------------------------------------------------*/
+void bench_usage(char *_str)
+{
+
+    fprintf(stderr, "usage: [-t] [-n] [-c] [-f] [-taps] [-bits] [-block] [-stall] [-fade] [-coast] [-loops] [-batch] [-reduce] [-record]\n");
+    fprintf(stderr, "[-t] <ms> signal processed at each channel count (default 10000)\n");
+    fprintf(stderr, "[-n] <N> step up to N active channels (default MAX_CHANNELS)\n");
+    fprintf(stderr, "[-c] <dB-Hz> C/N0 of the synthetic signal (default 45)\n");
+    fprintf(stderr, "[-f] <filename> use recorded IF instead of the synthetic signal\n");
+    fprintf(stderr, "[-taps] <N> <spacing> run N multipath taps (plus-minus) on every channel\n");
+    fprintf(stderr, "[-bits] <1|2> correlate on a 1 or 2 bit IF\n");
+    fprintf(stderr, "[-block] <N> ms per FIFO packet (1-%d, default 1)\n", FIFO_MAX_BLOCK);
+    fprintf(stderr, "[-stall] <ms> stop the correlators this long halfway through every step, past %d ms the FIFO overflows\n", FIFO_DEPTH);
+    fprintf(stderr, "[-fade] <ms> replace the signal with noise this long halfway through every step\n");
+    fprintf(stderr, "[-coast] <ms> channels coast this long after losing the signal, 0 kills them (default %d)\n", COAST_MS);
+    fprintf(stderr, "[-loops] run the channels on the tracking thread, the correlators only queue their dumps\n");
+    fprintf(stderr, "[-batch] as -loops, with the PLL/DLL of the channels run together through the loop bank\n");
+    fprintf(stderr, "[-reduce] <N> strong channels correlate early & late only every N ms, as gps-sdr -reduce\n");
+    fprintf(stderr, "[-record] record the correlators to corrNN.rec, see corr-replay\n");
+    fflush(stderr);
+
+    exit(1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! CPU time used by the calling thread, in ns */
+uint64 thread_cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+	return((uint64)ts.tv_sec*1000000000ULL + (uint64)ts.tv_nsec);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Gaussian noise, Box-Muller */
+double bench_randn(void)
+{
+	double u1, u2;
+
+	u1 = ((double)rand() + 1.0)/((double)RAND_MAX + 2.0);
+	u2 = ((double)rand() + 1.0)/((double)RAND_MAX + 2.0);
+
+	return(sqrt(-2.0*log(u1))*cos(TWO_PI*u2));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Synthesize MAX_CHANNELS SVs plus noise. All SVs sit at zero Doppler, so every ms of signal
+ * is identical (except the noise) and the buffer can be looped without a phase jump. A carrier
+ * Doppler without the matching code Doppler would walk the DLL off the peak, and the
+ * correlation cost does not depend on the Doppler anyway.
+ * */
+void bench_synthetic(double _cn0)
+{
+	CPX code[CODE_CHIPS];
+	CPX carrier[SAMPS_MS];
+	float *sig_i, *sig_q;
+	double amp;
+	int32 lcv, lcv2, sv, chip;
+	int32 doppler, delay;
+
+	sig_i = new float[SAMPS_MS];
+	sig_q = new float[SAMPS_MS];
+	memset(sig_i, 0x0, SAMPS_MS*sizeof(float));
+	memset(sig_q, 0x0, SAMPS_MS*sizeof(float));
+
+	/* C/N0 = A^2/(2*sigma^2)*fs */
+	amp = BENCH_NOISE_SIGMA*sqrt(2.0*pow(10.0, _cn0/10.0)/(double)SAMPLE_FREQUENCY);
+
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		sv = lcv;
+		doppler = 0;
+		delay = (100 + 83*lcv) % CODE_CHIPS;
+
+		code_gen(&code[0], sv);
+		sine_gen(&carrier[0], IF_FREQUENCY + doppler, SAMPLE_FREQUENCY, SAMPS_MS);
+
+		for(lcv2 = 0; lcv2 < SAMPS_MS; lcv2++)
+		{
+			chip = (int32)floor((double)delay + (double)lcv2*CODE_RATE/(double)SAMPLE_FREQUENCY) % CODE_CHIPS;
+			if(code[chip].i)
+			{
+				sig_i[lcv2] -= amp*carrier[lcv2].i/16383.0;
+				sig_q[lcv2] -= amp*carrier[lcv2].q/16383.0;
+			}
+			else
+			{
+				sig_i[lcv2] += amp*carrier[lcv2].i/16383.0;
+				sig_q[lcv2] += amp*carrier[lcv2].q/16383.0;
+			}
+		}
+
+		/* The result an acquisition would have returned */
+		memset(&bench_acq[lcv], 0x0, sizeof(Acq_Command_M));
+		bench_acq[lcv].chan = lcv;
+		bench_acq[lcv].sv = sv;
+		bench_acq[lcv].type = ACQ_STRONG;
+		bench_acq[lcv].success = 1;
+		bench_acq[lcv].delay = delay;
+		bench_acq[lcv].doppler = doppler;
+	}
+
+	if_ms = BENCH_LOOP_MS;
+	if_data = new CPX[if_ms*SAMPS_MS];
+
+	for(lcv = 0; lcv < if_ms; lcv++)
+		for(lcv2 = 0; lcv2 < SAMPS_MS; lcv2++)
+		{
+			if_data[lcv*SAMPS_MS + lcv2].i = (int16)floor(sig_i[lcv2] + BENCH_NOISE_SIGMA*bench_randn() + 0.5);
+			if_data[lcv*SAMPS_MS + lcv2].q = (int16)floor(sig_q[lcv2] + BENCH_NOISE_SIGMA*bench_randn() + 0.5);
+		}
+
+	delete [] sig_i;
+	delete [] sig_q;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Load up to BENCH_LOOP_MS of a recording, the channels are started on arbitrary SVs */
+int32 bench_recorded(char *_filename)
+{
+	FILE *fp;
+	int32 lcv;
+
+	fp = fopen(_filename, "rb");
+	if(fp == NULL)
+	{
+		printf("Could not open %s for reading\n", _filename);
+		return(false);
+	}
+
+	if_data = new CPX[BENCH_LOOP_MS*SAMPS_MS];
+	if_ms = fread(if_data, SAMPS_MS*sizeof(CPX), BENCH_LOOP_MS, fp);
+	fclose(fp);
+
+	if(if_ms < 1)
+	{
+		printf("%s is empty\n", _filename);
+		return(false);
+	}
+
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		memset(&bench_acq[lcv], 0x0, sizeof(Acq_Command_M));
+		bench_acq[lcv].chan = lcv;
+		bench_acq[lcv].sv = lcv;
+		bench_acq[lcv].type = ACQ_STRONG;
+		bench_acq[lcv].success = 1;
+		bench_acq[lcv].delay = (100 + 83*lcv) % CODE_CHIPS;
+	}
+
+	return(true);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Noise only version of if_data, for -fade */
+void bench_noise(void)
+{
+	int32 lcv;
+
+	if_noise = new CPX[if_ms*SAMPS_MS];
+
+	for(lcv = 0; lcv < if_ms*SAMPS_MS; lcv++)
+	{
+		if_noise[lcv].i = (int16)floor(BENCH_NOISE_SIGMA*bench_randn() + 0.5);
+		if_noise[lcv].q = (int16)floor(BENCH_NOISE_SIGMA*bench_randn() + 0.5);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Stand in for the USRP/Post_Process, feed the named pipe as fast as the FIFO reads it */
+void *Bench_Writer_Thread(void *_arg)
+{
+	int32 npipe;
+	int32 ms;
+
+	npipe = open("/tmp/GPSPIPE", O_WRONLY);
+
+	ms = 0;
+	while(grun)
+	{
+		if(fade > 0)
+		{
+			write(npipe, &if_noise[ms*SAMPS_MS], SAMPS_MS*sizeof(CPX));
+			fade--;
+		}
+		else
+			write(npipe, &if_data[ms*SAMPS_MS], SAMPS_MS*sizeof(CPX));
+		ms = (ms + 1) % if_ms;
+	}
+
+	close(npipe);
+
+	pthread_exit(0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Start the channel, exactly as SV_Select does after a successful acquisition */
+void bench_start(int32 _chan)
+{
+	bench_acq[_chan].count = nimport;
+	write(Trak_2_Corr_P[_chan][WRITE], &bench_acq[_chan], sizeof(Acq_Command_M));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Pull one packet through the FIFO and all the correlators, in lockstep on this thread */
+void bench_ms(Track_Bench_Step *_step)
+{
+	int32 lcv;
+	uint64 t0, t1, t2;
+
+	t0 = thread_cpu_ns();
+
+	pFIFO->Import();
+	nimport += gopt.block_ms;
+
+	t1 = thread_cpu_ns();
+
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		pCorrelators[lcv]->Import();
+		pCorrelators[lcv]->Correlate();
+	}
+
+	t2 = thread_cpu_ns();
+
+	_step->fifo += (double)(t1 - t0)*1e-9;
+	_step->corr += (double)(t2 - t1)*1e-9;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Overload: keep reading the pipe for _ms without correlating, as if the correlators had been
+ * starved of CPU. Once the FIFO fills the rest is dropped, then the correlators work off the
+ * backlog and carry on with the same lead as before. Returns the wall time it took (ns).
+ */
+uint64 bench_stall(int32 _ms)
+{
+	int32 lcv, lcv2, held, depth;
+	uint64 start;
+
+	start = monotonic_ns();
+
+	/* One unread packet between the correlators and the FIFO's head, at most depth-1 */
+	depth = FIFO_DEPTH/gopt.block_ms;
+	held = 1;
+
+	for(lcv = 0; lcv < _ms; lcv += gopt.block_ms)
+	{
+		pFIFO->Import();
+		nimport += gopt.block_ms;
+		if(held < depth - 1)
+			held++;
+	}
+
+	for(lcv = 1; lcv < held; lcv++)
+		for(lcv2 = 0; lcv2 < MAX_CHANNELS; lcv2++)
+		{
+			pCorrelators[lcv2]->Import();
+			pCorrelators[lcv2]->Correlate();
+		}
+
+	return(monotonic_ns() - start);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void bench_step(Track_Bench_Options *_opt, Track_Bench_Step *_step)
+{
+	int32 lcv, half;
+	uint64 start, stop, stall;
+
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	{
+		pChannels[lcv]->GetProc()->Clear();
+		pCorrelators[lcv]->GetProc()->Clear();
+	}
+
+	half = (_opt->ms_per_step/(2*gopt.block_ms))*gopt.block_ms;
+	stall = 0;
+
+	start = monotonic_ns();
+
+	for(lcv = 0; lcv < _opt->ms_per_step; lcv += gopt.block_ms)
+	{
+		/* Not counted in the timing */
+		if(_opt->stall_ms && (lcv == half))
+			stall += bench_stall(_opt->stall_ms);
+
+		/* The writer is a pipe's worth ahead, close enough */
+		if(_opt->fade_ms && (lcv == half))
+			fade = _opt->fade_ms;
+
+		bench_ms(_step);
+
+		/* Keep the load constant, restart any channel that lost lock, every 100 ms */
+		if((lcv / 100) != ((lcv + gopt.block_ms) / 100))
+		{
+			for(int32 lcv2 = 0; lcv2 < _step->channels; lcv2++)
+			{
+				if(pChannels[lcv2]->getActive() == false)
+				{
+					bench_start(lcv2);
+					_step->restarts++;
+				}
+			}
+		}
+	}
+
+	stop = monotonic_ns();
+
+	_step->wall = (double)(stop - start - stall)*1e-9;
+
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		_step->chan += (double)pChannels[lcv]->GetProc()->GetSum()*1e-9;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int main(int32 argc, char* argv[])
+{
+	int32 lcv, nsteps;
+	Track_Bench_Options opt;
+	Track_Bench_Step steps[MAX_CHANNELS+1];
+	Track_Bench_Step *s;
+	pthread_t writer;
+	double per_ms, per_chan, fifo_ms, corr_ms, signal, in_corr;
+	int32 full, late;
+	FIFO_M telem;
+	Histogram *h;
+
+	printf("Track_Bench\n");
+
+	/* Set default options */
+	opt.ms_per_step = 10000;
+	opt.max_channels = MAX_CHANNELS;
+	opt.cn0 = 45.0;
+	opt.filename[0] = '\0';
+	opt.corr_delays = 0;
+	opt.corr_spacing = CORR_SPACING;
+	opt.if_bits = 0;
+	opt.block_ms = 1;
+	opt.stall_ms = 0;
+	opt.fade_ms = 0;
+	opt.coast_ms = COAST_MS;
+	opt.loops = false;
+	opt.batch = false;
+	opt.reduce = 0;
+	opt.record = false;
+
+	for(lcv = 1; lcv < argc; lcv++)
+	{
+		if(!strcmp(argv[lcv], "-t") && (lcv+1 < argc))
+			opt.ms_per_step = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-n") && (lcv+1 < argc))
+			opt.max_channels = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-c") && (lcv+1 < argc))
+			opt.cn0 = atof(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-f") && (lcv+1 < argc))
+			strcpy(opt.filename, argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-bits") && (lcv+1 < argc))
+			opt.if_bits = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-block") && (lcv+1 < argc))
+			opt.block_ms = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-stall") && (lcv+1 < argc))
+			opt.stall_ms = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-fade") && (lcv+1 < argc))
+			opt.fade_ms = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-coast") && (lcv+1 < argc))
+			opt.coast_ms = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-loops"))
+			opt.loops = true;
+		else if(!strcmp(argv[lcv], "-batch"))
+			opt.loops = opt.batch = true;
+		else if(!strcmp(argv[lcv], "-reduce") && (lcv+1 < argc))
+			opt.reduce = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-record"))
+			opt.record = true;
+		else if(!strcmp(argv[lcv], "-taps") && (lcv+2 < argc))
+		{
+			opt.corr_delays = atoi(argv[++lcv]);
+			opt.corr_spacing = atof(argv[++lcv]);
+		}
+		else
+			bench_usage(argv[0]);
+	}
+
+	if((opt.max_channels < 1) || (opt.max_channels > MAX_CHANNELS) || (opt.ms_per_step < 100))
+		bench_usage(argv[0]);
+
+	if((opt.if_bits < 0) || (opt.if_bits > 2))
+		bench_usage(argv[0]);
+
+	if((opt.block_ms < 1) || (opt.block_ms > FIFO_MAX_BLOCK) || (opt.stall_ms < 0) || (opt.fade_ms < 0) || (opt.coast_ms < 0))
+		bench_usage(argv[0]);
+
+	/* Whole packets per step */
+	opt.ms_per_step = ((opt.ms_per_step + opt.block_ms - 1)/opt.block_ms)*opt.block_ms;
+
+	if((opt.corr_delays < 0) || (opt.corr_delays > CORR_MAX_DELAYS) || (opt.corr_spacing <= 0) || (opt.corr_delays*opt.corr_spacing > CORR_MAX_SPAN))
+		bench_usage(argv[0]);
+
+	/* Receiver options, no logging and no sleeping */
+	memset(&gopt, 0x0, sizeof(Options_S));
+	gopt.corr_sleep = 10;
+	gopt.pin_cpu = -1;
+	gopt.corr_delays = opt.corr_delays;
+	gopt.corr_spacing = opt.corr_spacing;
+	gopt.if_bits = opt.if_bits;
+	gopt.block_ms = opt.block_ms;
+	gopt.coast_ms = opt.coast_ms;
+	gopt.loop_thread = opt.loops;
+	gopt.loop_batch = opt.batch;
+	gopt.reduce_el = opt.reduce;
+	gopt.corr_record = opt.record;
+	grun = 0x1;
+
+	Init_SIMD();
+
+	if(strlen(opt.filename))
+	{
+		if(bench_recorded(opt.filename) == false)
+			return(-1);
+	}
+	else
+		bench_synthetic(opt.cn0);
+
+	if(opt.fade_ms)
+		bench_noise();
+
+	/* Nobody reads the outputs, do not let them block */
+	Pipes_Init();
+	fcntl(FIFO_2_Telem_P[WRITE], F_SETFL, O_NONBLOCK);
+	fcntl(FIFO_2_PVT_P[WRITE], F_SETFL, O_NONBLOCK);
+	fcntl(Chan_2_Ephem_P[WRITE], F_SETFL, O_NONBLOCK);
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		fcntl(Corr_2_PVT_P[lcv][WRITE], F_SETFL, O_NONBLOCK);
+
+	/* The real objects */
+	pFIFO = new FIFO;
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		pChannels[lcv] = new Channel(lcv);
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		pCorrelators[lcv] = new Correlator(lcv);
+
+	/* Unscheduled, it runs wherever the OS puts it */
+	if(opt.loops)
+	{
+		pTracking = new Tracking;
+		pTracking->Start();
+	}
+
+	mkfifo("/tmp/GPSPIPE", S_IRWXU | S_IRWXG | S_IRWXO);
+	pthread_create(&writer, NULL, Bench_Writer_Thread, NULL);
+	pFIFO->Open();
+
+	/* Let the AGC settle, and get a couple of packets ahead of the correlators */
+	while(nimport < BENCH_WARMUP_MS)
+	{
+		pFIFO->Import();
+		nimport += opt.block_ms;
+	}
+
+	for(lcv = 0; lcv < BENCH_LEAD; lcv++)
+	{
+		pFIFO->Import();
+		nimport += opt.block_ms;
+	}
+
+	printf("Signal: %s, %d ms looped, %d ms per step, %d ms packets%s\n\n", strlen(opt.filename) ? opt.filename : "synthetic", if_ms, opt.ms_per_step, opt.block_ms,
+		opt.batch ? ", batched loops on the tracking thread" : (opt.loops ? ", loops on the tracking thread" : ""));
+	printf("%5s %10s %10s %10s %10s %10s %10s %9s\n", "chans", "ms/s", "x realtime", "fifo us/ms", "corr us/ms", "chan us/ms", "headroom", "restarts");
+	printf("-----------------------------------------------------------------------------------------\n");
+
+	/* Step 0 is the FIFO and correlator overhead with no active channels */
+	nsteps = 0;
+	for(lcv = 0; lcv <= opt.max_channels; lcv++)
+	{
+		s = &steps[nsteps++];
+		memset(s, 0x0, sizeof(Track_Bench_Step));
+		s->channels = lcv;
+
+		if(lcv > 0)
+			bench_start(lcv-1);
+
+		bench_step(&opt, s);
+
+		/* With -loops the channel time is on the tracking thread, not inside the correlators' */
+		signal = (double)opt.ms_per_step;
+		in_corr = opt.loops ? 0 : s->chan;
+		per_ms = 1e6*(s->fifo + s->corr + s->chan - in_corr)/signal;
+
+		printf("%5d %10.0f %10.2f %10.2f %10.2f %10.2f %9.1f%% %9d\n",
+			s->channels,
+			signal/s->wall,
+			signal/(1000.0*s->wall),
+			1e6*s->fifo/signal,
+			1e6*(s->corr - in_corr)/signal,
+			1e6*s->chan/signal,
+			100.0*(1.0 - per_ms/1000.0),
+			s->restarts);
+		fflush(stdout);
+	}
+
+	/* Marginal cost of a channel from the first and last step */
+	s = &steps[nsteps-1];
+	fifo_ms = 1e6*steps[0].fifo/(double)opt.ms_per_step;
+	corr_ms = 1e6*steps[0].corr/(double)opt.ms_per_step;
+	per_chan = 1e6*(s->corr - steps[0].corr)/(double)opt.ms_per_step;
+	per_chan /= (s->channels > 0) ? s->channels : 1;
+
+	if(per_chan > 0)
+	{
+		/* Everything on one core, or the correlators spread over CPU_CORES with the FIFO elsewhere (see Sched_Init) */
+		printf("\nPer channel:\t\t\t\t%.2f us/ms\n", per_chan);
+		printf("Max sustainable channels, 1 core:\t%d\n", (int32)floor((1000.0 - fifo_ms - corr_ms)/per_chan));
+		printf("Max sustainable channels, %d cores:\t%d\n", CPU_CORES, (int32)floor((CPU_CORES*1000.0 - corr_ms)/per_chan));
+	}
+
+	/* The correlator's per packet time in the last step, the loops run inside it without -loops */
+	h = pCorrelators[0]->GetProc();
+	printf("\nCorrelator 0 per packet:\t\tp50 %.2f us, p99 %.2f us, max %.2f us\n",
+		(double)h->Percentile(50.0)*1e-3, (double)h->Percentile(99.0)*1e-3, (double)h->GetMax()*1e-3);
+
+	if(opt.loops)
+	{
+		full = late = 0;
+		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		{
+			full += pCorrelators[lcv]->getLoopFull();
+			late += pCorrelators[lcv]->getLoopLate();
+		}
+		printf("Loop queues:\t\t\t\t%d dumps dropped, %d late feedbacks\n", full, late);
+	}
+
+	if(opt.reduce)
+	{
+		full = 0;
+		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+			full += pChannels[lcv]->getActive() && (pChannels[lcv]->getPacket().el_every > 1);
+		printf("Reduced rate:\t\t\t\t%d of %d channels\n", full, s->channels);
+	}
+
+	if(opt.stall_ms)
+	{
+		telem = pFIFO->getTelem();
+		printf("\nFIFO gaps:\t\t\t\t%d, %d ms dropped, longest %d ms\n", telem.gaps, telem.gap_ms, telem.max_gap);
+	}
+
+	grun = 0x0;
+	pthread_cancel(writer);
+	pthread_join(writer, NULL);
+
+	if(opt.loops)
+	{
+		pTracking->Stop();
+		delete pTracking;
+	}
+
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		delete pCorrelators[lcv];
+	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		delete pChannels[lcv];
+	delete pFIFO;
+
+	Pipes_Shutdown();
+
+	return(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
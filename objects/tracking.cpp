@@ -0,0 +1,140 @@
+/*! \file Tracking.cpp
+	Implements member functions of Tracking class.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#include "tracking.h"
+
+/*----------------------------------------------------------------------------------------------*/
+void *Tracking_Thread(void *_arg)
+{
+
+	Tracking *aTracking = pTracking;
+
+	aTracking->SetPid();
+
+	while(grun)
+	{
+		aTracking->Import();
+		aTracking->IncExecTic();
+	}
+
+	pthread_exit(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Tracking::Start()
+{
+	Start_Thread(Tracking_Thread, NULL);
+
+	if(gopt.verbose)
+		printf("Tracking thread started\n");
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Tracking::Tracking()
+{
+	dumps = 0;
+
+	if(gopt.verbose)
+		printf("Creating Tracking\n");
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Tracking::~Tracking()
+{
+	if(gopt.verbose)
+		printf("Destructing Tracking\n");
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Tracking::Import()
+{
+	int32 lcv, n;
+
+	IncStartTic();
+
+	/* Drain every channel, the correlators only wait on this if it falls more than a dump behind */
+	n = 0;
+	if(gopt.loop_batch)
+		n = Batch();
+	else
+		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+			n += pChannels[lcv]->Service();
+
+	dumps += n;
+
+	IncStopTic();
+
+	if(n == 0)
+		usleep(LOOP_SLEEP);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Rounds of one dump from each channel that has one, until they are all empty. The dumps that
+ * close the loops are gathered into the bank and run through it together, the correlators
+ * all run off the same FIFO so a round is usually every channel dumping the same ms.
+ */
+int32 Tracking::Batch()
+{
+	int32 lcv, n, got;
+
+	n = 0;
+	do
+	{
+		bank.Clear();
+
+		got = 0;
+		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+			got += pChannels[lcv]->BatchIn(&bank);
+
+		if(bank.n)
+			bank.Run();
+
+		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+			pChannels[lcv]->BatchOut(&bank);
+
+		n += got;
+
+	} while(got);
+
+	return(n);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Tracking::Export()
+{
+
+}
+/*----------------------------------------------------------------------------------------------*/
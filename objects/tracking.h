@@ -0,0 +1,53 @@
+/*! \file Tracking.h
+	Defines the class Tracking
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef TRACKING_H_
+#define TRACKING_H_
+
+#include "includes.h"
+
+/*! \ingroup CLASSES
+ * With -loops the correlators only post their dumps, this thread runs Channel::Accum() on them
+ * (PLL/DLL, bit & frame sync, the ephemeris writes, the FFT pull-in) and posts the NCO feedback
+ * back. One thread serves all the channels through each channel's pair of SPSC queues. With
+ * -batch the PLL/DLL of every channel that dumps in a round are run together by a Loop_Bank.
+ */
+class Tracking : public Threaded_Object
+{
+
+	private:
+
+		uint32 dumps;		//!< Dumps processed
+		Loop_Bank bank;		//!< With -batch, the channels dumping this round
+
+	public:
+
+		Tracking();
+		~Tracking();
+		void Start();	//!< Start the thread
+		void Import();	//!< Service every channel's queue, sleep if they were all empty
+		int32 Batch();	//!< -batch version of the above, one dump per channel per round
+		void Export();	//!< Get data out of the thread
+
+};
+
+#endif /* TRACKING_H_ */
@@ -0,0 +1,407 @@
+/*! \file SIMD-Bench.cpp
+	Time the SIMD, FFT, and acquisition kernels across vector lengths, dump the results as JSON
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#define GLOBALS_HERE
+
+#include "includes.h"
+
+#define BENCH_MAX_VECT		(16384)		//!< Longest vector timed
+#define BENCH_MIN_TIME		(100)		//!< Default minimum time per batch (ms)
+#define BENCH_BATCHES		(3)			//!< Batches per kernel/length, the fastest is reported
+#define BENCH_DOPPLER		(10000)		//!< Acquisitions search +- this Doppler (Hz)
+
+/*! \ingroup STRUCTS
+ * Everything a kernel wrapper might need
+ */
+typedef struct _Bench_Args
+{
+	CPX *a;					//!< Input vector
+	CPX *b;					//!< Second input vector
+	CPX *c;					//!< Output vector
+	MIX *e;					//!< Early code (or the mix vector for cacc)
+	MIX *p;					//!< Prompt code
+	MIX *l;					//!< Late code
+	MIX *taps[9];			//!< Code taps for prn_accum_taps
+	CPX_ACCUM accum[9];		//!< Accumulations for prn_accum
+	int32 iaccum[2];		//!< Accumulations for cacc
+	int32 baccum[2];		//!< Accumulations for cacc
+	int32 index;			//!< Result of max
+	int32 mag;				//!< Result of max
+	int64 sum;				//!< Result of doiFFTpow
+	int32 cnt;				//!< Vector length
+	int32 sv;				//!< SV for the acquisition kernels
+	FFT *pFFT;				//!< FFT of length cnt
+	Acquisition *pAcq;		//!< Acquisition object, IF already prepped
+} Bench_Args;
+
+typedef void (*Bench_Kernel)(Bench_Args *_args);
+
+/*! \ingroup STRUCTS
+ * Describes one kernel
+ */
+typedef struct _Bench_Entry
+{
+	const char *name;		//!< Kernel name, as it appears in the JSON
+	Bench_Kernel kernel;	//!< Wrapper
+	int32 bytes;			//!< Bytes read + written per sample
+	int32 type;				//!< 0 = vector, 1 = FFT, 2 = acquisition
+	int32 ms;				//!< Acquisition only: ms of IF searched
+	int32 acq;				//!< Acquisition only: ACQ_STRONG, ACQ_MEDIUM, or ACQ_WEAK
+} Bench_Entry;
+
+/*! \ingroup STRUCTS
+ * Options for the benchmark
+ */
+typedef struct _Bench_Options
+{
+	int32 min_time;			//!< Minimum time per batch (ms)
+	int32 acq;				//!< Also run the acquisition kernels
+	char filter[256];		//!< Only run kernels whose name contains this string
+	char filename[1024];	//!< Write the JSON here instead of stdout
+} Bench_Options;
+
+/*----------------------------------------------------------------------------------------------*/
+void bench_sse_cmulsc(Bench_Args *_a)		{sse_cmulsc(_a->a, _a->b, _a->c, _a->cnt, 10);}
+void bench_x86_cmulsc(Bench_Args *_a)		{x86_cmulsc(_a->a, _a->b, _a->c, _a->cnt, 10);}
+void bench_sse_prn_accum_new(Bench_Args *_a){sse_prn_accum_new(_a->a, _a->e, _a->p, _a->l, _a->cnt, _a->accum);}
+void bench_x86_prn_accum_new(Bench_Args *_a){x86_prn_accum_new(_a->a, _a->e, _a->p, _a->l, _a->cnt, _a->accum);}
+void bench_x86_prn_accum_taps(Bench_Args *_a){x86_prn_accum_taps(_a->a, _a->taps, 9, _a->cnt, _a->accum);}
+void bench_x86_cmulsc_t(Bench_Args *_a)		{x86_cmulsc_t<10, 64>(_a->a, _a->b, _a->c, _a->cnt);}
+void bench_sse_corr(Bench_Args *_a)			{sse_cmulsc(_a->a, _a->b, _a->c, _a->cnt, 14); sse_prn_accum_new(_a->c, _a->e, _a->p, _a->l, _a->cnt, _a->accum);}
+void bench_x86_corr(Bench_Args *_a)			{x86_cmulsc(_a->a, _a->b, _a->c, _a->cnt, 14); x86_prn_accum_new(_a->c, _a->e, _a->p, _a->l, _a->cnt, _a->accum);}
+void bench_x86_corr_t(Bench_Args *_a)		{x86_corr_t<14, 3, 64>(_a->a, _a->b, _a->taps, _a->cnt, _a->accum);}
+void bench_sse_cacc(Bench_Args *_a)			{sse_cacc(_a->a, _a->e, _a->cnt, _a->iaccum, _a->baccum);}
+void bench_x86_cacc(Bench_Args *_a)			{x86_cacc(_a->a, _a->e, _a->cnt, _a->iaccum, _a->baccum);}
+void bench_x86_cmag(Bench_Args *_a)			{memcpy(_a->c, _a->a, _a->cnt*sizeof(CPX)); x86_cmag(_a->c, _a->cnt);}
+void bench_sse_max(Bench_Args *_a)			{sse_max((int32 *)_a->b, &_a->index, &_a->mag, _a->cnt);}
+void bench_x86_max(Bench_Args *_a)			{x86_max((int32 *)_a->b, &_a->index, &_a->mag, _a->cnt);}
+void bench_doFFT(Bench_Args *_a)			{_a->pFFT->doFFT(_a->c, true);}
+void bench_doiFFT(Bench_Args *_a)			{_a->pFFT->doiFFT(_a->c, true);}
+void bench_corr_chain(Bench_Args *_a)		{sse_cmulsc(_a->a, _a->b, _a->c, _a->cnt, 10); _a->pFFT->doiFFT(_a->c, true); x86_cmag(_a->c, _a->cnt); x86_max((int32 *)_a->c, &_a->index, &_a->mag, _a->cnt);}
+void bench_doiFFTpow(Bench_Args *_a)		{_a->pFFT->doiFFTpow(_a->a, _a->a + _a->cnt/2, _a->b, 10, _a->c, &_a->mag, &_a->sum);}
+void bench_doAcqStrong(Bench_Args *_a)		{_a->pAcq->doAcqStrong(_a->sv, -BENCH_DOPPLER, BENCH_DOPPLER);}
+void bench_doAcqMedium(Bench_Args *_a)		{_a->pAcq->doAcqMedium(_a->sv, -BENCH_DOPPLER, BENCH_DOPPLER);}
+void bench_doAcqWeak(Bench_Args *_a)		{_a->pAcq->doAcqWeak(_a->sv, -BENCH_DOPPLER, BENCH_DOPPLER);}
+/*----------------------------------------------------------------------------------------------*/
+
+/* x86_cmag includes the copy that restores its input, hence 16 bytes/sample */
+Bench_Entry bench_table[] = {
+	{"sse_cmulsc",			bench_sse_cmulsc,			3*sizeof(CPX),					0, 0, 0},
+	{"x86_cmulsc",			bench_x86_cmulsc,			3*sizeof(CPX),					0, 0, 0},
+	{"sse_prn_accum_new",	bench_sse_prn_accum_new,	sizeof(CPX) + 3*sizeof(MIX),	0, 0, 0},
+	{"x86_prn_accum_new",	bench_x86_prn_accum_new,	sizeof(CPX) + 3*sizeof(MIX),	0, 0, 0},
+	{"x86_prn_accum_taps9",	bench_x86_prn_accum_taps,	sizeof(CPX) + 9*sizeof(MIX),	0, 0, 0},
+	{"x86_cmulsc_t",		bench_x86_cmulsc_t,			3*sizeof(CPX),					0, 0, 0},
+	{"sse_corr",			bench_sse_corr,				2*sizeof(CPX) + 3*sizeof(MIX),	0, 0, 0},
+	{"x86_corr",			bench_x86_corr,				2*sizeof(CPX) + 3*sizeof(MIX),	0, 0, 0},
+	{"x86_corr_t",			bench_x86_corr_t,			2*sizeof(CPX) + 3*sizeof(MIX),	0, 0, 0},
+	{"sse_cacc",			bench_sse_cacc,				sizeof(CPX) + sizeof(MIX),		0, 0, 0},
+	{"x86_cacc",			bench_x86_cacc,				sizeof(CPX) + sizeof(MIX),		0, 0, 0},
+	{"x86_cmag",			bench_x86_cmag,				4*sizeof(CPX),					0, 0, 0},
+	{"sse_max",				bench_sse_max,				sizeof(int32),					0, 0, 0},
+	{"x86_max",				bench_x86_max,				sizeof(int32),					0, 0, 0},
+	{"doFFT",				bench_doFFT,				2*sizeof(CPX),					1, 0, 0},
+	{"doiFFT",				bench_doiFFT,				2*sizeof(CPX),					1, 0, 0},
+	{"corr_chain",			bench_corr_chain,			3*sizeof(CPX),					1, 0, 0},
+	{"doiFFTpow",			bench_doiFFTpow,			3*sizeof(CPX),					1, 0, 0},
+	{"doAcqStrong",			bench_doAcqStrong,			sizeof(CPX),					2, 1, ACQ_STRONG},
+	{"doAcqMedium",			bench_doAcqMedium,			sizeof(CPX),					2, 10, ACQ_MEDIUM},
+	{"doAcqWeak",			bench_doAcqWeak,			sizeof(CPX),					2, 310, ACQ_WEAK},
+};
+
+int32 bench_lengths[] = {256, 1024, 2048, 4096, 16384};
+
+#define BENCH_KERNELS	(int32)(sizeof(bench_table)/sizeof(Bench_Entry))
+#define BENCH_LENGTHS	(int32)(sizeof(bench_lengths)/sizeof(int32))
+
+FILE *fout;		//!< JSON goes here
+int32 nresults;	//!< Results written so far, for the commas
+
+/*----------------------------------------------------------------------------------------------*/
+void bench_usage(char *_str)
+{
+
+    fprintf(stderr, "usage: [-t] [-k] [-a] [-o]\n");
+    fprintf(stderr, "[-t] <ms> minimum time per batch (default %d)\n", BENCH_MIN_TIME);
+    fprintf(stderr, "[-k] <name> only run kernels whose name contains <name>\n");
+    fprintf(stderr, "[-a] skip the (slow) acquisition kernels\n");
+    fprintf(stderr, "[-o] <filename> write the JSON to a file instead of stdout\n");
+    fflush(stderr);
+
+    exit(1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void fill_cpx(CPX *_vect, int32 _samps, int32 _range)
+{
+	int32 lcv;
+
+	for(lcv = 0; lcv < _samps; lcv++)
+	{
+		_vect[lcv].i = (int16)((rand() % (2*_range)) - _range);
+		_vect[lcv].q = (int16)((rand() % (2*_range)) - _range);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void fill_mix(MIX *_vect, int32 _samps)
+{
+	int32 lcv;
+
+	for(lcv = 0; lcv < _samps; lcv++)
+	{
+		if(rand() & 0x1)
+			_vect[lcv].i = _vect[lcv].ni = 0x0001;
+		else
+			_vect[lcv].i = _vect[lcv].ni = 0xffff;
+
+		_vect[lcv].q =  _vect[lcv].nq = 0;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Google benchmark style: double the iteration count until a batch lasts at least
+ * _min_time ms, then run BENCH_BATCHES batches of that size and keep the fastest.
+ * Returns ns per call.
+ * */
+double bench_run(Bench_Kernel _kernel, Bench_Args *_args, int32 _min_time, int64 *_iterations)
+{
+	int64 iterations, lcv;
+	uint64 start, elapsed, best;
+	int32 batch;
+
+	/* Warm the caches and the branch predictors */
+	_kernel(_args);
+
+	iterations = 1;
+	while(1)
+	{
+		start = monotonic_ns();
+		for(lcv = 0; lcv < iterations; lcv++)
+			_kernel(_args);
+		elapsed = monotonic_ns() - start;
+
+		if(elapsed >= (uint64)_min_time*1000000)
+			break;
+
+		iterations *= 2;
+	}
+
+	best = elapsed;
+	for(batch = 1; batch < BENCH_BATCHES; batch++)
+	{
+		start = monotonic_ns();
+		for(lcv = 0; lcv < iterations; lcv++)
+			_kernel(_args);
+		elapsed = monotonic_ns() - start;
+
+		if(elapsed < best)
+			best = elapsed;
+	}
+
+	*_iterations = iterations;
+
+	return((double)best/(double)iterations);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void bench_json(Bench_Entry *_entry, int32 _samples, int64 _iterations, double _ns)
+{
+
+	if(nresults)
+		fprintf(fout, ",\n");
+
+	fprintf(fout, "    {\"name\": \"%s/%d\", \"kernel\": \"%s\", \"length\": %d, \"iterations\": %lld, "
+			"\"ns_per_call\": %.1f, \"ns_per_sample\": %.4f, \"gb_per_s\": %.4f}",
+			_entry->name, _samples, _entry->name, _samples, (long long)_iterations,
+			_ns, _ns/(double)_samples, (double)_entry->bytes*(double)_samples/_ns);
+	fflush(fout);
+
+	fprintf(stderr, "%-20s %8d %14.1f ns %10.4f ns/samp %8.3f GB/s\n", _entry->name, _samples,
+			_ns, _ns/(double)_samples, (double)_entry->bytes*(double)_samples/_ns);
+
+	nresults++;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int main(int32 argc, char* argv[])
+{
+
+	Bench_Options opt;
+	Bench_Args args;
+	Bench_Entry *entry;
+	CPX *if_buff;
+	int32 lcv, lcv2, type, samples;
+	int64 iterations;
+	double ns;
+	char host[256];
+
+	opt.min_time = BENCH_MIN_TIME;
+	opt.acq = true;
+	opt.filter[0] = '\0';
+	opt.filename[0] = '\0';
+
+	for(lcv = 1; lcv < argc; lcv++)
+	{
+		if(!strcmp(argv[lcv], "-t") && (lcv+1 < argc))
+			opt.min_time = atoi(argv[++lcv]);
+		else if(!strcmp(argv[lcv], "-k") && (lcv+1 < argc))
+			strncpy(opt.filter, argv[++lcv], 255);
+		else if(!strcmp(argv[lcv], "-a"))
+			opt.acq = false;
+		else if(!strcmp(argv[lcv], "-o") && (lcv+1 < argc))
+			strncpy(opt.filename, argv[++lcv], 1023);
+		else
+			bench_usage(argv[0]);
+	}
+
+	if(opt.min_time < 1)
+		opt.min_time = 1;
+
+	fout = stdout;
+	if(opt.filename[0])
+	{
+		fout = fopen(opt.filename, "wt");
+		if(fout == NULL)
+		{
+			printf("Could not open %s for writing\n", opt.filename);
+			return(-1);
+		}
+	}
+
+	Init_SIMD();
+	srand(1);
+
+	memset(&args, 0x0, sizeof(Bench_Args));
+	args.a = new CPX[BENCH_MAX_VECT];
+	args.b = new CPX[BENCH_MAX_VECT];
+	args.c = new CPX[BENCH_MAX_VECT];
+	args.e = new MIX[BENCH_MAX_VECT];
+	args.p = new MIX[BENCH_MAX_VECT];
+	args.l = new MIX[BENCH_MAX_VECT];
+
+	fill_cpx(args.a, BENCH_MAX_VECT, 16);
+	fill_cpx(args.b, BENCH_MAX_VECT, 8192);
+	fill_mix(args.e, BENCH_MAX_VECT);
+	fill_mix(args.p, BENCH_MAX_VECT);
+	fill_mix(args.l, BENCH_MAX_VECT);
+
+	for(lcv = 0; lcv < 9; lcv++)
+		args.taps[lcv] = (lcv % 3) == 0 ? args.e : ((lcv % 3) == 1 ? args.p : args.l);
+
+	if(gethostname(host, 255))
+		strcpy(host, "unknown");
+	host[255] = '\0';
+
+	fprintf(fout, "{\n");
+	fprintf(fout, "  \"context\": {\"host\": \"%s\", \"date\": %ld, \"sse2\": %d, \"sse3\": %d, \"ssse3\": %d, \"sse41\": %d, "
+			"\"min_time_ms\": %d, \"batches\": %d},\n", host, (long)time(NULL), CPU_SSE2(), CPU_SSE3(), CPU_SSSE3(),
+			CPU_SSE41(), opt.min_time, BENCH_BATCHES);
+	fprintf(fout, "  \"benchmarks\": [\n");
+
+	/* Vector kernels, then the FFTs */
+	for(type = 0; type < 2; type++)
+	{
+		for(lcv = 0; lcv < BENCH_KERNELS; lcv++)
+		{
+			entry = &bench_table[lcv];
+			if((entry->type != type) || (opt.filter[0] && !strstr(entry->name, opt.filter)))
+				continue;
+
+			for(lcv2 = 0; lcv2 < BENCH_LENGTHS; lcv2++)
+			{
+				args.cnt = bench_lengths[lcv2];
+
+				if(type == 1)
+				{
+					args.pFFT = new FFT(args.cnt);
+					fill_cpx(args.c, args.cnt, 16);
+				}
+
+				ns = bench_run(entry->kernel, &args, opt.min_time, &iterations);
+				bench_json(entry, args.cnt, iterations, ns);
+
+				if(type == 1)
+				{
+					delete args.pFFT;
+					args.pFFT = NULL;
+				}
+			}
+		}
+	}
+
+	/* Acquisition, length is the number of IF samples searched per SV */
+	if(opt.acq)
+	{
+		if_buff = new CPX[310*SAMPS_MS];
+		fill_cpx(if_buff, 310*SAMPS_MS, 16);
+
+		args.pAcq = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY, 0);
+		args.sv = 0;
+
+		for(lcv = 0; lcv < BENCH_KERNELS; lcv++)
+		{
+			entry = &bench_table[lcv];
+			if((entry->type != 2) || (opt.filter[0] && !strstr(entry->name, opt.filter)))
+				continue;
+
+			args.pAcq->doPrepIF(entry->acq, if_buff);
+			samples = entry->ms*SAMPS_MS;
+
+			ns = bench_run(entry->kernel, &args, opt.min_time, &iterations);
+			bench_json(entry, samples, iterations, ns);
+		}
+
+		delete args.pAcq;
+		delete [] if_buff;
+	}
+
+	fprintf(fout, "\n  ]\n}\n");
+
+	if(fout != stdout)
+		fclose(fout);
+
+	delete [] args.a;
+	delete [] args.b;
+	delete [] args.c;
+	delete [] args.e;
+	delete [] args.p;
+	delete [] args.l;
+
+	return(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
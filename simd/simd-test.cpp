@@ -549,6 +549,428 @@ int main(int32 argc, char* argv[])
 		printf("CPX PRN ACCUM NEW\t\tPASSED\n",err);
 	/*----------------------------------------------------------------------------------------------*/
 
+
+	/* x86_prn_accum_taps, 7 taps cycling through E/P/L */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX_ACCUM caccuma[7];
+		CPX_ACCUM caccumb[3];
+		MIX *codes[7];
+
+		pts = rand() % VECTSIZE;
+
+		fill_vect(testvecta, pts);
+
+		fill_prn_new(testvectf, pts);
+		fill_prn_new(testvectg, pts);
+		fill_prn_new(testvecth, pts);
+
+		for(lcv2 = 0; lcv2 < 7; lcv2++)
+			codes[lcv2] = (lcv2 % 3) == 0 ? testvectf : ((lcv2 % 3) == 1 ? testvectg : testvecth);
+
+		x86_prn_accum_taps(testvecta, codes, 7, pts, &caccuma[0]);
+		sse_prn_accum_new(testvecta, testvectf, testvectg, testvecth, pts, &caccumb[0]);
+
+		for(lcv2 = 0; lcv2 < 7; lcv2++)
+			if((caccuma[lcv2].i != caccumb[lcv2 % 3].i) || (caccuma[lcv2].q != caccumb[lcv2 % 3].q))
+				err++;
+
+	}
+	if(err)
+		printf("CPX PRN ACCUM TAPS \t\tFAILED: %d\n",err);
+	else
+		printf("CPX PRN ACCUM TAPS\t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* x86_pack_bits + x86_prn_accum_bits against x86_cmulsc + x86_prn_accum_new on the same data. The IF
+	is +-1 (1 bit) or +-1/+-3 (2 bit), the carrier +-2 so the shift of 1 is exact, and the IF, carrier &
+	codes start at different bits so the unaligned reads are covered too */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX_ACCUM caccuma[3];
+		CPX_ACCUM caccumb[3];
+		MIX *prn[3];
+		uint32 *codes[3];
+		int32 coff[3];
+		int32 doff, woff, mag, stride;
+		uint32 *dplanes, *wplanes, *cplanes;
+
+		stride = VECTSIZE/32 + 2;
+		dplanes = new uint32[4*stride];
+		wplanes = new uint32[4*stride];
+		cplanes = new uint32[3*4*stride];
+
+		pts = rand() % (VECTSIZE - 64);
+		mag = lcv & 0x1;
+		doff = rand() % 32;
+		woff = rand() % 32;
+
+		for(lcv2 = 0; lcv2 < pts + 64; lcv2++)
+		{
+			testvecta[lcv2].i = ((rand() & 0x1) ? 1 : -1)*((mag && (rand() & 0x1)) ? 3 : 1);
+			testvecta[lcv2].q = ((rand() & 0x1) ? 1 : -1)*((mag && (rand() & 0x1)) ? 3 : 1);
+			testvectb[lcv2].i = (rand() & 0x1) ? 2 : -2;
+			testvectb[lcv2].q = (rand() & 0x1) ? 2 : -2;
+		}
+
+		x86_pack_bits(testvecta, dplanes, stride, pts + 64, 2);
+		x86_pack_bits(testvectb, wplanes, stride, pts + 64, 0);
+
+		prn[0] = testvectf;	prn[1] = testvectg;	prn[2] = testvecth;
+		for(lcv2 = 0; lcv2 < 3; lcv2++)
+		{
+			fill_prn_new(prn[lcv2], pts + 64);
+			for(val1 = 0; val1 < pts + 64; val1++)
+			{
+				testvectd[val1].i = prn[lcv2][val1].i;
+				testvectd[val1].q = 0;
+			}
+			x86_pack_bits(testvectd, &cplanes[lcv2*4*stride], stride, pts + 64, 0);
+			codes[lcv2] = &cplanes[lcv2*4*stride];
+			coff[lcv2] = rand() % 32;
+		}
+
+		x86_prn_accum_bits(dplanes, stride, doff, wplanes, stride, woff, codes, coff, 3, pts, mag, &caccuma[0]);
+
+		x86_cmulsc(&testvecta[doff], &testvectb[woff], testvectc, pts, 1);
+		x86_prn_accum_new(testvectc, &testvectf[coff[0]], &testvectg[coff[1]], &testvecth[coff[2]], pts, &caccumb[0]);
+
+		for(lcv2 = 0; lcv2 < 3; lcv2++)
+			if((caccuma[lcv2].i != caccumb[lcv2].i) || (caccuma[lcv2].q != caccumb[lcv2].q))
+				err++;
+
+		delete [] dplanes;
+		delete [] wplanes;
+		delete [] cplanes;
+
+	}
+	if(err)
+		printf("CPX PRN ACCUM BITS \t\tFAILED: %d\n",err);
+	else
+		printf("CPX PRN ACCUM BITS\t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* x86_cmulsc_t, odd lengths leave a partial block */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		pts = rand() % VECTSIZE;
+
+		fill_vect(testvecta, pts);
+		fill_vect(testvectb, pts);
+
+		x86_cmulsc(testvecta, testvectb, testvectc, pts, 10);
+		x86_cmulsc_t<10, 64>(testvecta, testvectb, testvectd, pts);
+
+		for(lcv2 = 0; lcv2 < pts; lcv2++)
+			if((testvectc[lcv2].i != testvectd[lcv2].i) || (testvectc[lcv2].q != testvectd[lcv2].q))
+				err++;
+
+	}
+	if(err)
+		printf("CPX MUL SHIFT TEMPLATE \t\tFAILED: %d\n",err);
+	else
+		printf("CPX MUL SHIFT TEMPLATE \t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* x86_corr_t against the wipeoff followed by the E/P/L and 7 tap accumulations */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX_ACCUM caccuma[7];
+		CPX_ACCUM caccumb[7];
+		MIX *codes[7];
+
+		pts = rand() % VECTSIZE;
+
+		/* Full scale carrier, as in the wipeoff tables */
+		fill_vect(testvecta, pts);
+		for(lcv2 = 0; lcv2 < pts; lcv2++)
+		{
+			testvectb[lcv2].i = (int16)((rand() % 32768) - 16384);
+			testvectb[lcv2].q = (int16)((rand() % 32768) - 16384);
+		}
+
+		fill_prn_new(testvectf, pts);
+		fill_prn_new(testvectg, pts);
+		fill_prn_new(testvecth, pts);
+
+		for(lcv2 = 0; lcv2 < 7; lcv2++)
+			codes[lcv2] = (lcv2 % 3) == 0 ? testvectf : ((lcv2 % 3) == 1 ? testvectg : testvecth);
+
+		x86_cmulsc(testvecta, testvectb, testvectc, pts, 14);
+
+		x86_prn_accum_new(testvectc, testvectf, testvectg, testvecth, pts, &caccumb[0]);
+		x86_corr_t<14, 3, 64>(testvecta, testvectb, codes, pts, &caccuma[0]);
+
+		for(lcv2 = 0; lcv2 < 3; lcv2++)
+			if((caccuma[lcv2].i != caccumb[lcv2].i) || (caccuma[lcv2].q != caccumb[lcv2].q))
+				err++;
+
+		x86_prn_accum_taps(testvectc, codes, 7, pts, &caccumb[0]);
+		x86_corr_t<14, 7, 64>(testvecta, testvectb, codes, pts, &caccuma[0]);
+
+		for(lcv2 = 0; lcv2 < 7; lcv2++)
+			if((caccuma[lcv2].i != caccumb[lcv2].i) || (caccuma[lcv2].q != caccumb[lcv2].q))
+				err++;
+
+	}
+	if(err)
+		printf("CPX CORR TEMPLATE \t\tFAILED: %d\n",err);
+	else
+		printf("CPX CORR TEMPLATE \t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* sse_max, small values so there are ties */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		int32 *pow = (int32 *)testvecta;
+
+		pts = rand() % VECTSIZE;
+
+		for(lcv2 = 0; lcv2 < pts; lcv2++)
+			pow[lcv2] = rand() % 1000;
+
+		x86_max(pow, &ai1, &aq1, pts);
+		sse_max(pow, &ai2, &aq2, pts);
+
+		if((ai1 != ai2) || (aq1 != aq2))
+			err++;
+
+	}
+	if(err)
+		printf("INT32 MAX \t\t\tFAILED: %d\n",err);
+	else
+		printf("INT32 MAX \t\t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* x86_peaks against picking each peak with a full scan, 4 peaks 4 samples apart in rows of 2048 */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		int32 *pow = (int32 *)testvecta;
+		int32 index[4], mag[4], rindex[4], rmag[4];
+		int32 bmax[VECTSIZE/PEAK_BLOCK + 1];
+		int32 lcv3, d;
+		int64 sum, rsum;
+
+		pts = rand() % VECTSIZE;
+
+		rsum = 0;
+		for(lcv2 = 0; lcv2 < pts; lcv2++)
+		{
+			pow[lcv2] = rand() % 1000;
+			rsum += pow[lcv2];
+		}
+
+		/* A couple of wide peaks, they must not come back twice */
+		for(lcv2 = 0; (lcv2 < 2) && pts; lcv2++)
+		{
+			val1 = rand() % pts;
+			for(lcv3 = val1; (lcv3 < val1 + 3) && (lcv3 < pts); lcv3++)
+			{
+				rsum -= pow[lcv3];
+				pow[lcv3] = 5000 - (lcv3 - val1);
+				rsum += pow[lcv3];
+			}
+		}
+
+		for(lcv2 = 0; lcv2 < 4; lcv2++)
+		{
+			rindex[lcv2] = rmag[lcv2] = 0;
+			for(lcv3 = 0; lcv3 < pts; lcv3++)
+			{
+				if(pow[lcv3] <= rmag[lcv2])
+					continue;
+
+				for(val1 = 0; val1 < lcv2; val1++)
+				{
+					d = abs((lcv3 % 2048) - (rindex[val1] % 2048));
+					if((d <= 4) || ((2048 - d) <= 4))
+						break;
+				}
+
+				if(val1 == lcv2)
+				{
+					rindex[lcv2] = lcv3;
+					rmag[lcv2] = pow[lcv3];
+				}
+			}
+		}
+
+		x86_peaks(pow, pts, 2048, 4, 4, index, mag, &sum, bmax);
+
+		if(sum != rsum)
+			err++;
+
+		for(lcv2 = 0; lcv2 < 4; lcv2++)
+			if((index[lcv2] != rindex[lcv2]) || (mag[lcv2] != rmag[lcv2]))
+				err++;
+
+	}
+	if(err)
+		printf("INT32 PEAKS \t\t\tFAILED: %d\n",err);
+	else
+		printf("INT32 PEAKS \t\t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* doiFFTmul & doiFFTpow against the multiply, iFFT, power and max done one after the other */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		int32 *pow = (int32 *)testvectc;
+		int32 ranks[MAX_RANKS];
+		int32 sizes[4] = {1024, 2048, 4000, 750};
+		int32 n, gap, max, rmax;
+		int64 sum, rsum;
+
+		/* Radix 2 and mixed, 750 has a single 2 so its powers take their own pass. The high half
+		of the bins is gap samples above the low half */
+		n = sizes[rand() % 4];
+		gap = rand() % (VECTSIZE - 2*n);
+
+		for(lcv2 = 0; lcv2 < MAX_RANKS; lcv2++)
+			ranks[lcv2] = rand() & 0x1;
+
+		FFT aFFT(n, ranks);
+
+		fill_vect(testvecta, VECTSIZE);
+		for(lcv2 = 0; lcv2 < n; lcv2++)
+		{
+			testvectb[lcv2].i = (int16)((rand() % 8192) - 4096);
+			testvectb[lcv2].q = (int16)((rand() % 8192) - 4096);
+		}
+
+		memcpy(testvecte, testvecta, n/2*sizeof(CPX));
+		memcpy(testvecte + n/2, testvecta + n/2 + gap, n/2*sizeof(CPX));
+
+		x86_cmulsc(testvecte, testvectb, testvectd, n, 8);
+		aFFT.doiFFT(testvectd, true);
+
+		aFFT.doiFFTmul(testvecta, testvecta + n/2 + gap, testvectb, 8, testvectc);
+
+		for(lcv2 = 0; lcv2 < n; lcv2++)
+			if((testvectc[lcv2].i != testvectd[lcv2].i) || (testvectc[lcv2].q != testvectd[lcv2].q))
+				err++;
+
+		x86_cmag(testvectd, n);
+		x86_max((int32 *)testvectd, &ai1, &rmax, n);
+		rsum = 0;
+		for(lcv2 = 0; lcv2 < n; lcv2++)
+			rsum += ((int32 *)testvectd)[lcv2];
+
+		aFFT.doiFFTpow(testvecta, testvecta + n/2 + gap, testvectb, 8, testvectc, &max, &sum);
+
+		for(lcv2 = 0; lcv2 < n; lcv2++)
+			if(pow[lcv2] != ((int32 *)testvectd)[lcv2])
+				err++;
+
+		if((max != rmax) || (sum != rsum))
+			err++;
+
+	}
+	if(err)
+		printf("FFT CORR FUSED \t\t\tFAILED: %d\n",err);
+	else
+		printf("FFT CORR FUSED \t\t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* Mixed radix FFT & iFFT against a double precision DFT/N, every rank scaled. The radix 2 FFT
+	of 2048 points is off by up to ~8 LSB and 1.5 rms, the mixed radix ones must do as well */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < 8; lcv++)
+	{
+
+		int32 ranks[MAX_RANKS];
+		int32 sizes[4] = {1000, 1536, 4000, 5000};
+		int32 n, inv, k;
+		double ti, tq, ph, e, emax, erms;
+
+		n = sizes[lcv/2];
+		inv = lcv & 0x1;
+
+		for(lcv2 = 0; lcv2 < MAX_RANKS; lcv2++)
+			ranks[lcv2] = 1;
+
+		FFT aFFT(n, ranks);
+
+		for(lcv2 = 0; lcv2 < n; lcv2++)
+		{
+			testvecta[lcv2].i = (int16)((rand() % 16384) - 8192);
+			testvecta[lcv2].q = (int16)((rand() % 16384) - 8192);
+		}
+
+		memcpy(testvectc, testvecta, n*sizeof(CPX));
+
+		if(inv)
+			aFFT.doiFFT(testvectc, true);
+		else
+			aFFT.doFFT(testvectc, true);
+
+		emax = erms = 0;
+		for(k = 0; k < n; k++)
+		{
+			ti = tq = 0;
+			for(lcv2 = 0; lcv2 < n; lcv2++)
+			{
+				ph = (inv ? 2.0 : -2.0)*PI*(double)(((int64)k*lcv2) % n)/(double)n;
+				ti += testvecta[lcv2].i*cos(ph) - testvecta[lcv2].q*sin(ph);
+				tq += testvecta[lcv2].i*sin(ph) + testvecta[lcv2].q*cos(ph);
+			}
+
+			e = hypot(ti/n - testvectc[k].i, tq/n - testvectc[k].q);
+			emax = (e > emax) ? e : emax;
+			erms += e*e;
+		}
+
+		if((emax > 10.0) || (sqrt(erms/n) > 2.0))
+			err++;
+
+	}
+
+	/* And the lengths it must turn down, other primes (4092 = 4*3*11*31), odd, too many ranks */
+	if(!FFT::Length(4000) || !FFT::Length(2048) || FFT::Length(4092) || FFT::Length(16368) || FFT::Length(1125) || FFT::Length(1 << 17))
+		err++;
+
+	if(err)
+		printf("FFT MIXED RADIX \t\tFAILED: %d\n",err);
+	else
+		printf("FFT MIXED RADIX \t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
 	delete [] testvecta;
 	delete [] testvectb;
 	delete [] testvectc;
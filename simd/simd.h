@@ -78,7 +78,12 @@ void  x86_cmulsc(CPX *A, CPX *B, CPX *C, int32 cnt, int32 shift);			//!< Pointwi
 void  x86_cmag(CPX *A, int32 cnt);											//!< Convert from complex to a power
 void  x86_prn_accum(CPX *A, CPX *E, CPX *P, CPX *L, int32 cnt, CPX *accum);  //!< This is a long story
 void  x86_prn_accum_new(CPX *A, MIX *E, MIX *P, MIX *L, int32 cnt, CPX_ACCUM *accum);  //!< This is a long story
+void  x86_prn_accum_taps(CPX *A, MIX **codes, int32 taps, int32 cnt, CPX_ACCUM *accum);	//!< Same as above for any number of taps, four per pass
+void  x86_pack_bits(CPX *A, uint32 *planes, int32 stride, int32 cnt, int32 thresh);	//!< Pack CPX into sign & magnitude bit-planes
+void  x86_prn_accum_bits(uint32 *data, int32 dstride, int32 doff, uint32 *wipe, int32 wstride, int32 woff,
+						 uint32 **codes, int32 *coff, int32 taps, int32 cnt, int32 mag, CPX_ACCUM *accum);	//!< Wipeoff & E/P/L on bit-planes with XOR/popcount
 void  x86_max(int32 *_A, int32 *_index, int32 *_magt, int32 _cnt);
+void  x86_peaks(int32 *_A, int32 _cnt, int32 _row, int32 _exclude, int32 _k, int32 *_index, int32 *_mag, int64 *_sum, int32 *_bmax);	//!< Top _k peaks apart in code phase, and the total
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -1030,6 +1030,19 @@ void sse_prn_accum_new(CPX *A, MIX *E, MIX *P, MIX *L, int32 cnt, CPX_ACCUM *acc
 }
 
 
+/*!
+ * sse_max: Same result as x86_max(), through the block maxima of x86_peaks() which the compiler
+ * vectorizes, SSE2 has no packed 32 bit max to write it with.
+ * */
+void sse_max(int32 *_A, int32 *_index, int32 *_magt, int32 _cnt)
+{
 
+	int32 bmax[PEAK_MAX_BLOCKS];
+	int64 sum;
 
+	if(_cnt > PEAK_MAX_BLOCKS*PEAK_BLOCK)
+		x86_max(_A, _index, _magt, _cnt);
+	else
+		x86_peaks(_A, _cnt, _cnt, 0, 1, _index, _magt, &sum, bmax);
 
+}
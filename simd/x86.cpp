@@ -294,6 +294,130 @@ void x86_max(int32 *_A, int32 *_index, int32 *_magt, int32 _cnt)
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Does any of the first _n peaks have a code phase (index modulo _row) within _exclude samples
+ * of _index's, the rows wrap around.
+ */
+static inline bool peak_near(int32 _index, int32 *_peaks, int32 _n, int32 _row, int32 _exclude)
+{
+
+	int32 lcv, d;
+
+	for(lcv = 0; lcv < _n; lcv++)
+	{
+		d = abs((_index % _row) - (_peaks[lcv] % _row));
+		if((d <= _exclude) || ((_row - d) <= _exclude))
+			return(true);
+	}
+
+	return(false);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * x86_peaks: The _k largest powers of _A whose code phases are more than _exclude samples apart,
+ * _A holding rows of _row samples (one per Doppler bin). Peaks come back largest first, a
+ * power of 0 if there are not that many. Ties go to the lowest index, as x86_max() does. _sum
+ * gets the total of _A, for a noise estimate.
+ *
+ * One pass takes the max & the sum of each PEAK_BLOCK samples, that inner loop has no branch so
+ * -ftree-vectorize runs it four samples per SSE instruction. The peaks are then picked from the
+ * block maxima. The blocks around each pick are rescanned leaving out what it excludes, so only
+ * a few blocks per row are touched again. The block maxima go in _bmax, which the caller sizes once
+ * for (_cnt + PEAK_BLOCK - 1)/PEAK_BLOCK of them.
+ * */
+void x86_peaks(int32 *_A, int32 _cnt, int32 _row, int32 _exclude, int32 _k, int32 *_index, int32 *_mag, int64 *_sum, int32 *_bmax)
+{
+
+	int32 lcv, lcv2, b, nb, full, m, best, pick, rows, row, d, s;
+	int32 *p;
+	int64 sum;
+
+	full = _cnt / PEAK_BLOCK;
+	nb = (_cnt + PEAK_BLOCK - 1) / PEAK_BLOCK;
+
+	/* Block maxima and the total */
+	sum = 0;
+	for(b = 0; b < full; b++)
+	{
+		p = &_A[b*PEAK_BLOCK];
+		m = 0;
+		for(lcv = 0; lcv < PEAK_BLOCK; lcv++)
+		{
+			m = (p[lcv] > m) ? p[lcv] : m;
+			sum += p[lcv];
+		}
+		_bmax[b] = m;
+	}
+
+	if(nb > full)
+	{
+		m = 0;
+		for(lcv = full*PEAK_BLOCK; lcv < _cnt; lcv++)
+		{
+			m = (_A[lcv] > m) ? _A[lcv] : m;
+			sum += _A[lcv];
+		}
+		_bmax[full] = m;
+	}
+
+	*_sum = sum;
+
+	rows = (_cnt + _row - 1) / _row;
+
+	for(lcv = 0; lcv < _k; lcv++)
+	{
+		/* Largest block left */
+		best = 0;
+		pick = -1;
+		for(b = 0; b < nb; b++)
+			if(_bmax[b] > best)
+			{
+				best = _bmax[b];
+				pick = b;
+			}
+
+		if(pick == -1)
+		{
+			_index[lcv] = 0;
+			_mag[lcv] = 0;
+			continue;
+		}
+
+		/* The first sample of the block that is not excluded and holds its max */
+		for(s = pick*PEAK_BLOCK; (_A[s] != best) || peak_near(s, _index, lcv, _row, _exclude); s++);
+
+		_index[lcv] = s;
+		_mag[lcv] = best;
+
+		if(lcv == _k - 1)
+			break;
+
+		/* Rescan the blocks around its code phase in every row, without the excluded samples */
+		for(row = 0; row < rows; row++)
+			for(d = -_exclude; d <= _exclude; d++)
+			{
+				s = row*_row + ((_index[lcv] % _row) + d + _row) % _row;
+				if(s >= _cnt)
+					continue;
+
+				b = s / PEAK_BLOCK;
+				m = 0;
+				for(lcv2 = b*PEAK_BLOCK; (lcv2 < (b+1)*PEAK_BLOCK) && (lcv2 < _cnt); lcv2++)
+					if((_A[lcv2] > m) && !peak_near(lcv2, _index, lcv+1, _row, _exclude))
+						m = _A[lcv2];
+				_bmax[b] = m;
+			}
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void x86_prn_accum(CPX *A, CPX *E, CPX *P, CPX *L, int32 cnt, CPX *accum)  //!< This is a long story
 {
@@ -387,6 +511,196 @@ void x86_prn_accum_new(CPX *A, MIX *E, MIX *P, MIX *L, int32 cnt, CPX_ACCUM *acc
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Correlate the wiped off samples against any number of code taps. Taps are done four at a time,
+ * each sample is loaded once per group and applied to all four codes with the sums kept in registers,
+ * rather than doing a separate dot product per tap. The samples stay in cache between groups.
+ * */
+void x86_prn_accum_taps(CPX *A, MIX **codes, int32 taps, int32 cnt, CPX_ACCUM *accum)
+{
+
+	int32 lcv, lcv2;
+	int32 ai, aq;
+	int32 i0, q0, i1, q1, i2, q2, i3, q3;
+	MIX *c0, *c1, *c2, *c3;
+
+	for(lcv2 = 0; lcv2 + 4 <= taps; lcv2 += 4)
+	{
+		c0 = codes[lcv2];	c1 = codes[lcv2+1];
+		c2 = codes[lcv2+2];	c3 = codes[lcv2+3];
+
+		i0 = q0 = i1 = q1 = i2 = q2 = i3 = q3 = 0;
+
+		for(lcv = 0; lcv < cnt; lcv++)
+		{
+			ai = A[lcv].i;
+			aq = A[lcv].q;
+			i0 += ai*c0[lcv].i;		q0 += aq*c0[lcv].ni;
+			i1 += ai*c1[lcv].i;		q1 += aq*c1[lcv].ni;
+			i2 += ai*c2[lcv].i;		q2 += aq*c2[lcv].ni;
+			i3 += ai*c3[lcv].i;		q3 += aq*c3[lcv].ni;
+		}
+
+		accum[lcv2].i = i0;		accum[lcv2].q = q0;
+		accum[lcv2+1].i = i1;	accum[lcv2+1].q = q1;
+		accum[lcv2+2].i = i2;	accum[lcv2+2].q = q2;
+		accum[lcv2+3].i = i3;	accum[lcv2+3].q = q3;
+	}
+
+	/* Leftover taps */
+	for(; lcv2 < taps; lcv2++)
+	{
+		c0 = codes[lcv2];
+		i0 = q0 = 0;
+
+		for(lcv = 0; lcv < cnt; lcv++)
+		{
+			i0 += A[lcv].i*c0[lcv].i;
+			q0 += A[lcv].q*c0[lcv].ni;
+		}
+
+		accum[lcv2].i = i0;
+		accum[lcv2].q = q0;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Get 32 bits of a bit-plane starting at bit _pos, the plane needs a guard word at the end */
+static inline uint32 x86_bits(uint32 *_p, int32 _pos)
+{
+
+	int32 word, shift;
+
+	word = _pos >> 5;
+	shift = _pos & 31;
+
+	if(shift)
+		return((_p[word] >> shift) | (_p[word+1] << (32 - shift)));
+	else
+		return(_p[word]);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Pack CPX samples into 4 bit-planes, _stride words apart: I sign, Q sign, |I| > _thresh, |Q| > _thresh.
+ * Sample n is bit (n & 31) of word (n >> 5). The word after the last one is zeroed as a guard.
+ * */
+void x86_pack_bits(CPX *A, uint32 *planes, int32 stride, int32 cnt, int32 thresh)
+{
+
+	int32 lcv, lcv2, words, n;
+	uint32 is, qs, im, qm, bit;
+	CPX *a;
+
+	words = (cnt + 31) >> 5;
+
+	for(lcv = 0; lcv < words; lcv++)
+	{
+		a = &A[lcv << 5];
+		n = cnt - (lcv << 5);
+		if(n > 32) n = 32;
+
+		is = qs = im = qm = 0;
+		for(lcv2 = 0; lcv2 < n; lcv2++)
+		{
+			bit = 1 << lcv2;
+			if(a[lcv2].i < 0)		is |= bit;
+			if(a[lcv2].q < 0)		qs |= bit;
+			if(abs(a[lcv2].i) > thresh)	im |= bit;
+			if(abs(a[lcv2].q) > thresh)	qm |= bit;
+		}
+
+		planes[lcv] = is;
+		planes[lcv + stride] = qs;
+		planes[lcv + 2*stride] = im;
+		planes[lcv + 3*stride] = qm;
+	}
+
+	planes[words] = planes[words + stride] = planes[words + 2*stride] = planes[words + 3*stride] = 0;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * E/P/L (and any other taps) on bit-planes with XOR & popcount, 32 samples at a time. data holds the
+ * I sign, Q sign, I mag, Q mag planes of the IF (dstride words apart, starting at bit doff), wipe the cos
+ * & sin sign planes of the carrier (wstride apart, from bit woff), codes[k] the code sign plane of tap k
+ * (from bit coff[k]). A sign bit of 1 is -1. With mag the IF samples weigh 3 where their magnitude bit is set,
+ * otherwise everything is +-1, the carrier always is. Same sign conventions as x86_cmulsc + x86_prn_accum_new.
+ * */
+void x86_prn_accum_bits(uint32 *data, int32 dstride, int32 doff, uint32 *wipe, int32 wstride, int32 woff,
+						uint32 **codes, int32 *coff, int32 taps, int32 cnt, int32 mag, CPX_ACCUM *accum)
+{
+
+	int32 lcv, lcv2, n, n2;
+	uint32 is, qs, im, qm, c, s, mask, code;
+	uint32 re0, re1, im0, im1, a, b;
+
+	for(lcv2 = 0; lcv2 < taps; lcv2++)
+	{
+		accum[lcv2].i = 0;
+		accum[lcv2].q = 0;
+	}
+
+	im = qm = 0;
+
+	for(lcv = 0; lcv < cnt; lcv += 32)
+	{
+		n = cnt - lcv;
+		if(n > 32) n = 32;
+		mask = (n == 32) ? 0xffffffff : ((1 << n) - 1);
+		n2 = 2*n;
+
+		is = x86_bits(data, doff + lcv);
+		qs = x86_bits(data + dstride, doff + lcv);
+		c = x86_bits(wipe, woff + lcv);
+		s = x86_bits(wipe + wstride, woff + lcv);
+
+		/* Wipeoff, (I + jQ)(c + js): real = Ic - Qs, imag = Is + Qc */
+		re0 = is ^ c;
+		re1 = ~(qs ^ s);
+		im0 = is ^ s;
+		im1 = qs ^ c;
+
+		if(mag)
+		{
+			im = x86_bits(data + 2*dstride, doff + lcv) & mask;
+			qm = x86_bits(data + 3*dstride, doff + lcv) & mask;
+			n2 += 2*(__builtin_popcount(im) + __builtin_popcount(qm));
+		}
+
+		/* Each tap, sum of +-1 (or +-3) is n - 2*(number of -1s) */
+		for(lcv2 = 0; lcv2 < taps; lcv2++)
+		{
+			code = x86_bits(codes[lcv2], coff[lcv2] + lcv);
+
+			a = (re0 ^ code) & mask;
+			b = (re1 ^ code) & mask;
+			accum[lcv2].i += n2 - 2*(__builtin_popcount(a) + __builtin_popcount(b));
+			if(mag)
+				accum[lcv2].i -= 4*(__builtin_popcount(a & im) + __builtin_popcount(b & qm));
+
+			a = (im0 ^ code) & mask;
+			b = (im1 ^ code) & mask;
+			accum[lcv2].q += n2 - 2*(__builtin_popcount(a) + __builtin_popcount(b));
+			if(mag)
+				accum[lcv2].q -= 4*(__builtin_popcount(a & im) + __builtin_popcount(b & qm));
+		}
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 //int32 x86_acc(int16 *_A, int32 _cnt)
 //{
 //
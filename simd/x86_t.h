@@ -0,0 +1,164 @@
+/*! \file x86_t.h
+	Compile time specialized versions of the x86 kernels. The shift, the number of taps and the
+	block length are template arguments, so the rounding constant and shifts fold away and the tap
+	loop and the block loop have fixed trip counts the compiler can unroll. A count that is not a
+	multiple of the block (segments cut at a code rollover) finishes with the same body run over the
+	leftover samples. Results are bit exact with the generic x86_ kernels.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef X86_T_H_
+#define X86_T_H_
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Pointwise complex multiply with shift of _cnt samples, dump results into C (x86_cmulsc) */
+template<int32 SHIFT>
+static inline void x86_cmulsc_n(CPX * __restrict__ _A, CPX * __restrict__ _B, CPX * __restrict__ _C, int32 _cnt)
+{
+
+	int32 lcv;
+	int32 ti, tq;
+
+	for(lcv = 0; lcv < _cnt; lcv++)
+	{
+		ti = _A[lcv].i*_B[lcv].i - _A[lcv].q*_B[lcv].q;
+		tq = _A[lcv].i*_B[lcv].q + _A[lcv].q*_B[lcv].i;
+
+		_C[lcv].i = (int16)((ti + (1 << (SHIFT-1))) >> SHIFT);
+		_C[lcv].q = (int16)((tq + (1 << (SHIFT-1))) >> SHIFT);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! x86_cmulsc in whole blocks of BLOCK samples, then the leftover */
+template<int32 SHIFT, int32 BLOCK>
+void x86_cmulsc_t(CPX *_A, CPX *_B, CPX *_C, int32 _cnt)
+{
+
+	int32 lcv, blocks;
+
+	blocks = _cnt / BLOCK;
+
+	for(lcv = 0; lcv < blocks; lcv++)
+		x86_cmulsc_n<SHIFT>(&_A[lcv*BLOCK], &_B[lcv*BLOCK], &_C[lcv*BLOCK], BLOCK);
+
+	x86_cmulsc_n<SHIFT>(&_A[blocks*BLOCK], &_B[blocks*BLOCK], &_C[blocks*BLOCK], _cnt - blocks*BLOCK);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Wipe off the carrier for BLOCK samples into I & Q vectors, rounded to int16 exactly as x86_cmulsc does */
+template<int32 SHIFT, int32 BLOCK>
+static inline void x86_wipe_n(CPX *_A, CPX *_B, int16 *_I, int16 *_Q, int32 _cnt)
+{
+
+	int32 lcv;
+	int32 ti, tq;
+
+	for(lcv = 0; lcv < _cnt; lcv++)
+	{
+		ti = _A[lcv].i*_B[lcv].i - _A[lcv].q*_B[lcv].q;
+		tq = _A[lcv].i*_B[lcv].q + _A[lcv].q*_B[lcv].i;
+
+		_I[lcv] = (int16)((ti + (1 << (SHIFT-1))) >> SHIFT);
+		_Q[lcv] = (int16)((tq + (1 << (SHIFT-1))) >> SHIFT);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Correlate _cnt wiped off samples against one code */
+static inline void x86_dot_n(int16 *_I, int16 *_Q, MIX *_code, int32 _cnt, int32 *_accum)
+{
+
+	int32 lcv;
+	int32 ai, aq;
+
+	ai = aq = 0;
+
+	for(lcv = 0; lcv < _cnt; lcv++)
+	{
+		ai += _I[lcv]*_code[lcv].i;
+		aq += _Q[lcv]*_code[lcv].ni;
+	}
+
+	_accum[0] += ai;
+	_accum[1] += aq;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * x86_cmulsc followed by x86_prn_accum_new (TAPS = 3) or x86_prn_accum_taps, a block of BLOCK
+ * samples at a time. Each block is wiped off into a small I/Q buffer that stays in L1 and is then
+ * run against every tap, instead of writing the whole scratch vector out and reading it back.
+ * */
+template<int32 SHIFT, int32 TAPS, int32 BLOCK>
+void x86_corr_t(CPX *_A, CPX *_B, MIX **_codes, int32 _cnt, CPX_ACCUM *_accum)
+{
+
+	int16 I[BLOCK], Q[BLOCK];
+	int32 accum[2*TAPS];
+	int32 lcv, lcv2, blocks, left;
+
+	for(lcv2 = 0; lcv2 < TAPS; lcv2++)
+		accum[2*lcv2] = accum[2*lcv2+1] = 0;
+
+	blocks = _cnt / BLOCK;
+
+	for(lcv = 0; lcv < blocks*BLOCK; lcv += BLOCK)
+	{
+		x86_wipe_n<SHIFT, BLOCK>(&_A[lcv], &_B[lcv], I, Q, BLOCK);
+
+		for(lcv2 = 0; lcv2 < TAPS; lcv2++)
+			x86_dot_n(I, Q, &_codes[lcv2][lcv], BLOCK, &accum[2*lcv2]);
+	}
+
+	/* Leftover at the rollover */
+	left = _cnt - blocks*BLOCK;
+	if(left)
+	{
+		x86_wipe_n<SHIFT, BLOCK>(&_A[lcv], &_B[lcv], I, Q, left);
+
+		for(lcv2 = 0; lcv2 < TAPS; lcv2++)
+			x86_dot_n(I, Q, &_codes[lcv2][lcv], left, &accum[2*lcv2]);
+	}
+
+	for(lcv2 = 0; lcv2 < TAPS; lcv2++)
+	{
+		_accum[lcv2].i = accum[2*lcv2];
+		_accum[lcv2].q = accum[2*lcv2+1];
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+#endif /*X86_T_H_*/